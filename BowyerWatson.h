@@ -0,0 +1,390 @@
+#pragma once
+#include "SpatialSort.h"
+#include "VertexMerging.h"
+#include "ConflictKernel.h"
+#include "RunStatistics.h"
+#include "Progress.h"
+#include "Predicates.h"
+#include "ElementPool.h"
+
+namespace delaunay {
+
+	/// \brief Type of the coordinates that the Bowyer-Watson engines store. Float halves the memory
+	/// that the walks and the predicates read, and it loses nothing on the vertices of a 3ds Max
+	/// Mesh, which are float already. It is chosen by defining DELAUNAY_FLOAT_VERTICES.
+#ifdef DELAUNAY_FLOAT_VERTICES
+	using VertexScalar = float;
+#else
+	using VertexScalar = double;
+#endif
+
+	/// \brief Coordinates of the vertices of a triangulation, stored in the given type. The vertices
+	/// are returned in double precision, so the predicates stay exact on the stored values.
+	template<typename Scalar>
+	class VertexStore {
+		/// The coordinates, three for each vertex.
+		std::vector<Scalar> m_coordinates = std::vector<Scalar>();
+
+	public:
+		/// \brief Returns the point rounded the same way as a stored vertex. The coordinates are 
+		/// narrowed through memory, as the vectorizer of GCC 12 drops a narrowing that is directly
+		/// widened again.
+		static Eigen::Vector3d round(const Eigen::Vector3d & point) {
+			volatile Scalar coordinates[3] = { Scalar(point.x()), Scalar(point.y()), Scalar(point.z()) };
+			return Eigen::Vector3d(double(coordinates[0]), double(coordinates[1]), double(coordinates[2]));
+		}
+
+		/// Number of the stored vertices.
+		size_t size() const { return m_coordinates.size() / 3; }
+
+		/// Changes the number of the stored vertices.
+		void resize(size_t count) { m_coordinates.resize(3 * count); }
+
+		/// Reserves memory for the given number of vertices.
+		void reserve(size_t count) { m_coordinates.reserve(3 * count); }
+
+		/// Appends the vertex.
+		void push_back(const Eigen::Vector3d & vertex) {
+			m_coordinates.push_back(Scalar(vertex.x()));
+			m_coordinates.push_back(Scalar(vertex.y()));
+			m_coordinates.push_back(Scalar(vertex.z()));
+		}
+
+		/// Replaces the vertex with given index.
+		void set(size_t index, const Eigen::Vector3d & vertex) {
+			m_coordinates[3 * index] = Scalar(vertex.x());
+			m_coordinates[3 * index + 1] = Scalar(vertex.y());
+			m_coordinates[3 * index + 2] = Scalar(vertex.z());
+		}
+
+		/// Returns the vertex with given index.
+		Eigen::Vector3d operator[](size_t index) const {
+			const Scalar * coordinates = &m_coordinates[3 * index];
+			return Eigen::Vector3d(double(coordinates[0]), double(coordinates[1]), double(coordinates[2]));
+		}
+	};
+
+	/// \brief Common core of the Bowyer-Watson engines in the given dimension (2 or 3), with the
+	/// vertex coordinates stored in the given type.
+	///
+	/// A simplex (a triangle or a tetrahedron) has Dim + 1 vertices. Its i-th neighbor shares the
+	/// facet opposite to its i-th vertex and the simplex is positively oriented, so a point lies
+	/// on the inner side of the facet when it keeps the orientation positive in place of the
+	/// vertex. The dimension-specific operations are chosen by tag dispatch on the dimension, so
+	/// the loops over the vertices have fixed trip counts.
+	///
+	/// The insertion is shared through findCavity() and replaceSimplices(). The simplex types of
+	/// the engines provide the flag of a bad simplex (isBad(), setBad()), the constrained facets
+	/// that the cavities do not cross (isConstrained()) and the exact predicates on a point 
+	/// (containsInCircumsphere(), seesFacet()), which take the engine as their context.
+	template<size_t Dim, typename Scalar>
+	class BowyerWatson {
+	public:
+		/// Number of the vertices (and of the neighbors) of a simplex.
+		static const size_t SIMPLEX_SIZE = Dim + 1;
+		/// Number of the bounding vertices, the corners of the box around the input vertices.
+		static const size_t BOUNDING_VERTEX_COUNT = size_t(1) << Dim;
+		/// Value of a neighbor index that signalizes there is no neighbor across the facet.
+		static const size_t NO_NEIGHBOR = size_t(-1);
+		/// Number of the vertices inserted between two reports of the progress.
+		static const size_t PROGRESS_INTERVAL = 1024;
+
+		/// Returns the times of the phases of the last invocation.
+		const PhaseTimes & phaseTimes() const { return m_phaseTimes; }
+
+		/// \brief Sets the distance within which the input vertices are merged before they are 
+		/// inserted. Only the first vertex of each group is inserted, the others are kept in the
+		/// result as isolated vertices. A zero distance disables the merging.
+		void setMergeDistance(double distance) { m_mergeDistance = distance; }
+
+		/// \brief Returns the input index of the vertex that each vertex of the last appended input
+		/// was merged into (its own index when it was not merged). It is empty when the merging is
+		/// disabled.
+		const std::vector<size_t> & mergeRemap() const { return m_mergeRemap; }
+
+		/// \brief Sets the receiver of the progress of the insertions, which can cancel them by
+		/// Cancelled thrown out of the invocation. Null (the default) reports nothing.
+		void setProgress(IProgress * progress) { m_progress = progress; }
+
+	protected:
+		/// Tag of the dimension, which selects the overload of the dimension-specific operations.
+		using Dimension = std::integral_constant<size_t, Dim>;
+		/// Vertices of a simplex.
+		using SimplexPoints = std::array<Eigen::Vector3d, SIMPLEX_SIZE>;
+
+		/// The order in which the input vertices are inserted.
+		InsertionOrder m_insertionOrder;
+		/// The bounding vertices followed by the inserted ones.
+		VertexStore<Scalar> m_vertices = VertexStore<Scalar>();
+		/// Index of the input vertex of each inserted vertex (the bounding vertices are not counted).
+		std::vector<size_t> m_inputIndices = std::vector<size_t>();
+		/// \brief Cached circumscribed spheres (circles in 2D) of the simplices, indexed the same way
+		/// as the simplices. They serve as a fast filter before the exact predicates.
+		CircumsphereStore m_circumSpheres = CircumsphereStore();
+		/// Index of the last created simplex. The point location starts walking from it.
+		size_t m_lastSimplex = 0;
+		/// Counter that varies the order in which the walk examines the facets of a simplex.
+		size_t m_walkRotation = 0;
+		/// The times of the phases of the last invocation.
+		PhaseTimes m_phaseTimes = PhaseTimes();
+		/// Counters of the insertions since the last triangulation started.
+		InsertionCounters m_counters = InsertionCounters();
+		/// Indices of the simplices created by the last insertion.
+		std::vector<size_t> m_newIndices = std::vector<size_t>();
+		/// \brief When set, the indices of the released and the allocated simplices are appended to
+		/// it by each insertion and removal.
+		std::vector<size_t> * m_changedSlots = nullptr;
+		/// \brief When set, an insertion at the position of a vertex of the triangulation appends
+		/// the input indices of that vertex and of the inserted one to it. The inserted vertex 
+		/// takes the place of the other one, which is left out of the triangulation.
+		std::vector<size_t> * m_replacedDuplicates = nullptr;
+		/// Distance within which the input vertices are merged, zero disables the merging.
+		double m_mergeDistance = 0.0;
+		/// The input vertex that each vertex of the last appended input was merged into.
+		std::vector<size_t> m_mergeRemap = std::vector<size_t>();
+		/// The receiver of the progress, or null.
+		IProgress * m_progress = nullptr;
+
+		explicit BowyerWatson(InsertionOrder insertionOrder)
+			: m_insertionOrder(insertionOrder)
+		{ }
+
+		/// \brief Forgets the vertices and the cached spheres of the previous invocation, so that
+		/// the engine can be invoked again. The memory is kept for the next invocation.
+		void clearVertices() {
+			m_vertices.resize(0);
+			m_inputIndices.clear();
+			m_circumSpheres.resize(0);
+			m_mergeRemap.clear();
+			m_lastSimplex = 0;
+			m_walkRotation = 0;
+		}
+
+		/// Returns the index of the input vertex that was inserted with the given index.
+		size_t inputIndex(size_t vertexIndex) const { return m_inputIndices[vertexIndex - BOUNDING_VERTEX_COUNT]; }
+
+		/// \brief Appends the input vertices sorted into the insertion order, numbering them from
+		/// the given input index. The merged vertices are appended after the others, so they keep
+		/// their input indices but are not inserted. Returns the range of the vertices to insert.
+		std::pair<size_t, size_t> appendSorted(const std::vector<Eigen::Vector3d> & inputVertices, size_t firstInputIndex) {
+			size_t firstVertexIndex = m_vertices.size();
+			if (firstVertexIndex + inputVertices.size() > CompactIndex::MAX_INDEX)
+				throw std::length_error("Too many vertices for the 32-bit indices.");
+
+			std::vector<size_t> order;
+			order.reserve(inputVertices.size());
+			m_mergeRemap.clear();
+			if (m_mergeDistance > 0.0) {
+				m_mergeRemap = mergeNearbyVertices(inputVertices, m_mergeDistance, Dim);
+				for (size_t i = 0; i < inputVertices.size(); ++i) {
+					if (m_mergeRemap[i] == i)
+						order.push_back(i);
+				}
+			}
+			else {
+				order.resize(inputVertices.size());
+				std::iota(order.begin(), order.end(), size_t(0));
+			}
+
+			size_t insertedCount = order.size();
+			sortIndicesForInsertion(inputVertices, order.begin(), order.end(), m_insertionOrder, Dim);
+			for (size_t i = 0; i < m_mergeRemap.size(); ++i) {
+				if (m_mergeRemap[i] != i)
+					order.push_back(i);
+				m_mergeRemap[i] += firstInputIndex;
+			}
+
+			// No exact reserve here, as it would copy all the stored vertices on each insertion of
+			// a few more. The triangulations reserve the memory once, before the bounding elements.
+			for (size_t index : order) {
+				m_inputIndices.push_back(firstInputIndex + index);
+				m_vertices.push_back(inputVertices[index]);
+			}
+
+			return std::make_pair(firstVertexIndex, firstVertexIndex + insertedCount);
+		}
+
+		/// \brief Reports that the given fraction of the vertices is inserted. Throws Cancelled when
+		/// the progress cancels the triangulation.
+		void reportProgress(double fraction) {
+			if (m_progress != nullptr && m_progress->update(fraction))
+				throw Cancelled();
+		}
+
+		/// \brief Inserts the vertices in range [begin, end) by the given function. The progress is
+		/// reported after each block of PROGRESS_INTERVAL vertices, so the loop over a block has
+		/// no extra work.
+		template<typename Insert>
+		void insertRange(size_t begin, size_t end, Insert insert) {
+			for (size_t blockBegin = begin; blockBegin < end; blockBegin += PROGRESS_INTERVAL) {
+				size_t blockEnd = std::min(end, blockBegin + PROGRESS_INTERVAL);
+				for (size_t iVertex = blockBegin; iVertex < blockEnd; ++iVertex)
+					insert(iVertex);
+
+				reportProgress(double(blockEnd - begin) / double(end - begin));
+			}
+		}
+
+		/// \brief Reports the vertex of the simplex that lies at the position of the inserted vertex
+		/// to m_replacedDuplicates (when it is set). The simplex must contain the inserted vertex.
+		template<typename Simplex>
+		void reportReplacedDuplicate(const Simplex & simplex, size_t vertexIndex) {
+			if (m_replacedDuplicates == nullptr)
+				return;
+
+			const Eigen::Vector3d point = m_vertices[vertexIndex];
+			for (size_t vertex : simplex.m_v) {
+				if (vertex >= BOUNDING_VERTEX_COUNT && m_vertices[vertex].template head<Dim>() == point.template head<Dim>()) {
+					m_replacedDuplicates->push_back(inputIndex(vertex));
+					m_replacedDuplicates->push_back(inputIndex(vertexIndex));
+				}
+			}
+		}
+
+		/// \brief Collects the cavity of the point: the simplices whose circumspheres contain it. The
+		/// simplex that contains the point is always bad, the rest of the cavity forms a connected
+		/// region around it, so it is found by flood-fill over the neighbors. A simplex is also 
+		/// cut out when the point does not see its facet from the inside, as the cavity must be
+		/// star-shaped with respect to the point. (This can happen due to rounding errors.) All 
+		/// the unvisited neighbors of a bad simplex are tested at once by the SIMD kernel.
+		///
+		/// The bad simplices are flagged and appended to the cavity. The visit function is called
+		/// for each neighbor of a bad simplex before it is tested, and when it returns false, the
+		/// search stops and false is returned (the simplices found so far stay flagged).
+		template<typename Engine, typename Pool, typename Visit>
+		bool findCavity(Engine & engine, Pool & simplices, size_t startIndex, const Eigen::Vector3d & point, InsertionCounters & counters, std::vector<size_t> & cavity, Visit visit) {
+			simplices[startIndex].setBad(true);
+			cavity.push_back(startIndex);
+
+			for (size_t iBad = 0; iBad < cavity.size(); ++iBad) {
+				auto & simplex = simplices[cavity[iBad]];
+
+				std::array<size_t, SIMPLEX_SIZE> candidates;
+				std::array<size_t, SIMPLEX_SIZE> candidateFacets;
+				size_t candidateCount = 0;
+				for (size_t facet = 0; facet < SIMPLEX_SIZE; ++facet) {
+					size_t neighborIndex = simplex.m_neighbors[facet];
+					if (neighborIndex == NO_NEIGHBOR)
+						continue;
+
+					if (!visit(neighborIndex))
+						return false;
+
+					if (simplices[neighborIndex].isBad() || simplex.isConstrained(facet))
+						continue;
+
+					candidates[candidateCount] = neighborIndex;
+					candidateFacets[candidateCount] = facet;
+					++candidateCount;
+				}
+
+				std::array<Conflict, SIMPLEX_SIZE> conflicts;
+				testConflicts(m_circumSpheres, candidates.data(), candidateCount, point, conflicts.data());
+				counters.countConflictTests(candidateCount);
+
+				for (size_t iCandidate = 0; iCandidate < candidateCount; ++iCandidate) {
+					auto & neighbor = simplices[candidates[iCandidate]];
+
+					bool inConflict = (conflicts[iCandidate] == Conflict::INSIDE)
+						|| (conflicts[iCandidate] == Conflict::UNCERTAIN && neighbor.containsInCircumsphere(engine, point));
+
+					if (inConflict || !simplex.seesFacet(engine, candidateFacets[iCandidate], point)) {
+						neighbor.setBad(true);
+						cavity.push_back(candidates[iCandidate]);
+					}
+				}
+			}
+
+			return true;
+		}
+
+		/// \brief Releases the slots of the bad simplices and stores the new ones, which reuse the
+		/// slots first. Their indices are returned in the given vector.
+		template<typename Pool, typename Simplex>
+		void replaceSimplices(Pool & simplices, const std::vector<size_t> & badIndices, const std::vector<Simplex> & newSimplices, std::vector<size_t> & newIndices) {
+			for (size_t badIndex : badIndices)
+				simplices.release(badIndex);
+
+			newIndices.clear();
+			for (const Simplex & newSimplex : newSimplices)
+				newIndices.push_back(simplices.allocate(newSimplex));
+
+			if (m_changedSlots != nullptr) {
+				m_changedSlots->insert(m_changedSlots->end(), badIndices.begin(), badIndices.end());
+				m_changedSlots->insert(m_changedSlots->end(), newIndices.begin(), newIndices.end());
+			}
+		}
+
+		/// Returns the orientation of the triangle, positive when it is counter-clockwise.
+		static double orientation(const std::array<Eigen::Vector3d, 3> & points, std::integral_constant<size_t, 2>) {
+			return orient2d(
+				Eigen::Vector2d(points[0].x(), points[0].y()),
+				Eigen::Vector2d(points[1].x(), points[1].y()),
+				Eigen::Vector2d(points[2].x(), points[2].y()));
+		}
+
+		/// Returns the orientation of the tetrahedron, positive when it is positively oriented.
+		static double orientation(const std::array<Eigen::Vector3d, 4> & points, std::integral_constant<size_t, 3>) {
+			return orient3d(points[0], points[1], points[2], points[3]);
+		}
+
+		/// \brief Visibility walk from the given simplex to the one that contains the point. In each
+		/// step the walk crosses a facet that separates the current simplex from the point. The
+		/// order in which the facets are examined is varied, so that the walk can not get stuck in a
+		/// cycle on degenerate configurations. The flag is set when the walk ends at a facet without
+		/// a neighbor, which the point lies behind.
+		template<typename Pool>
+		size_t walk(const Pool & simplices, size_t start, const Eigen::Vector3d & point, bool & isBlocked) {
+			size_t current = start;
+			size_t previous = NO_NEIGHBOR;
+
+			bool found = false;
+			while (!found) {
+				const auto & simplex = simplices[current];
+				SimplexPoints points;
+				for (size_t j = 0; j < SIMPLEX_SIZE; ++j)
+					points[j] = m_vertices[simplex.m_v[j]];
+
+				size_t rotation = m_walkRotation++;
+				found = true;
+				isBlocked = false;
+				for (size_t i = 0; i < SIMPLEX_SIZE; ++i) {
+					size_t facet = (rotation + i) % SIMPLEX_SIZE;
+					size_t neighbor = simplex.m_neighbors[facet];
+
+					if (neighbor != NO_NEIGHBOR && neighbor == previous)
+						continue;
+
+					SimplexPoints replaced = points;
+					replaced[facet] = point;
+					if (orientation(replaced, Dimension()) < 0.0) {
+						if (neighbor == NO_NEIGHBOR) {
+							isBlocked = true;
+							continue;
+						}
+
+						previous = current;
+						current = neighbor;
+						found = false;
+						break;
+					}
+				}
+			}
+
+			return current;
+		}
+	};
+
+	template<size_t Dim, typename Scalar>
+	const size_t BowyerWatson<Dim, Scalar>::SIMPLEX_SIZE;
+
+	template<size_t Dim, typename Scalar>
+	const size_t BowyerWatson<Dim, Scalar>::BOUNDING_VERTEX_COUNT;
+
+	template<size_t Dim, typename Scalar>
+	const size_t BowyerWatson<Dim, Scalar>::NO_NEIGHBOR;
+
+	template<size_t Dim, typename Scalar>
+	const size_t BowyerWatson<Dim, Scalar>::PROGRESS_INTERVAL;
+
+}
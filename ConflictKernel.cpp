@@ -0,0 +1,285 @@
+#include "stdafx.h"
+#include "ConflictKernel.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define DELAUNAY_X64
+#include <immintrin.h>		// SSE2, AVX2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>			// __cpuid, _xgetbv
+#endif
+
+// Functions using AVX2 are compiled for it even when the rest of the file is not. They are only
+// called when the processor supports it.
+#if defined(__GNUC__)
+#define DELAUNAY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DELAUNAY_TARGET_AVX2
+#endif
+
+using Eigen::Vector3d;
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	// The computed value R^2 - |p - c|^2 differs from the exact one by at most
+	//		2 * e * (|p - c| + 2R + e) + rounding errors of the evaluation,
+	// where e bounds the error of the computed center c. (Moving the center by e changes the
+	// power of the point by 2 * (p - v).e, where v is any vertex of the element.) The constants
+	// below bound it with a safe margin.
+	static const double CENTER_ERROR_SCALE = 2.5;
+	static const double ROUNDING_ERROR_SCALE = 16.0 * std::numeric_limits<double>::epsilon();
+
+	using KernelFunction = void(*)(const CircumsphereStore &, const size_t *, size_t, size_t, const Vector3d &, Conflict *);
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	// CIRCUMSPHERE STORE
+	// ==================
+
+	void CircumsphereStore::resize(size_t count)
+	{
+		m_centerX.resize(count);
+		m_centerY.resize(count);
+		m_centerZ.resize(count);
+		m_radiusSquared.resize(count);
+		m_centerError.resize(count);
+		m_reach.resize(count);
+	}
+
+	void CircumsphereStore::reserve(size_t count)
+	{
+		m_centerX.reserve(count);
+		m_centerY.reserve(count);
+		m_centerZ.reserve(count);
+		m_radiusSquared.reserve(count);
+		m_centerError.reserve(count);
+		m_reach.reserve(count);
+	}
+
+	void CircumsphereStore::set(size_t index, const Vector3d & center, double radiusSquared, double centerError)
+	{
+		m_centerX[index] = center.x();
+		m_centerY[index] = center.y();
+		m_centerZ[index] = center.z();
+		m_radiusSquared[index] = radiusSquared;
+		m_centerError[index] = centerError;
+		m_reach[index] = 2.0 * std::sqrt(radiusSquared) + centerError;
+	}
+
+	Vector3d CircumsphereStore::getCenter(size_t index) const
+	{
+		return Vector3d(m_centerX[index], m_centerY[index], m_centerZ[index]);
+	}
+
+
+	// SCALAR KERNEL
+	// =============
+
+	inline static Conflict testConflict(const CircumsphereStore & store, size_t i, const Vector3d & point)
+	{
+		double dx = point.x() - store.m_centerX[i];
+		double dy = point.y() - store.m_centerY[i];
+		double dz = point.z() - store.m_centerZ[i];
+		double distanceSquared = dx * dx + dy * dy + dz * dz;
+		double power = store.m_radiusSquared[i] - distanceSquared;
+
+		double margin = CENTER_ERROR_SCALE * store.m_centerError[i] * (std::sqrt(distanceSquared) + store.m_reach[i])
+			+ ROUNDING_ERROR_SCALE * (store.m_radiusSquared[i] + distanceSquared);
+
+		// Comparisons with NaN (degenerate elements) are false, so these end up uncertain.
+		if (power > margin)
+			return Conflict::INSIDE;
+		if (power < -margin)
+			return Conflict::OUTSIDE;
+		return Conflict::UNCERTAIN;
+	}
+
+	/// \brief Tests the spheres with given indices, or the range starting at <begin> when the
+	/// indices are null.
+	static void testConflictsScalar(const CircumsphereStore & store, const size_t * indices, size_t begin, size_t count, const Vector3d & point, Conflict * mask)
+	{
+		for (size_t k = 0; k < count; ++k)
+			mask[k] = testConflict(store, indices ? indices[k] : begin + k, point);
+	}
+
+	/// Converts the comparison bit masks of SIMD lanes into conflict results.
+	inline static void writeMask(int insideBits, int outsideBits, size_t lanes, Conflict * mask)
+	{
+		for (size_t lane = 0; lane < lanes; ++lane) {
+			if (insideBits & (1 << lane))
+				mask[lane] = Conflict::INSIDE;
+			else if (outsideBits & (1 << lane))
+				mask[lane] = Conflict::OUTSIDE;
+			else
+				mask[lane] = Conflict::UNCERTAIN;
+		}
+	}
+
+#ifdef DELAUNAY_X64
+
+	// SSE2 KERNEL
+	// ===========
+
+	/// Loads two consecutive or indexed values into a register.
+	inline static __m128d load2(const std::vector<double> & data, const size_t * indices, size_t begin)
+	{
+		if (indices)
+			return _mm_set_pd(data[indices[1]], data[indices[0]]);
+		return _mm_loadu_pd(&data[begin]);
+	}
+
+	static void testConflictsSSE2(const CircumsphereStore & store, const size_t * indices, size_t begin, size_t count, const Vector3d & point, Conflict * mask)
+	{
+		const __m128d px = _mm_set1_pd(point.x());
+		const __m128d py = _mm_set1_pd(point.y());
+		const __m128d pz = _mm_set1_pd(point.z());
+		const __m128d centerErrorScale = _mm_set1_pd(CENTER_ERROR_SCALE);
+		const __m128d roundingErrorScale = _mm_set1_pd(ROUNDING_ERROR_SCALE);
+		const __m128d signMask = _mm_set1_pd(-0.0);
+
+		size_t k = 0;
+		for (; k + 2 <= count; k += 2) {
+			const size_t * laneIndices = indices ? indices + k : nullptr;
+
+			__m128d dx = _mm_sub_pd(px, load2(store.m_centerX, laneIndices, begin + k));
+			__m128d dy = _mm_sub_pd(py, load2(store.m_centerY, laneIndices, begin + k));
+			__m128d dz = _mm_sub_pd(pz, load2(store.m_centerZ, laneIndices, begin + k));
+			__m128d distanceSquared = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+
+			__m128d radiusSquared = load2(store.m_radiusSquared, laneIndices, begin + k);
+			__m128d power = _mm_sub_pd(radiusSquared, distanceSquared);
+
+			__m128d reach = _mm_add_pd(_mm_sqrt_pd(distanceSquared), load2(store.m_reach, laneIndices, begin + k));
+			__m128d margin = _mm_add_pd(
+				_mm_mul_pd(_mm_mul_pd(centerErrorScale, load2(store.m_centerError, laneIndices, begin + k)), reach),
+				_mm_mul_pd(roundingErrorScale, _mm_add_pd(radiusSquared, distanceSquared)));
+
+			int insideBits = _mm_movemask_pd(_mm_cmpgt_pd(power, margin));
+			int outsideBits = _mm_movemask_pd(_mm_cmplt_pd(power, _mm_xor_pd(margin, signMask)));
+			writeMask(insideBits, outsideBits, 2, mask + k);
+		}
+
+		testConflictsScalar(store, indices ? indices + k : nullptr, begin + k, count - k, point, mask + k);
+	}
+
+
+	// AVX2 KERNEL
+	// ===========
+
+	/// Loads four consecutive or indexed values into a register.
+	DELAUNAY_TARGET_AVX2
+	inline static __m256d load4(const std::vector<double> & data, const size_t * indices, size_t begin)
+	{
+		if (indices) {
+			__m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices));
+			return _mm256_i64gather_pd(data.data(), offsets, 8);
+		}
+		return _mm256_loadu_pd(&data[begin]);
+	}
+
+	DELAUNAY_TARGET_AVX2
+	static void testConflictsAVX2(const CircumsphereStore & store, const size_t * indices, size_t begin, size_t count, const Vector3d & point, Conflict * mask)
+	{
+		const __m256d px = _mm256_set1_pd(point.x());
+		const __m256d py = _mm256_set1_pd(point.y());
+		const __m256d pz = _mm256_set1_pd(point.z());
+		const __m256d centerErrorScale = _mm256_set1_pd(CENTER_ERROR_SCALE);
+		const __m256d roundingErrorScale = _mm256_set1_pd(ROUNDING_ERROR_SCALE);
+		const __m256d signMask = _mm256_set1_pd(-0.0);
+
+		size_t k = 0;
+		for (; k + 4 <= count; k += 4) {
+			const size_t * laneIndices = indices ? indices + k : nullptr;
+
+			__m256d dx = _mm256_sub_pd(px, load4(store.m_centerX, laneIndices, begin + k));
+			__m256d dy = _mm256_sub_pd(py, load4(store.m_centerY, laneIndices, begin + k));
+			__m256d dz = _mm256_sub_pd(pz, load4(store.m_centerZ, laneIndices, begin + k));
+			__m256d distanceSquared = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+
+			__m256d radiusSquared = load4(store.m_radiusSquared, laneIndices, begin + k);
+			__m256d power = _mm256_sub_pd(radiusSquared, distanceSquared);
+
+			__m256d reach = _mm256_add_pd(_mm256_sqrt_pd(distanceSquared), load4(store.m_reach, laneIndices, begin + k));
+			__m256d margin = _mm256_add_pd(
+				_mm256_mul_pd(_mm256_mul_pd(centerErrorScale, load4(store.m_centerError, laneIndices, begin + k)), reach),
+				_mm256_mul_pd(roundingErrorScale, _mm256_add_pd(radiusSquared, distanceSquared)));
+
+			int insideBits = _mm256_movemask_pd(_mm256_cmp_pd(power, margin, _CMP_GT_OQ));
+			int outsideBits = _mm256_movemask_pd(_mm256_cmp_pd(power, _mm256_xor_pd(margin, signMask), _CMP_LT_OQ));
+			writeMask(insideBits, outsideBits, 4, mask + k);
+		}
+
+		// The remaining lanes are handled by the narrower kernel.
+		testConflictsSSE2(store, indices ? indices + k : nullptr, begin + k, count - k, point, mask + k);
+	}
+
+	/// Tells if the processor and the operating system support AVX2.
+	static bool supportsAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// The OS must save the YMM registers on context switches.
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#else
+		return false;
+#endif
+	}
+
+#endif	// DELAUNAY_X64
+
+
+	// DISPATCH
+	// ========
+
+	/// Selects the widest kernel supported by the processor.
+	static KernelFunction selectKernel()
+	{
+#ifdef DELAUNAY_X64
+		if (supportsAVX2())
+			return testConflictsAVX2;
+		return testConflictsSSE2;	// SSE2 is always present on x64
+#else
+		return testConflictsScalar;
+#endif
+	}
+
+	/// The kernel is selected once, on the first use.
+	static KernelFunction kernel()
+	{
+		static const KernelFunction selected = selectKernel();
+		return selected;
+	}
+
+	void testConflicts(const CircumsphereStore & store, const size_t * indices, size_t count, const Vector3d & point, Conflict * mask)
+	{
+		kernel()(store, indices, 0, count, point, mask);
+	}
+
+	void testConflicts(const CircumsphereStore & store, size_t begin, size_t end, const Vector3d & point, Conflict * mask)
+	{
+		kernel()(store, nullptr, begin, end - begin, point, mask);
+	}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+namespace delaunay {
+
+	/// Result of the fast conflict test of a point against one element.
+	enum class Conflict : unsigned char {
+		OUTSIDE = 0,	///< The point surely lies outside of the circumscribed sphere.
+		INSIDE = 1,		///< The point surely lies inside of the circumscribed sphere.
+		UNCERTAIN = 2	///< The rounding errors do not allow to decide, an exact test is needed.
+	};
+
+	/// \brief Cached circumscribed spheres (circles in 2D, with z = 0) of the elements of a
+	/// triangulation, stored as structure of arrays so that they can be tested in SIMD registers.
+	///
+	/// Besides the center and the squared radius, each sphere keeps a bound on the error of its
+	/// computed center. The conflict test uses it to tell when its result can not be trusted.
+	class CircumsphereStore {
+	public:
+		std::vector<double> m_centerX;			///< X-coordinates of the centers.
+		std::vector<double> m_centerY;			///< Y-coordinates of the centers.
+		std::vector<double> m_centerZ;			///< Z-coordinates of the centers.
+		std::vector<double> m_radiusSquared;	///< Squared radii.
+		std::vector<double> m_centerError;		///< Bounds on the distance of the computed centers from the exact ones.
+		std::vector<double> m_reach;			///< Twice the radius plus the center error, used by the error bound.
+
+		/// Number of stored spheres.
+		size_t size() const { return m_centerX.size(); }
+
+		/// Changes the number of stored spheres.
+		void resize(size_t count);
+
+		/// Reserves memory for the given number of spheres.
+		void reserve(size_t count);
+
+		/// \brief Stores the sphere of the element with given index.
+		void set(size_t index, const Eigen::Vector3d & center, double radiusSquared, double centerError);
+
+		/// Returns the center of the sphere with given index.
+		Eigen::Vector3d getCenter(size_t index) const;
+	};
+
+	/// \brief Tests the point against the spheres with given indices and writes the results into
+	/// the mask. Uses AVX2 or SSE2 when the processor supports it.
+	void testConflicts(
+		const CircumsphereStore & store,
+		const size_t * indices,
+		size_t count,
+		const Eigen::Vector3d & point,
+		Conflict * mask);
+
+	/// \brief Tests the point against the spheres in the index range [begin, end) and writes the
+	/// results into the mask. Uses AVX2 or SSE2 when the processor supports it.
+	void testConflicts(
+		const CircumsphereStore & store,
+		size_t begin,
+		size_t end,
+		const Eigen::Vector3d & point,
+		Conflict * mask);
+
+}
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Delaunay2D.h"
 #include "Common.h"
+#include "Predicates.h"
 
 using Eigen::Vector3d;
 using Eigen::Vector2d;
@@ -28,6 +29,11 @@ namespace delaunay {
 	// IMPLEMENTATION
 	// =============================================================================
 
+	const size_t IDelaunay2D::NO_TRIANGLE;
+	const double BowyerWatson2D::MAX_MIN_ANGLE = 33.0;
+	const double BowyerWatson2D::MIN_EDGE_ULPS = 16.0;
+	const unsigned BowyerWatson2D::Triangle::BAD_FLAG;
+
 	// OVERLOADED OPERATORS
 	// ====================
 
@@ -63,83 +69,37 @@ namespace delaunay {
 			std::swap(m_v0, m_v1);
 	}
 
-	BowyerWatson2D::Triangle BowyerWatson2D::Edge::formTriangle(BowyerWatson2D & ctx, size_t vertex)
-	{
-		return Triangle(ctx, m_v0, m_v1, vertex);
-	}
-
 
 	// BOWYER WATSON TRIANGLE IMPLEMENTATION
 	// =====================================
 
-	BowyerWatson2D::Triangle::Triangle(BowyerWatson2D & ctx, size_t v0, size_t v1, size_t v2)
-		: m_v0(v0), m_v1(v1), m_v2(v2)
-	{
-		const Vector2d vec0 = toVector2d(ctx.m_vertices[v0]);
-		const Vector2d vec1 = toVector2d(ctx.m_vertices[v1]);
-		const Vector2d vec2 = toVector2d(ctx.m_vertices[v2]);
-
-		// To find the parameters of the circumscribed cirle of the triangle we solve system of 
-		// two linear equations with two unknowns.
-		// These equations are buit this way: 
-		//		For each point [x,y] on the circle with center [X,Y] and radius R
-		//		(x-X)^2 + (y-Y)^2 = R^2
-		//
-		//		Each triangle vertex forms a quadratic equation with unknowns X, Y, R.
-		//		(x0-X)^2 + (y0-Y)^2 = R^2
-		//		(x1-X)^2 + (y1-Y)^2 = R^2
-		//		(x2-X)^2 + (y2-Y)^2 = R^2
-		//		
-		//		By subtracting the first equation from the other we get rid of the degree-2 power.
-		//		And we get two linear equations.
-		//		X * 2(x0 - x1) + Y * 2(y0 - y1) = (x0^2 + y0^2) - (x1^2 + y1^2)
-		//		X * 2(x0 - x2) + Y * 2(y0 - y2) = (x0^2 + y0^2) - (x2^2 + y2^2)
-		//
-		//		This can be solved by the standard linear algebra methods.
-
-		Matrix2d matrix;
-		matrix.row(0) = 2.0 * (vec0 - vec1);
-		matrix.row(1) = 2.0 * (vec0 - vec2);
-
-		Vector2d rhs;
-		rhs(0) = squareSum(vec0) - squareSum(vec1);
-		rhs(1) = squareSum(vec0) - squareSum(vec2);
-
-		Vector2d circumCenter = matrix.fullPivLu().solve(rhs);
-		Vector2d vec0d = vec0 - circumCenter;
-		double circumRadiusSquared = squareSum(vec0d);
-
-		m_circumCenter = circumCenter;
-		m_circumRadiusSquared = circumRadiusSquared;
-	}
-
-	vector<BowyerWatson2D::Edge> BowyerWatson2D::Triangle::getEdges(BowyerWatson2D & ctx)
-	{
-		vector<BowyerWatson2D::Edge> result;
-		result.push_back(Edge(ctx, m_v0, m_v1));
-		result.push_back(Edge(ctx, m_v1, m_v2));
-		result.push_back(Edge(ctx, m_v2, m_v0));
-		return result;
-	}
+	BowyerWatson2D::Triangle::Triangle(BowyerWatson2D & UNUSED(ctx), size_t v0, size_t v1, size_t v2)
+		: m_v{ { v0, v1, v2 } }, m_neighbors{ { NO_NEIGHBOR, NO_NEIGHBOR, NO_NEIGHBOR } }
+	{ }
 
-	bool BowyerWatson2D::Triangle::containsInCircumCircle(const Eigen::Vector2d & point)
+	std::array<BowyerWatson2D::Edge, 3> BowyerWatson2D::Triangle::getEdges(BowyerWatson2D & ctx)
 	{
-		double d = m_circumRadiusSquared;
-		d -= square(point.x() - m_circumCenter.x());
-		d -= square(point.y() - m_circumCenter.y());
+		return { {
+			Edge(ctx, m_v[0], m_v[1]),
+			Edge(ctx, m_v[1], m_v[2]),
+			Edge(ctx, m_v[2], m_v[0])
+		} };
+	}
 
-		if (d > 0.0) {
-			return true;
-		}
+	bool BowyerWatson2D::Triangle::containsInCircumCircle(BowyerWatson2D & ctx, const Eigen::Vector2d & point)
+	{
+		const Vector2d vec0 = toVector2d(ctx.m_vertices[m_v[0]]);
+		const Vector2d vec1 = toVector2d(ctx.m_vertices[m_v[1]]);
+		const Vector2d vec2 = toVector2d(ctx.m_vertices[m_v[2]]);
 
-		return false;
+		return incircle(vec0, vec1, vec2, point) > 0.0;
 	}
 
 	bool BowyerWatson2D::Triangle::isBounding(BowyerWatson2D & UNUSED(ctx))
 	{
-		bool v0_bounding = m_v0 < size_t(KnownVertices::COUNT);
-		bool v1_bounding = m_v1 < size_t(KnownVertices::COUNT);
-		bool v2_bounding = m_v2 < size_t(KnownVertices::COUNT);
+		bool v0_bounding = m_v[0] < size_t(KnownVertices::COUNT);
+		bool v1_bounding = m_v[1] < size_t(KnownVertices::COUNT);
+		bool v2_bounding = m_v[2] < size_t(KnownVertices::COUNT);
 		
 		if (v0_bounding || v1_bounding || v2_bounding) 
 			return true;
@@ -147,16 +107,31 @@ namespace delaunay {
 			return false;
 	}
 
+	bool BowyerWatson2D::Triangle::seesFacet(BowyerWatson2D & ctx, size_t vertex, const Vector3d & point)
+	{
+		// The point is on the inner side of the edge exactly when the triangle formed by the 
+		// edge and the point keeps the counter-clockwise orientation.
+		const Vector2d vec1 = toVector2d(ctx.m_vertices[m_v[(vertex + 1) % 3]]);
+		const Vector2d vec2 = toVector2d(ctx.m_vertices[m_v[(vertex + 2) % 3]]);
+
+		return orient2d(toVector2d(point), vec1, vec2) > 0.0;
+	}
+
 
 	// BOWYER WATSON ALGORITHM IMPLEMENTATION
 	// ======================================
 
 	void BowyerWatson2D::makeBoundingTriangles(const vertexCollection & vertices)
+	{
+		std::pair<Vector3d, Vector3d> corners = boundingBox(vertices);
+		makeBoundingTriangles(corners.first, corners.second);
+	}
+
+	std::pair<Vector3d, Vector3d> BowyerWatson2D::boundingBox(const vertexCollection & vertices)
 	{
 		// This function does this:
 		// * Finds the bounding box of the input vertices.
 		// * Enlarges the bounding box as it may play a role in some edge cases.
-		// * Construct a valid 2D delaunay triangulation of this box.
 
 		double xMin = std::numeric_limits<double>::max();
 		double xMax = std::numeric_limits<double>::lowest();
@@ -175,10 +150,15 @@ namespace delaunay {
 		double dy = yMax - yMin;
 		double maxD = std::max(dx, dy);
 
-		double left = xMin - maxD;
-		double right = xMax + maxD;
-		double top = yMax + maxD;
-		double bottom = yMin - maxD;
+		return std::make_pair(Vector3d(xMin - maxD, yMin - maxD, 0.0), Vector3d(xMax + maxD, yMax + maxD, 0.0));
+	}
+
+	void BowyerWatson2D::makeBoundingTriangles(const Vector3d & minCorner, const Vector3d & maxCorner)
+	{
+		double left = minCorner.x();
+		double right = maxCorner.x();
+		double top = maxCorner.y();
+		double bottom = minCorner.y();
 
 		Vector3d lb(left, bottom, 0.0);
 		Vector3d rb(right, bottom, 0.0);
@@ -190,14 +170,369 @@ namespace delaunay {
 		size_t rtIndex = size_t(KnownVertices::BBOX_RT);
 		size_t ltIndex = size_t(KnownVertices::BBOX_LT);
 
+		// The bounding triangles take the first slots, so the previous invocation is forgotten.
+		m_currentTriangulation.clear();
+		clearVertices();
 		m_vertices.resize(size_t(KnownVertices::COUNT));
-		m_vertices[lbIndex] = lb;
-		m_vertices[rbIndex] = rb;
-		m_vertices[rtIndex] = rt;
-		m_vertices[ltIndex] = lt;
+		m_vertices.set(lbIndex, lb);
+		m_vertices.set(rbIndex, rb);
+		m_vertices.set(rtIndex, rt);
+		m_vertices.set(ltIndex, lt);
+
+		// Both triangles are counter-clockwise and they share the diagonal LB-RT, that lies 
+		// opposite to the second vertex of the first one and the third vertex of the second one.
+		Triangle first(*this, lbIndex, rbIndex, rtIndex);
+		Triangle second(*this, lbIndex, rtIndex, ltIndex);
+		first.m_neighbors[1] = 1;
+		second.m_neighbors[2] = 0;
+
+		m_currentTriangulation.allocate(first);
+		m_currentTriangulation.allocate(second);
+		cacheCircumCircle(0);
+		cacheCircumCircle(1);
+		m_lastSimplex = 0;
+	}
+
+	void BowyerWatson2D::cacheCircumCircle(size_t index)
+	{
+		if (m_circumSpheres.size() <= index)
+			m_circumSpheres.resize(m_currentTriangulation.size());
+
+		const Triangle & triangle = m_currentTriangulation[index];
+		const Vector2d vec0 = toVector2d(m_vertices[triangle.m_v[0]]);
+		const Vector2d vec1 = toVector2d(m_vertices[triangle.m_v[1]]);
+		const Vector2d vec2 = toVector2d(m_vertices[triangle.m_v[2]]);
+
+		// The cached circle only serves as a filter, the conflict tests that it can not decide 
+		// are left to the incircle predicate. The center is also a vertex of the Voronoi diagram.
+		// Relative to the first vertex it is given by the closed formula:
+		//		X = (|b|^2 * perp(c) - |c|^2 * perp(b)) / (2 * cross(b, c)),
+		// where b and c are the other two vertices, perp(v) = [v.y, -v.x] and cross(b, c) is 
+		// the z-coordinate of their cross product. It degenerates only for collinear vertices.
+
+		const Vector2d b = vec1 - vec0;
+		const Vector2d c = vec2 - vec0;
+		const double denominator = 2.0 * (b.x() * c.y() - b.y() * c.x());
+
+		Vector2d offset;
+		offset.x() = (c.y() * squareSum(b) - b.y() * squareSum(c)) / denominator;
+		offset.y() = (b.x() * squareSum(c) - c.x() * squareSum(b)) / denominator;
+
+		Vector2d circumCenter = vec0 + offset;
+		double circumRadiusSquared = squareSum(offset);
+
+		// Conservative bound on the error of the center, derived from the sensitivity of the 
+		// formula to the rounding of its inputs. It grows without bound for (nearly) collinear
+		// vertices, then the filter just always defers to the exact test.
+		const double epsilon = std::numeric_limits<double>::epsilon();
+		const double length = std::sqrt(std::max(squareSum(b), squareSum(c)));
+		const double centerError = 
+			64.0 * epsilon * (length * length * length + std::sqrt(circumRadiusSquared) * length * length) / std::abs(denominator)
+			+ 4.0 * epsilon * circumCenter.cwiseAbs().maxCoeff();
+
+		m_circumSpheres.set(index, Vector3d(circumCenter.x(), circumCenter.y(), 0.0), circumRadiusSquared, centerError);
+	}
+
+	size_t BowyerWatson2D::locateTriangle(const Vector2d & point)
+	{
+		bool isBlocked = false;
+		size_t current = walk(m_currentTriangulation, m_lastSimplex, Vector3d(point.x(), point.y(), 0.0), isBlocked);
+
+		// The walk can only be blocked by a hole in the triangulation (see StreamingDelaunay2D),
+		// then the triangle is searched for among all of them.
+		if (isBlocked)
+			current = findContainingTriangle(point);
+
+		return current;
+	}
+
+	size_t BowyerWatson2D::findContainingTriangle(const Vector2d & point)
+	{
+		size_t containing = m_lastSimplex;
+		size_t slotCount = m_currentTriangulation.size();
+		for (size_t index = 0; index < slotCount; ++index) {
+			if (m_currentTriangulation.isLive(index) == false)
+				continue;
+
+			const Triangle & triangle = m_currentTriangulation[index];
+			bool isInside = true;
+			for (size_t edge = 0; edge < 3 && isInside; ++edge) {
+				isInside = orient2d(
+					point,
+					toVector2d(m_vertices[triangle.m_v[(edge + 1) % 3]]),
+					toVector2d(m_vertices[triangle.m_v[(edge + 2) % 3]])) >= 0.0;
+			}
+
+			if (isInside) {
+				containing = index;
+				break;
+			}
+		}
+
+		return containing;
+	}
 
-		m_currentTriangulation.push_back(Triangle(*this, lbIndex, rbIndex, rtIndex));
-		m_currentTriangulation.push_back(Triangle(*this, lbIndex, rtIndex, ltIndex));
+	void BowyerWatson2D::insertVertex(size_t vertexIndex)
+	{
+		const Vector2d point = toVector2d(m_vertices[vertexIndex]);
+		const Vector3d point3D(point.x(), point.y(), 0.0);
+
+		// FINDING THE BAD TRIANGLES
+		// =========================
+
+		// The cavity does not spread across the constrained segments.
+
+		vector<size_t> & badTriangles = m_badTriangles;
+		badTriangles.clear();
+		size_t startIndex = locateTriangle(point);
+		reportReplacedDuplicate(m_currentTriangulation[startIndex], vertexIndex);
+		findCavity(*this, m_currentTriangulation, startIndex, point3D, m_counters, badTriangles, [](size_t) { return true; });
+
+		// CONSTRUCTING THE NEW TRIANGLES
+		// ==============================
+
+		// Each edge between a bad and a good triangle is connected with the new vertex. The new
+		// triangle is the bad one with the opposite vertex replaced, so it stays counter-clockwise.
+
+		vector<Triangle> & newTriangles = m_newTriangles;
+		vector<size_t> & outerEdges = m_outerEdges;
+		newTriangles.clear();
+		outerEdges.clear();
+		for (size_t badIndex : badTriangles) {
+			Triangle & triangle = m_currentTriangulation[badIndex];
+
+			for (size_t edge = 0; edge < 3; ++edge) {
+				size_t neighborIndex = triangle.m_neighbors[edge];
+				if (neighborIndex != NO_NEIGHBOR && m_currentTriangulation[neighborIndex].isBad())
+					continue;
+
+				std::array<CompactIndex, 3> v = triangle.m_v;
+				v[edge] = vertexIndex;
+
+				Triangle newTriangle(*this, v[0], v[1], v[2]);
+				newTriangle.m_neighbors[edge] = neighborIndex;
+				newTriangle.setConstrained(edge, triangle.isConstrained(edge));
+				newTriangles.push_back(newTriangle);
+
+				// Remember which edge of the outer neighbor points back, so it can be redirected.
+				size_t outerEdge = 0;
+				if (neighborIndex != NO_NEIGHBOR) {
+					Triangle & neighbor = m_currentTriangulation[neighborIndex];
+					while (neighbor.m_neighbors[outerEdge] != badIndex)
+						++outerEdge;
+				}
+				outerEdges.push_back(outerEdge);
+			}
+		}
+
+		if (m_releasedVertices != nullptr) {
+			for (size_t badIndex : badTriangles) {
+				const Triangle & triangle = m_currentTriangulation[badIndex];
+				m_releasedVertices->insert(m_releasedVertices->end(), triangle.m_v.begin(), triangle.m_v.end());
+			}
+		}
+
+		// The slots of the bad triangles are released and then reused by the new triangles.
+		vector<size_t> & newIndices = m_newIndices;
+		replaceSimplices(m_currentTriangulation, badTriangles, newTriangles, newIndices);
+
+		// Cache the circles and redirect the outer neighbors to the new triangles. Each edge 
+		// incident to the new vertex is shared by exactly two new triangles, these are then 
+		// paired up in a hash table.
+
+		m_innerEdges.begin(2 * newTriangles.size());
+		for (size_t iNew = 0; iNew < newTriangles.size(); ++iNew) {
+			size_t index = newIndices[iNew];
+			Triangle & triangle = m_currentTriangulation[index];
+			cacheCircumCircle(index);
+
+			size_t newVertex = 0;
+			while (triangle.m_v[newVertex] != vertexIndex)
+				++newVertex;
+
+			size_t outerIndex = triangle.m_neighbors[newVertex];
+			if (outerIndex != NO_NEIGHBOR)
+				m_currentTriangulation[outerIndex].m_neighbors[outerEdges[iNew]] = index;
+
+			// The edge from the new vertex to one of the other two vertices lies opposite to the 
+			// remaining vertex.
+			std::array<size_t, 2> sides = { { (newVertex + 1) % 3, (newVertex + 2) % 3 } };
+			for (size_t iSide = 0; iSide < 2; ++iSide) {
+				size_t edge = sides[1 - iSide];
+				Edge key(*this, vertexIndex, triangle.m_v[sides[iSide]]);
+
+				size_t otherIndex, otherEdge;
+				if (m_innerEdges.match(key, index, edge, otherIndex, otherEdge)) {
+					triangle.m_neighbors[edge] = otherIndex;
+					m_currentTriangulation[otherIndex].m_neighbors[otherEdge] = index;
+				}
+			}
+		}
+
+		m_lastSimplex = newIndices.back();
+		m_counters.countInsertion(badTriangles.size(), newTriangles.size());
+	}
+
+	bool BowyerWatson2D::isDelaunayEar(size_t a, size_t b, size_t c)
+	{
+		const vector<size_t> & link = m_linkVertices;
+		const Vector2d vecA = toVector2d(m_vertices[link[a]]);
+		const Vector2d vecB = toVector2d(m_vertices[link[b]]);
+		const Vector2d vecC = toVector2d(m_vertices[link[c]]);
+
+		if (orient2d(vecA, vecB, vecC) <= 0.0)
+			return false;
+
+		for (size_t iLink = 0; iLink < link.size(); ++iLink) {
+			if (iLink == a || iLink == b || iLink == c)
+				continue;
+
+			if (incircle(vecA, vecB, vecC, toVector2d(m_vertices[link[iLink]])) > 0.0)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool BowyerWatson2D::removeVertex(const Vector3d & removedPoint)
+	{
+		// The vertices are compared as they are stored.
+		const Vector2d point = toVector2d(m_vertices.round(removedPoint));
+
+		// FINDING THE STAR OF THE VERTEX
+		// ==============================
+
+		// The walk ends in one of the triangles around the vertex. These are then visited in 
+		// counter-clockwise order, their edges opposite to the vertex form the link polygon.
+
+		size_t startIndex = locateTriangle(point);
+		const Triangle & start = m_currentTriangulation[startIndex];
+
+		size_t vertexIndex = NO_NEIGHBOR;
+		for (size_t i = 0; i < 3; ++i) {
+			if (toVector2d(m_vertices[start.m_v[i]]) == point)
+				vertexIndex = start.m_v[i];
+		}
+
+		if (vertexIndex == NO_NEIGHBOR || vertexIndex < size_t(KnownVertices::COUNT))
+			return false;
+
+		vector<size_t> & star = m_badTriangles;
+		vector<size_t> & link = m_linkVertices;
+		vector<std::pair<size_t, size_t>> & linkNeighbors = m_linkNeighbors;
+		star.clear();
+		link.clear();
+		linkNeighbors.clear();
+
+		size_t current = startIndex;
+		do {
+			const Triangle & triangle = m_currentTriangulation[current];
+
+			size_t vertex = 0;
+			while (triangle.m_v[vertex] != vertexIndex)
+				++vertex;
+
+			// The link edge may lie on the boundary of the bounding triangles.
+			size_t outerIndex = triangle.m_neighbors[vertex];
+			size_t outerEdge = 0;
+			while (outerIndex != NO_NEIGHBOR && m_currentTriangulation[outerIndex].m_neighbors[outerEdge] != current)
+				++outerEdge;
+
+			star.push_back(current);
+			link.push_back(triangle.m_v[(vertex + 1) % 3]);
+			linkNeighbors.push_back(std::make_pair(outerIndex, outerEdge));
+
+			// The next triangle shares the edge from the vertex to the end of the link edge.
+			current = triangle.m_neighbors[(vertex + 1) % 3];
+		} while (current != startIndex);
+
+		for (size_t starIndex : star)
+			m_currentTriangulation.release(starIndex);
+
+		// FILLING THE STAR
+		// ================
+
+		// The ears of the link polygon are cut off one by one. An ear is a triangle of the new 
+		// triangulation when it is convex and no other link vertex lies in its circle, it is 
+		// enough to test the link vertices only. Cutting off an ear can only change the ears of 
+		// its two neighbors, so these are queued again.
+
+		size_t linkSize = link.size();
+		vector<std::pair<size_t, size_t>> & siblings = m_linkSiblings;
+		siblings.resize(linkSize);
+		for (size_t iLink = 0; iLink < linkSize; ++iLink)
+			siblings[iLink] = std::make_pair((iLink + linkSize - 1) % linkSize, (iLink + 1) % linkSize);
+
+		vector<size_t> & newIndices = m_newIndices;
+		newIndices.clear();
+
+		// Connects the edge of the new triangle to the triangle behind the polygon edge.
+		auto connect = [&](size_t index, size_t edge, const std::pair<size_t, size_t> & outer) {
+			m_currentTriangulation[index].m_neighbors[edge] = outer.first;
+			if (outer.first != NO_NEIGHBOR)
+				m_currentTriangulation[outer.first].m_neighbors[outer.second] = index;
+		};
+
+		// Creates the triangle (a, b, c) and connects it to the triangles behind the polygon
+		// edges a-b and b-c. Edge c-a then becomes the polygon edge that follows a.
+		auto cutEar = [&](size_t a, size_t b, size_t c) {
+			size_t index = m_currentTriangulation.allocate(Triangle(*this, link[a], link[b], link[c]));
+			newIndices.push_back(index);
+
+			connect(index, 0, linkNeighbors[b]);
+			connect(index, 2, linkNeighbors[a]);
+			linkNeighbors[a] = std::make_pair(index, size_t(1));
+		};
+
+		vector<size_t> & queue = m_outerEdges;
+		queue.resize(linkSize);
+		std::iota(queue.begin(), queue.end(), size_t(0));
+
+		vector<bool> & isCut = m_linkIsCut;
+		isCut.assign(linkSize, false);
+		size_t remaining = linkSize;
+		while (remaining > 3 && !queue.empty()) {
+			size_t b = queue.back();
+			queue.pop_back();
+			if (isCut[b])
+				continue;
+
+			size_t a = siblings[b].first;
+			size_t c = siblings[b].second;
+			if (!isDelaunayEar(a, b, c))
+				continue;
+
+			cutEar(a, b, c);
+			isCut[b] = true;
+			siblings[a].second = c;
+			siblings[c].first = a;
+			--remaining;
+
+			queue.push_back(a);
+			queue.push_back(c);
+		}
+
+		// The last triangle closes the polygon, its third edge is the one that follows c.
+		size_t a = 0;
+		while (isCut[a])
+			++a;
+		size_t b = siblings[a].second;
+		size_t c = siblings[b].second;
+
+		std::pair<size_t, size_t> closing = linkNeighbors[c];
+		cutEar(a, b, c);
+		connect(newIndices.back(), 1, closing);
+
+		for (size_t newIndex : newIndices)
+			cacheCircumCircle(newIndex);
+
+		if (m_changedSlots != nullptr) {
+			m_changedSlots->insert(m_changedSlots->end(), star.begin(), star.end());
+			m_changedSlots->insert(m_changedSlots->end(), newIndices.begin(), newIndices.end());
+		}
+
+		m_lastSimplex = newIndices.back();
+		return true;
 	}
 
 	Mesh* BowyerWatson2D::convertTriangulationIntoMesh()
@@ -206,110 +541,903 @@ namespace delaunay {
 		// ================================
 
 		size_t boundingVerticesCount = size_t(KnownVertices::COUNT);
-		size_t totalVerticesCount = m_vertices.size();
-		size_t verticesCount = totalVerticesCount - boundingVerticesCount;
+		size_t verticesCount = m_inputIndices.size();
 
-		size_t triangleCount = std::count_if(
-			m_currentTriangulation.begin(),
-			m_currentTriangulation.end(),
-			[this](Triangle & triangle) { return (triangle.isBounding(*this) == false); }
+		size_t triangleCount = 0;
+		m_currentTriangulation.forEachLive(
+			[this, &triangleCount](size_t, Triangle & triangle) {
+				if (triangle.isBounding(*this) == false)
+					++triangleCount;
+			}
 		);
 
+		bool isDoubleSided = (m_faceSides == FaceSides::DOUBLE_SIDED);
+
 		Mesh* result = new Mesh;
 		result->setNumVerts(int(verticesCount));
-		result->setNumFaces(int(2 * triangleCount));
+		result->setNumFaces(int(isDoubleSided ? 2 * triangleCount : triangleCount));
 
+		// The vertices keep the indices they have in the input.
 		for (size_t iVertex = 0; iVertex < verticesCount; ++iVertex) {
-			Vector3d & vertex = m_vertices[iVertex + boundingVerticesCount];
-			result->setVert(int(iVertex), toPoint3(vertex));
+			Vector3d vertex = m_vertices[iVertex + boundingVerticesCount];
+			result->setVert(int(m_inputIndices[iVertex]), toPoint3(vertex));
 		}
 
 		size_t iFace = 0;
-		for (Triangle & triangle : m_currentTriangulation) {
-			if (triangle.isBounding(*this))
+		m_currentTriangulation.forEachLive(
+			[this, result, triangleCount, isDoubleSided, &iFace](size_t, Triangle & triangle) {
+				if (triangle.isBounding(*this))
+					return;
+
+				DWORD index0 = DWORD(inputIndex(triangle.m_v[0]));
+				DWORD index1 = DWORD(inputIndex(triangle.m_v[1]));
+				DWORD index2 = DWORD(inputIndex(triangle.m_v[2]));
+
+				result->faces[iFace].v[0] = index0;
+				result->faces[iFace].v[1] = index1;
+				result->faces[iFace].v[2] = index2;
+
+				if (isDoubleSided) {
+					result->faces[triangleCount + iFace].v[0] = index2;
+					result->faces[triangleCount + iFace].v[1] = index1;
+					result->faces[triangleCount + iFace].v[2] = index0;
+				}
+
+				++iFace;
+			}
+		);
+
+		result->InvalidateGeomCache();
+		return result;
+	}
+
+	void BowyerWatson2D::insertConstraints()
+	{
+		size_t firstVertexIndex = size_t(KnownVertices::COUNT);
+
+		vector<size_t> vertexOfInput(m_inputIndices.size());
+		for (size_t i = 0; i < m_inputIndices.size(); ++i)
+			vertexOfInput[m_inputIndices[i]] = firstVertexIndex + i;
+
+		// The segments of the merged vertices end in the vertices they were merged into.
+		for (size_t i = 0; i < m_mergeRemap.size(); ++i)
+			vertexOfInput[i] = vertexOfInput[m_mergeRemap[i]];
+
+		m_vertexTriangles.assign(m_vertices.size(), NO_NEIGHBOR);
+		m_currentTriangulation.forEachLive(
+			[this](size_t index, Triangle & triangle) {
+				for (size_t vertex : triangle.m_v)
+					m_vertexTriangles[vertex] = index;
+			}
+		);
+
+		for (size_t i = 0; i + 1 < m_constraints.size(); i += 2) {
+			size_t startInput = m_constraints[i];
+			size_t endInput = m_constraints[i + 1];
+			if (startInput >= vertexOfInput.size() || endInput >= vertexOfInput.size()) {
+				++m_rejectedConstraintCount;
+				continue;
+			}
+
+			size_t start = findConnectedVertex(vertexOfInput[startInput]);
+			size_t end = findConnectedVertex(vertexOfInput[endInput]);
+			if (start == NO_NEIGHBOR || end == NO_NEIGHBOR) {
+				++m_rejectedConstraintCount;
 				continue;
+			}
 
-			DWORD index0 = DWORD(triangle.m_v0 - boundingVerticesCount);
-			DWORD index1 = DWORD(triangle.m_v1 - boundingVerticesCount);
-			DWORD index2 = DWORD(triangle.m_v2 - boundingVerticesCount);
+			// The segment is inserted part by part, between the vertices that lie on it.
+			while (start != end) {
+				start = insertSegmentPart(start, end);
+				if (start == NO_NEIGHBOR) {
+					++m_rejectedConstraintCount;
+					break;
+				}
+			}
+		}
+	}
 
-			result->faces[iFace].v[0] = index0;
-			result->faces[iFace].v[1] = index1;
-			result->faces[iFace].v[2] = index2;
+	size_t BowyerWatson2D::findConnectedVertex(size_t vertexIndex)
+	{
+		if (m_vertexTriangles[vertexIndex] != NO_NEIGHBOR)
+			return vertexIndex;
+
+		// A duplicate vertex is not connected, the one at its position is a vertex of the 
+		// triangle that contains it.
+		const Vector2d point = toVector2d(m_vertices[vertexIndex]);
+		const Triangle & triangle = m_currentTriangulation[locateTriangle(point)];
+		for (size_t vertex : triangle.m_v) {
+			if (toVector2d(m_vertices[vertex]) == point)
+				return vertex;
+		}
 
-			result->faces[triangleCount + iFace].v[0] = index2;
-			result->faces[triangleCount + iFace].v[1] = index1;
-			result->faces[triangleCount + iFace].v[2] = index0;
+		return NO_NEIGHBOR;
+	}
 
-			++iFace;
+	void BowyerWatson2D::markConstrainedEdge(size_t index, size_t edge)
+	{
+		Triangle & triangle = m_currentTriangulation[index];
+		triangle.setConstrained(edge, true);
+
+		size_t neighborIndex = triangle.m_neighbors[edge];
+		if (neighborIndex != NO_NEIGHBOR) {
+			Triangle & neighbor = m_currentTriangulation[neighborIndex];
+			for (size_t i = 0; i < 3; ++i) {
+				if (neighbor.m_neighbors[i] == index)
+					neighbor.setConstrained(i, true);
+			}
 		}
+	}
 
-		result->InvalidateGeomCache();
-		return result;
+	size_t BowyerWatson2D::insertSegmentPart(size_t start, size_t end)
+	{
+		const Vector2d startPoint = toVector2d(m_vertices[start]);
+		const Vector2d endPoint = toVector2d(m_vertices[end]);
+
+		// FINDING THE FIRST CROSSED TRIANGLE
+		// ==================================
+
+		// The triangles around the start vertex are visited in counter-clockwise order, until the
+		// one whose angle at the start vertex contains the direction of the segment. The segment
+		// may also follow an existing edge.
+
+		size_t first = m_vertexTriangles[start];
+		size_t current = first;
+		size_t right = NO_NEIGHBOR;
+		size_t left = NO_NEIGHBOR;
+		size_t crossedEdge = 0;
+		do {
+			const Triangle & triangle = m_currentTriangulation[current];
+			size_t i = 0;
+			while (triangle.m_v[i] != start)
+				++i;
+
+			size_t next = triangle.m_v[(i + 1) % 3];
+			size_t previous = triangle.m_v[(i + 2) % 3];
+			if (next == end) {
+				markConstrainedEdge(current, (i + 2) % 3);
+				return end;
+			}
+			if (previous == end) {
+				markConstrainedEdge(current, (i + 1) % 3);
+				return end;
+			}
+
+			const Vector2d nextPoint = toVector2d(m_vertices[next]);
+			double nextSide = orient2d(startPoint, nextPoint, endPoint);
+			if (nextSide == 0.0 && (nextPoint - startPoint).dot(endPoint - startPoint) > 0.0) {
+				markConstrainedEdge(current, (i + 2) % 3);
+				return next;
+			}
+
+			if (nextSide > 0.0 && orient2d(startPoint, toVector2d(m_vertices[previous]), endPoint) < 0.0) {
+				right = next;
+				left = previous;
+				crossedEdge = i;
+				break;
+			}
+
+			current = triangle.m_neighbors[(i + 1) % 3];
+		} while (current != first && current != NO_NEIGHBOR);
+
+		if (right == NO_NEIGHBOR)
+			return NO_NEIGHBOR;
+
+
+		// WALKING ALONG THE SEGMENT
+		// =========================
+
+		// Each crossed edge has one vertex on the left and one on the right of the segment. The
+		// vertex of the next triangle replaces one of them, or it ends the walk when it lies on
+		// the segment.
+
+		vector<size_t> & crossed = m_badTriangles;
+		crossed.clear();
+		crossed.push_back(current);
+		m_currentTriangulation[current].setBad(true);
+
+		m_leftChain.assign(1, start);
+		m_rightChain.assign(1, start);
+		m_leftChain.push_back(left);
+		m_rightChain.push_back(right);
+
+		size_t partEnd = NO_NEIGHBOR;
+		while (partEnd == NO_NEIGHBOR) {
+			const Triangle & triangle = m_currentTriangulation[current];
+			size_t nextIndex = triangle.m_neighbors[crossedEdge];
+			if (triangle.isConstrained(crossedEdge) || nextIndex == NO_NEIGHBOR) {
+				for (size_t index : crossed)
+					m_currentTriangulation[index].setBad(false);
+				return NO_NEIGHBOR;
+			}
+
+			Triangle & next = m_currentTriangulation[nextIndex];
+			next.setBad(true);
+			crossed.push_back(nextIndex);
+
+			size_t opposite = 0;
+			while (next.m_neighbors[opposite] != current)
+				++opposite;
+
+			size_t vertex = next.m_v[opposite];
+			double side = orient2d(startPoint, endPoint, toVector2d(m_vertices[vertex]));
+			if (vertex == end || side == 0.0) {
+				partEnd = vertex;
+			}
+			else if (side > 0.0) {
+				m_leftChain.push_back(vertex);
+				crossedEdge = size_t(std::find(next.m_v.begin(), next.m_v.end(), left) - next.m_v.begin());
+				left = vertex;
+			}
+			else {
+				m_rightChain.push_back(vertex);
+				crossedEdge = size_t(std::find(next.m_v.begin(), next.m_v.end(), right) - next.m_v.begin());
+				right = vertex;
+			}
+
+			current = nextIndex;
+		}
+
+		m_leftChain.push_back(partEnd);
+		m_rightChain.push_back(partEnd);
+
+
+		// RE-TRIANGULATING THE CAVITY
+		// ===========================
+
+		// The cavity on the left has the segment as its edge directed from the start, the one on 
+		// the right has it directed from the end.
+
+		vector<Triangle> & newTriangles = m_newTriangles;
+		newTriangles.clear();
+		triangulatePseudoPolygon(start, partEnd, m_leftChain, 1, m_leftChain.size() - 1);
+		std::reverse(m_rightChain.begin(), m_rightChain.end());
+		triangulatePseudoPolygon(partEnd, start, m_rightChain, 1, m_rightChain.size() - 1);
+
+		// The edges of the outer neighbors are put into the table first, so the new triangles
+		// are matched with them the same way as with each other.
+		m_innerEdges.begin(3 * crossed.size());
+		for (size_t index : crossed) {
+			const Triangle & triangle = m_currentTriangulation[index];
+			for (size_t edge = 0; edge < 3; ++edge) {
+				size_t neighborIndex = triangle.m_neighbors[edge];
+				if (neighborIndex == NO_NEIGHBOR || m_currentTriangulation[neighborIndex].isBad())
+					continue;
+
+				const Triangle & neighbor = m_currentTriangulation[neighborIndex];
+				size_t neighborEdge = 0;
+				while (neighbor.m_neighbors[neighborEdge] != index)
+					++neighborEdge;
+
+				size_t otherIndex, otherEdge;
+				Edge key(*this, triangle.m_v[(edge + 1) % 3], triangle.m_v[(edge + 2) % 3]);
+				m_innerEdges.match(key, neighborIndex, neighborEdge, otherIndex, otherEdge);
+			}
+		}
+
+		for (size_t index : crossed)
+			m_currentTriangulation.release(index);
+
+		vector<size_t> & newIndices = m_newIndices;
+		newIndices.clear();
+		for (const Triangle & newTriangle : newTriangles)
+			newIndices.push_back(m_currentTriangulation.allocate(newTriangle));
+
+		const Edge segment(*this, start, partEnd);
+		for (size_t index : newIndices) {
+			Triangle & triangle = m_currentTriangulation[index];
+			cacheCircumCircle(index);
+
+			for (size_t edge = 0; edge < 3; ++edge) {
+				Edge key(*this, triangle.m_v[(edge + 1) % 3], triangle.m_v[(edge + 2) % 3]);
+
+				size_t otherIndex, otherEdge;
+				if (m_innerEdges.match(key, index, edge, otherIndex, otherEdge)) {
+					Triangle & other = m_currentTriangulation[otherIndex];
+					bool isConstrained = other.isConstrained(otherEdge) || (key.m_v0 == segment.m_v0 && key.m_v1 == segment.m_v1);
+
+					triangle.m_neighbors[edge] = otherIndex;
+					triangle.setConstrained(edge, isConstrained);
+					other.m_neighbors[otherEdge] = index;
+					other.setConstrained(otherEdge, isConstrained);
+				}
+			}
+
+			for (size_t vertex : triangle.m_v)
+				m_vertexTriangles[vertex] = index;
+		}
+
+		m_lastSimplex = newIndices.back();
+		return partEnd;
 	}
 
-	Mesh* BowyerWatson2D::invoke(const vector<Vector3d> & inputVertices)
+	void BowyerWatson2D::triangulatePseudoPolygon(size_t start, size_t end, const vector<size_t> & chain, size_t first, size_t last)
+	{
+		// The chain vertex whose circle with the edge contains no other chain vertex forms a 
+		// triangle with it, which splits the polygon into two smaller ones (L. Chew: Constrained
+		// Delaunay Triangulations, 1989; M. V. Anglada: An improved incremental algorithm for 
+		// constructing restricted Delaunay triangulations, 1997).
+
+		m_polygonStack.clear();
+		m_polygonStack.push_back({ { start, end, first, last } });
+		while (m_polygonStack.empty() == false) {
+			std::array<size_t, 4> polygon = m_polygonStack.back();
+			m_polygonStack.pop_back();
+			if (polygon[2] == polygon[3])
+				continue;
+
+			const Vector2d startPoint = toVector2d(m_vertices[polygon[0]]);
+			const Vector2d endPoint = toVector2d(m_vertices[polygon[1]]);
+
+			size_t best = polygon[2];
+			for (size_t i = polygon[2] + 1; i < polygon[3]; ++i) {
+				if (incircle(startPoint, endPoint, toVector2d(m_vertices[chain[best]]), toVector2d(m_vertices[chain[i]])) > 0.0)
+					best = i;
+			}
+
+			m_newTriangles.push_back(Triangle(*this, polygon[0], polygon[1], chain[best]));
+			m_polygonStack.push_back({ { polygon[0], chain[best], polygon[2], best } });
+			m_polygonStack.push_back({ { chain[best], polygon[1], best + 1, polygon[3] } });
+		}
+	}
+
+	void BowyerWatson2D::refine()
+	{
+		// PREPARATION
+		// ===========
+
+		// All the edges of the bounding triangles become constrained, so no vertex is inserted 
+		// outside of the convex hull (the circumcenter of a triangle by the hull encroaches the 
+		// hull edge instead). The cavity of a split hull edge then takes only the bounding 
+		// triangle behind it.
+		m_currentTriangulation.forEachLive(
+			[this](size_t index, Triangle & triangle) {
+				if (triangle.isBounding(*this)) {
+					for (size_t edge = 0; edge < 3; ++edge)
+						markConstrainedEdge(index, edge);
+				}
+			}
+		);
+
+		double sinMinAngle = std::sin(std::min(m_minAngle, MAX_MIN_ANGLE) * std::acos(-1.0) / 180.0);
+		m_sinMinAngleSquared = sinMinAngle * sinMinAngle;
+
+		// The edges much shorter than the extent of the vertices are not refined anymore, which 
+		// bounds the number of the inserted vertices also when the input has small angles. The 
+		// Mesh stores the vertices in float, so the bound is kept well above the float resolution
+		// of the largest coordinates, and no triangle of the refined edges becomes flat there.
+		const Vector3d minCorner = m_vertices[size_t(KnownVertices::BBOX_LB)];
+		const Vector3d maxCorner = m_vertices[size_t(KnownVertices::BBOX_RT)];
+		double magnitude = std::max({ (maxCorner - minCorner).norm(), minCorner.cwiseAbs().maxCoeff(), maxCorner.cwiseAbs().maxCoeff() });
+		double minEdgeLength = MIN_EDGE_ULPS * double(std::numeric_limits<float>::epsilon()) * magnitude;
+		m_minEdgeLengthSquared = minEdgeLength * minEdgeLength;
+
+		m_firstRefinementVertex = m_vertices.size();
+		m_splitSegments.clear();
+
+		m_badQueue = std::priority_queue<BadTriangle>();
+		m_encroachedSegments.clear();
+
+		vector<size_t> initialTriangles;
+		m_currentTriangulation.forEachLive(
+			[&initialTriangles](size_t index, Triangle &) { initialTriangles.push_back(index); }
+		);
+		for (size_t index : initialTriangles)
+			enqueueRefinement(index);
+
+
+		// REFINEMENT
+		// ==========
+
+		// The encroached segments are split first. Then the worst bad triangle is refined by its
+		// circumcenter, unless the circumcenter encroaches some segments, which are split 
+		// instead. Each insertion only touches its cavity and checks the new triangles. The number
+		// of the inserted vertices is not known ahead, so the progress stays full, but the 
+		// refinement can still be cancelled.
+
+		size_t stepCount = 0;
+		while (true) {
+			if (++stepCount % PROGRESS_INTERVAL == 0)
+				reportProgress(1.0);
+
+			if (m_encroachedSegments.empty() == false) {
+				EncroachedSegment segment = m_encroachedSegments.back();
+				m_encroachedSegments.pop_back();
+
+				const Triangle & triangle = m_currentTriangulation[segment.m_index];
+				bool isValid = m_currentTriangulation.isLive(segment.m_index)
+					&& triangle.isConstrained(segment.m_edge)
+					&& triangle.m_v[(segment.m_edge + 1) % 3] == segment.m_v0
+					&& triangle.m_v[(segment.m_edge + 2) % 3] == segment.m_v1;
+
+				if (isValid && isEncroached(segment.m_index, segment.m_edge))
+					splitSegment(segment.m_index, segment.m_edge);
+				continue;
+			}
+
+			if (m_badQueue.empty())
+				break;
+
+			BadTriangle bad = m_badQueue.top();
+			m_badQueue.pop();
+			if (m_currentTriangulation.isLive(bad.m_index) == false || m_currentTriangulation[bad.m_index].m_v != bad.m_v)
+				continue;
+
+			// The circumcenter is rounded as it will be stored, so it is tested where it is inserted.
+			const Vector3d center3D = m_vertices.round(m_circumSpheres.getCenter(bad.m_index));
+			const Vector2d center = toVector2d(center3D);
+
+			// The circumcenter behind a segment encroaches it.
+			size_t blockingIndex, blockingEdge;
+			size_t containing = locateVisibleTriangle(bad.m_index, center, blockingIndex, blockingEdge);
+			if (containing == NO_NEIGHBOR) {
+				const Triangle & blocking = m_currentTriangulation[blockingIndex];
+				const Vector2d a = toVector2d(m_vertices[blocking.m_v[(blockingEdge + 1) % 3]]);
+				const Vector2d b = toVector2d(m_vertices[blocking.m_v[(blockingEdge + 2) % 3]]);
+
+				if ((a - center).dot(b - center) < 0.0 && splitSegment(blockingIndex, blockingEdge))
+					m_badQueue.push(bad);
+				continue;
+			}
+
+			// The segments on the boundary of the cavity of the circumcenter are checked for
+			// the encroachment before it is inserted.
+			vector<size_t> & cavity = m_refinementCavity;
+			cavity.assign(1, containing);
+			m_currentTriangulation[containing].setBad(true);
+
+			size_t encroachedCount = m_encroachedSegments.size();
+			for (size_t iCavity = 0; iCavity < cavity.size(); ++iCavity) {
+				size_t index = cavity[iCavity];
+				const Triangle & triangle = m_currentTriangulation[index];
+
+				for (size_t edge = 0; edge < 3; ++edge) {
+					size_t v0 = triangle.m_v[(edge + 1) % 3];
+					size_t v1 = triangle.m_v[(edge + 2) % 3];
+
+					if (triangle.isConstrained(edge)) {
+						const Vector2d a = toVector2d(m_vertices[v0]);
+						const Vector2d b = toVector2d(m_vertices[v1]);
+						if ((a - center).dot(b - center) < 0.0)
+							m_encroachedSegments.push_back({ index, edge, v0, v1 });
+						continue;
+					}
+
+					size_t neighborIndex = triangle.m_neighbors[edge];
+					if (neighborIndex == NO_NEIGHBOR || m_currentTriangulation[neighborIndex].isBad())
+						continue;
+
+					Triangle & neighbor = m_currentTriangulation[neighborIndex];
+					if (neighbor.containsInCircumCircle(*this, center)) {
+						neighbor.setBad(true);
+						cavity.push_back(neighborIndex);
+					}
+				}
+			}
+
+			for (size_t index : cavity)
+				m_currentTriangulation[index].setBad(false);
+
+			if (m_encroachedSegments.size() > encroachedCount) {
+				// The triangle is refined again once the segments are split, unless they are
+				// too short.
+				bool isSplit = false;
+				while (m_encroachedSegments.size() > encroachedCount) {
+					EncroachedSegment segment = m_encroachedSegments.back();
+					m_encroachedSegments.pop_back();
+
+					const Triangle & triangle = m_currentTriangulation[segment.m_index];
+					bool isValid = m_currentTriangulation.isLive(segment.m_index)
+						&& triangle.isConstrained(segment.m_edge)
+						&& triangle.m_v[(segment.m_edge + 1) % 3] == segment.m_v0
+						&& triangle.m_v[(segment.m_edge + 2) % 3] == segment.m_v1;
+
+					if (isValid && splitSegment(segment.m_index, segment.m_edge))
+						isSplit = true;
+				}
+
+				if (isSplit)
+					m_badQueue.push(bad);
+				continue;
+			}
+
+			// The height of the new vertex is interpolated from the containing triangle.
+			const Triangle & triangle = m_currentTriangulation[containing];
+			const Vector3d a = m_vertices[triangle.m_v[0]];
+			const Vector3d b = m_vertices[triangle.m_v[1]];
+			const Vector3d c = m_vertices[triangle.m_v[2]];
+			double area = (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+			double weightB = ((center.x() - a.x()) * (c.y() - a.y()) - (center.y() - a.y()) * (c.x() - a.x())) / area;
+			double weightC = ((b.x() - a.x()) * (center.y() - a.y()) - (b.y() - a.y()) * (center.x() - a.x())) / area;
+			double height = a.z() + weightB * (b.z() - a.z()) + weightC * (c.z() - a.z());
+
+			size_t vertexIndex = addSteinerVertex(Vector3d(center.x(), center.y(), std::isfinite(height) ? height : a.z()), { { NO_NEIGHBOR, NO_NEIGHBOR } });
+			m_lastSimplex = containing;
+			insertVertex(vertexIndex);
+
+			for (size_t index : m_newIndices)
+				enqueueRefinement(index);
+		}
+	}
+
+	void BowyerWatson2D::enqueueRefinement(size_t index)
+	{
+		Triangle & triangle = m_currentTriangulation[index];
+		if (triangle.isBounding(*this))
+			return;
+
+		for (size_t edge = 0; edge < 3; ++edge) {
+			if (triangle.isConstrained(edge) && isEncroached(index, edge))
+				m_encroachedSegments.push_back({ index, edge, triangle.m_v[(edge + 1) % 3], triangle.m_v[(edge + 2) % 3] });
+		}
+
+		const Vector2d a = toVector2d(m_vertices[triangle.m_v[0]]);
+		const Vector2d b = toVector2d(m_vertices[triangle.m_v[1]]);
+		const Vector2d c = toVector2d(m_vertices[triangle.m_v[2]]);
+
+		const std::array<double, 3> lengthsSquared = { { (c - b).squaredNorm(), (a - c).squaredNorm(), (b - a).squaredNorm() } };
+		size_t shortest = size_t(std::min_element(lengthsSquared.begin(), lengthsSquared.end()) - lengthsSquared.begin());
+		double shortestSquared = lengthsSquared[shortest];
+		if (shortestSquared < m_minEdgeLengthSquared)
+			return;
+
+		// The smallest angle lies opposite to the shortest edge, its sine is the edge length 
+		// divided by the diameter of the circumscribed circle.
+		double priority = 0.0;
+		if (m_minAngle > 0.0 && isSeditious(triangle.m_v[(shortest + 1) % 3], triangle.m_v[(shortest + 2) % 3]) == false)
+			priority = 4.0 * m_circumSpheres.m_radiusSquared[index] * m_sinMinAngleSquared / shortestSquared;
+
+		if (m_maxArea > 0.0) {
+			double area = 0.5 * std::abs((b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x()));
+			priority = std::max(priority, area / m_maxArea);
+		}
+
+		if (priority > 1.0)
+			m_badQueue.push({ priority, index, triangle.m_v });
+	}
+
+	bool BowyerWatson2D::isEncroached(size_t index, size_t edge)
+	{
+		const Triangle & triangle = m_currentTriangulation[index];
+		const Vector2d a = toVector2d(m_vertices[triangle.m_v[(edge + 1) % 3]]);
+		const Vector2d b = toVector2d(m_vertices[triangle.m_v[(edge + 2) % 3]]);
+		if ((b - a).squaredNorm() < 4.0 * m_minEdgeLengthSquared)
+			return false;
+
+		// The vertex lies inside of the diametral circle when it sees the edge at an obtuse 
+		// angle. The bounding vertices lie outside of the domain.
+		std::array<size_t, 2> apexes = { { triangle.m_v[edge], NO_NEIGHBOR } };
+		size_t neighborIndex = triangle.m_neighbors[edge];
+		if (neighborIndex != NO_NEIGHBOR) {
+			const Triangle & neighbor = m_currentTriangulation[neighborIndex];
+			for (size_t i = 0; i < 3; ++i) {
+				if (neighbor.m_neighbors[i] == index)
+					apexes[1] = neighbor.m_v[i];
+			}
+		}
+
+		for (size_t apex : apexes) {
+			if (apex == NO_NEIGHBOR || apex < size_t(KnownVertices::COUNT))
+				continue;
+
+			const Vector2d point = toVector2d(m_vertices[apex]);
+			if ((a - point).dot(b - point) < 0.0)
+				return true;
+		}
+
+		return false;
+	}
+
+	bool BowyerWatson2D::splitSegment(size_t index, size_t edge)
+	{
+		Triangle & triangle = m_currentTriangulation[index];
+		size_t v0 = triangle.m_v[(edge + 1) % 3];
+		size_t v1 = triangle.m_v[(edge + 2) % 3];
+		if ((toVector2d(m_vertices[v1]) - toVector2d(m_vertices[v0])).squaredNorm() < 4.0 * m_minEdgeLengthSquared)
+			return false;
+
+		// An edge by a single input vertex is split where it crosses the circle around the vertex 
+		// whose radius is the power of two closest to a half of the edge, that is between 0.35 and
+		// 0.71 of its length.
+		const std::array<size_t, 2> segment = inputSegment(v0, v1);
+		double fraction = 0.5;
+		if ((v0 < m_firstRefinementVertex) != (v1 < m_firstRefinementVertex)) {
+			double length = (toVector2d(m_vertices[v1]) - toVector2d(m_vertices[v0])).norm();
+			double radius = std::exp2(std::round(std::log2(0.5 * length)));
+			fraction = (v0 < m_firstRefinementVertex) ? radius / length : 1.0 - radius / length;
+		}
+
+		// The split point lies inside of the circles of both the triangles by the edge, so both of
+		// them are replaced once the edge is not constrained. The halves are then marked. The 
+		// rounding of the stored coordinates can move it off the edge and out of a flat circle, 
+		// such an edge is not split.
+		const Vector3d midpointVertex = m_vertices.round(m_vertices[v0] + fraction * (m_vertices[v1] - m_vertices[v0]));
+		const Vector2d midpoint2D = toVector2d(midpointVertex);
+		size_t neighborIndex = triangle.m_neighbors[edge];
+		if (triangle.containsInCircumCircle(*this, midpoint2D) == false)
+			return false;
+		if (neighborIndex != NO_NEIGHBOR && m_currentTriangulation[neighborIndex].containsInCircumCircle(*this, midpoint2D) == false)
+			return false;
+
+		triangle.setConstrained(edge, false);
+		if (neighborIndex != NO_NEIGHBOR) {
+			Triangle & neighbor = m_currentTriangulation[neighborIndex];
+			for (size_t i = 0; i < 3; ++i) {
+				if (neighbor.m_neighbors[i] == index)
+					neighbor.setConstrained(i, false);
+			}
+		}
+
+		size_t midpoint = addSteinerVertex(midpointVertex, segment);
+		m_lastSimplex = index;
+		insertVertex(midpoint);
+
+		const Edge half0(*this, v0, midpoint);
+		const Edge half1(*this, midpoint, v1);
+		for (size_t newIndex : m_newIndices) {
+			const Triangle & newTriangle = m_currentTriangulation[newIndex];
+			for (size_t newEdge = 0; newEdge < 3; ++newEdge) {
+				Edge key(*this, newTriangle.m_v[(newEdge + 1) % 3], newTriangle.m_v[(newEdge + 2) % 3]);
+				bool isHalf = (key.m_v0 == half0.m_v0 && key.m_v1 == half0.m_v1) || (key.m_v0 == half1.m_v0 && key.m_v1 == half1.m_v1);
+				if (isHalf)
+					markConstrainedEdge(newIndex, newEdge);
+			}
+		}
+
+		for (size_t newIndex : m_newIndices)
+			enqueueRefinement(newIndex);
+
+		return true;
+	}
+
+	size_t BowyerWatson2D::locateVisibleTriangle(size_t start, const Vector2d & point, size_t & blockingIndex, size_t & blockingEdge)
+	{
+		size_t current = start;
+		size_t previous = NO_NEIGHBOR;
+
+		bool found = false;
+		while (!found) {
+			const Triangle & triangle = m_currentTriangulation[current];
+			size_t rotation = m_walkRotation++;
+
+			found = true;
+			for (size_t i = 0; i < 3; ++i) {
+				size_t edge = (rotation + i) % 3;
+				size_t neighbor = triangle.m_neighbors[edge];
+
+				if (neighbor != NO_NEIGHBOR && neighbor == previous)
+					continue;
+
+				if (orient2d(
+					point,
+					toVector2d(m_vertices[triangle.m_v[(edge + 1) % 3]]),
+					toVector2d(m_vertices[triangle.m_v[(edge + 2) % 3]])) < 0.0)
+				{
+					if (triangle.isConstrained(edge) || neighbor == NO_NEIGHBOR) {
+						blockingIndex = current;
+						blockingEdge = edge;
+						return NO_NEIGHBOR;
+					}
+
+					previous = current;
+					current = neighbor;
+					found = false;
+					break;
+				}
+			}
+		}
+
+		return current;
+	}
+
+	std::array<size_t, 2> BowyerWatson2D::inputSegment(size_t v0, size_t v1) const
+	{
+		if (v0 >= m_firstRefinementVertex)
+			return m_splitSegments[v0 - m_firstRefinementVertex];
+		if (v1 >= m_firstRefinementVertex)
+			return m_splitSegments[v1 - m_firstRefinementVertex];
+		return { { std::min(v0, v1), std::max(v0, v1) } };
+	}
+
+	bool BowyerWatson2D::isSeditious(size_t v0, size_t v1) const
+	{
+		if (v0 < m_firstRefinementVertex || v1 < m_firstRefinementVertex)
+			return false;
+
+		const std::array<size_t, 2> & segment0 = m_splitSegments[v0 - m_firstRefinementVertex];
+		const std::array<size_t, 2> & segment1 = m_splitSegments[v1 - m_firstRefinementVertex];
+		if (segment0[0] == NO_NEIGHBOR || segment1[0] == NO_NEIGHBOR)
+			return false;
+
+		for (size_t apex : segment0) {
+			if ((apex == segment1[0] || apex == segment1[1]) == false || segment0 == segment1)
+				continue;
+
+			// Both the vertices lie on the same circle around the common vertex, up to rounding.
+			const Vector2d center = toVector2d(m_vertices[apex]);
+			const Vector2d a = toVector2d(m_vertices[v0]) - center;
+			const Vector2d b = toVector2d(m_vertices[v1]) - center;
+			double ratio = a.squaredNorm() / b.squaredNorm();
+			if (ratio > 0.998 && ratio < 1.002 && a.dot(b) > 0.5 * a.norm() * b.norm())
+				return true;
+		}
+
+		return false;
+	}
+
+	size_t BowyerWatson2D::addSteinerVertex(const Vector3d & vertex, const std::array<size_t, 2> & segment)
+	{
+		m_inputIndices.push_back(m_inputIndices.size());
+		m_vertices.push_back(vertex);
+		m_splitSegments.push_back(segment);
+		return m_vertices.size() - 1;
+	}
+
+	void BowyerWatson2D::triangulate(const vector<Vector3d> & inputVertices)
 	{
 		// PREPARATION PHASE
 		// =================
 
+		PhaseClock clock;
+		m_counters = InsertionCounters();
+
+		// A triangulation of n vertices has about 2n triangles.
+		size_t expectedTriangleCount = 2 * (inputVertices.size() + size_t(KnownVertices::COUNT));
+		m_currentTriangulation.reserve(expectedTriangleCount);
+		m_circumSpheres.reserve(expectedTriangleCount);
+		m_vertices.reserve(inputVertices.size() + size_t(KnownVertices::COUNT));
+		m_inputIndices.reserve(inputVertices.size());
+
 		// Calculate the initial triangulation which bounds the input vertices.
 		makeBoundingTriangles(inputVertices);
+		m_phaseTimes.m_bounding = clock.lap();
 
-		// Insert the input vertices.
-		m_vertices.insert(m_vertices.end(), inputVertices.begin(), inputVertices.end());
+		// Sort the input data vertices into the insertion order. Their input indices are kept, so 
+		// the result can refer to them.
+		size_t firstVertexIndex, endVertexIndex;
+		std::tie(firstVertexIndex, endVertexIndex) = appendSorted(inputVertices, 0);
 
-		// Sort the input data vertices by x-coordinate.
-		size_t firstVertexIndex = size_t(KnownVertices::COUNT);
-		auto beginIt = m_vertices.begin() + firstVertexIndex;
-		std::sort(beginIt, m_vertices.end(), compareVectorByXCoord);
+		m_phaseTimes.m_sort = clock.lap();
 
 
 		// INSERTING THE VERTICES
 		// ======================
 
-		size_t totalVertexCount = m_vertices.size();
-		for (size_t iVertex = firstVertexIndex; iVertex < totalVertexCount; ++iVertex) {
-			Vector3d & vertex = m_vertices[iVertex];
-			Vector2d vertex2D = toVector2d(vertex);
+		insertRange(firstVertexIndex, endVertexIndex, [this](size_t iVertex) { insertVertex(iVertex); });
+
+		m_rejectedConstraintCount = 0;
+		if (m_constraints.empty() == false)
+			insertConstraints();
+
+		if (m_minAngle > 0.0 || m_maxArea > 0.0)
+			refine();
+
+		m_phaseTimes.m_insertion = clock.lap();
+	}
+
+	bool BowyerWatson2D::insertMore(const vector<Vector3d> & inputVertices, size_t firstInputIndex)
+	{
+		// The bounding triangles can not grow, so the vertices outside of them need a new 
+		// triangulation.
+		const Vector3d minCorner = m_vertices[size_t(KnownVertices::BBOX_LB)];
+		const Vector3d maxCorner = m_vertices[size_t(KnownVertices::BBOX_RT)];
+		for (const Vector3d & inputVertex : inputVertices) {
+			Vector3d vertex = m_vertices.round(inputVertex);
+			bool isInside = (minCorner.x() < vertex.x()) && (vertex.x() < maxCorner.x())
+				&& (minCorner.y() < vertex.y()) && (vertex.y() < maxCorner.y());
+
+			if (isInside == false)
+				return false;
+		}
+
+		size_t firstVertexIndex, endVertexIndex;
+		std::tie(firstVertexIndex, endVertexIndex) = appendSorted(inputVertices, firstInputIndex);
+
+		for (size_t iVertex = firstVertexIndex; iVertex < endVertexIndex; ++iVertex) {
+			insertVertex(iVertex);
+		}
+
+		return true;
+	}
+
+	Mesh* BowyerWatson2D::invoke(const vector<Vector3d> & inputVertices)
+	{
+		triangulate(inputVertices);
 
-			vector<Edge> badEdges;
+		PhaseClock clock;
+		Mesh* mesh = convertTriangulationIntoMesh();
+		m_phaseTimes.m_conversion = clock.lap();
 
-			size_t triangleCount = m_currentTriangulation.size();
-			for (size_t iTriangle = 0; iTriangle < triangleCount; ++iTriangle) {
-				Triangle & triangle = m_currentTriangulation[iTriangle];
+		return mesh;
+	}
 
-				if (triangle.containsInCircumCircle(vertex2D)) {
-					// Triangle is bad, it must be cut out.
-					triangle.m_isBad = true;
-					auto triangleEdges = triangle.getEdges(*this);
-					badEdges.insert(badEdges.end(), triangleEdges.begin(), triangleEdges.end());
+	vector<size_t> BowyerWatson2D::invokeEdges(const vector<Vector3d> & inputVertices)
+	{
+		triangulate(inputVertices);
+		PhaseClock clock;
+
+		// An edge inside of the triangulation is shared by two triangles and it is reported only
+		// by the one with the lower index.
+		vector<size_t> edges;
+		edges.reserve(6 * m_inputIndices.size());
+		m_currentTriangulation.forEachLive(
+			[this, &edges](size_t index, Triangle & triangle) {
+				if (triangle.isBounding(*this))
+					return;
+
+				for (size_t i = 0; i < 3; ++i) {
+					size_t neighborIndex = triangle.m_neighbors[i];
+					bool isHull = (neighborIndex == NO_NEIGHBOR) || m_currentTriangulation[neighborIndex].isBounding(*this);
+					if (isHull || index < neighborIndex) {
+						edges.push_back(inputIndex(triangle.m_v[(i + 1) % 3]));
+						edges.push_back(inputIndex(triangle.m_v[(i + 2) % 3]));
+					}
 				}
 			}
+		);
 
-			// Simply remove all the bad triangles.
-			m_currentTriangulation.erase(
-				std::remove_if(
-					m_currentTriangulation.begin(),
-					m_currentTriangulation.end(),
-					[this](const Triangle & t) { return t.m_isBad; }
-				), 
-				m_currentTriangulation.end()
-			);
-
-			// Construct the polygon that forms the boundary of the bad triangles
-			// and create new triangles from this polygon.
-			std::sort(badEdges.begin(), badEdges.end());
-			for_each_nonrepeating(
-				badEdges.begin(), 
-				badEdges.end(),
-				[this, iVertex](Edge & edge) {
-					m_currentTriangulation.push_back(edge.formTriangle(*this, iVertex));
+		m_phaseTimes.m_conversion = clock.lap();
+		return edges;
+	}
+
+	vector<size_t> BowyerWatson2D::invokeAdjacency(const vector<Vector3d> & inputVertices)
+	{
+		triangulate(inputVertices);
+		PhaseClock clock;
+
+		// The triangles are numbered in the order of their slots, skipping the bounding ones.
+		vector<size_t> triangleNumbers(m_currentTriangulation.size(), NO_TRIANGLE);
+		size_t triangleCount = 0;
+		m_currentTriangulation.forEachLive(
+			[this, &triangleNumbers, &triangleCount](size_t index, Triangle & triangle) {
+				if (triangle.isBounding(*this) == false)
+					triangleNumbers[index] = triangleCount++;
+			}
+		);
+
+		vector<size_t> adjacency;
+		adjacency.reserve(6 * triangleCount);
+		m_currentTriangulation.forEachLive(
+			[this, &triangleNumbers, &adjacency](size_t, Triangle & triangle) {
+				if (triangle.isBounding(*this))
+					return;
+
+				for (size_t i = 0; i < 3; ++i)
+					adjacency.push_back(inputIndex(triangle.m_v[i]));
+
+				for (size_t i = 0; i < 3; ++i) {
+					size_t neighborIndex = triangle.m_neighbors[i];
+					adjacency.push_back((neighborIndex == NO_NEIGHBOR) ? NO_TRIANGLE : triangleNumbers[neighborIndex]);
 				}
-			);
-		}
+			}
+		);
+
+		m_phaseTimes.m_conversion = clock.lap();
+		return adjacency;
+	}
+
+	void BowyerWatson2D::invokeStreamed(const vector<Vector3d> & inputVertices, ITriangleSink & sink)
+	{
+		triangulate(inputVertices);
+		PhaseClock clock;
+
+		size_t triangleCount = 0;
+		m_currentTriangulation.forEachLive(
+			[this, &triangleCount](size_t, Triangle & triangle) {
+				if (triangle.isBounding(*this) == false)
+					++triangleCount;
+			}
+		);
+
+		sink.begin(triangleCount);
+		m_currentTriangulation.forEachLive(
+			[this, &sink](size_t, Triangle & triangle) {
+				if (triangle.isBounding(*this) == false)
+					sink.triangle(inputIndex(triangle.m_v[0]), inputIndex(triangle.m_v[1]), inputIndex(triangle.m_v[2]));
+			}
+		);
 
-		return convertTriangulationIntoMesh();
+		m_phaseTimes.m_conversion = clock.lap();
 	}
 
 }
\ No newline at end of file
@@ -1,67 +1,228 @@
 #pragma once
+#include "BowyerWatson.h"
+#include "FaceMatcher.h"
 
 namespace delaunay {
 
+	/// The faces that the 2D algorithms store for each triangle of the returned Mesh.
+	enum class FaceSides {
+		/// \brief Each triangle is stored twice, once facing up (in the direction of the z-axis) 
+		/// and once facing down.
+		DOUBLE_SIDED,
+		/// Each triangle is stored once, facing up.
+		SINGLE_SIDED
+	};
+
 	/// \brief Interface class for general 2D delaunay algorithm that can be invoked on collection
 	/// of vertices.
 	class IDelaunay2D {
 	public:
+		/// Value of a triangle index that signalizes there is no triangle.
+		static const size_t NO_TRIANGLE = size_t(-1);
+
 		/// \brief Invoke the algorithm. Constructs the triangulation that is returned in form of 
 		/// Mesh instance. (The caller is responsible for freeing the returned Mesh)
 		virtual Mesh* invoke(const std::vector<Eigen::Vector3d> & vertices) = 0;
+
+		/// \brief Invoke the algorithm. Returns the edges of the triangulation, each as a pair of 
+		/// consecutive input vertex indices.
+		virtual std::vector<size_t> invokeEdges(const std::vector<Eigen::Vector3d> & vertices) = 0;
+
+		/// \brief Invoke the algorithm. Returns the triangles of the triangulation, each as 6 
+		/// consecutive indices: the input vertex indices in counter-clockwise order, followed by 
+		/// the indices of the triangles opposite to them (NO_TRIANGLE on the convex hull).
+		virtual std::vector<size_t> invokeAdjacency(const std::vector<Eigen::Vector3d> & vertices) = 0;
+
+		/// Returns the statistics of the last invocation.
+		virtual RunStatistics statistics() const = 0;
 	};
 
+	/// \brief Receiver of the triangles of a triangulation, which lets the caller store them in
+	/// its own format without building a Mesh.
+	class ITriangleSink {
+	public:
+		/// Called once, before the triangles, with their count.
+		virtual void begin(size_t triangleCount) = 0;
+
+		/// Called for each triangle with the input indices of its vertices in counter-clockwise order.
+		virtual void triangle(size_t v0, size_t v1, size_t v2) = 0;
+
+		virtual ~ITriangleSink() {}
+	};
+
+	class DynamicTriangulation2D;	// forward declaration
+	class StreamingDelaunay2D;		// forward declaration
+	class Voronoi2D;				// forward declaration
+
 	/// \brief Implementation class of Bowyer-Watson algorithm for construction of 2D delaunay 
 	/// triangulation.
-	class BowyerWatson2D : public IDelaunay2D {
+	class BowyerWatson2D : public IDelaunay2D, public BowyerWatson<2, VertexScalar> {
+		friend class DynamicTriangulation2D;
+		friend class StreamingDelaunay2D;
+		friend class Voronoi2D;
+
 	public:
 		struct Triangle;		// forward declaration
 
 		/// Structure representing an edge between two vertices.
 		struct Edge {
-			size_t m_v0;	///< Index of the first vertex.
-			size_t m_v1;	///< Index of the second vertex.
+			CompactIndex m_v0;	///< Index of the first vertex.
+			CompactIndex m_v1;	///< Index of the second vertex.
 
 			Edge(BowyerWatson2D & ctx, size_t v0, size_t v1);
-
-			/// Forms a new triangle by connecting this edge with a vertex.
-			Triangle formTriangle(BowyerWatson2D & ctx, size_t vertex);
 		};
 
-		/// Structure representing a triangle formed by three vertices.
+		/// Largest lower bound on the angles of the refined triangles (in degrees).
+		static const double MAX_MIN_ANGLE;
+		/// \brief Length of the shortest refined edges, in float epsilons of the largest coordinate.
+		static const double MIN_EDGE_ULPS;
+
+		/// \brief Structure representing a triangle formed by three vertices.
+		///
+		/// The vertices are always stored in counter-clockwise order. The i-th neighbor is the 
+		/// triangle that shares the edge opposite to the i-th vertex.
 		struct Triangle {
-			size_t m_v0;	///< Index of the first vertex.
-			size_t m_v1;	///< Index of the second vertex.
-			size_t m_v2;	///< Index of the third vertex.
+			/// The bit of the flags that marks a to-be-deleted triangle.
+			static const unsigned BAD_FLAG = 1u << 3;
+
+			std::array<CompactIndex, 3> m_v;			///< Indices of the vertices.
+			std::array<CompactIndex, 3> m_neighbors;	///< Indices of the neighboring triangles.
 
-			Eigen::Vector2d m_circumCenter;	///< Cached center of circumscribed circle.
-			double m_circumRadiusSquared;	///< Cached squared radius of circumscribed circle.
-			bool m_isBad = false;			///< A flag that marks to-be-deleted triangles.
+			/// \brief Flags of the edges (opposite to the vertices) that are constrained segments in
+			/// the bits 0-2 and the flag of a to-be-deleted triangle in the bit 3.
+			unsigned char m_flags = 0;
 
 			Triangle(BowyerWatson2D & ctx, size_t v0, size_t v1, size_t v2);
 
-			/// Returns collection of all the edges of this triangle.
-			std::vector<Edge> getEdges(BowyerWatson2D & ctx);
+			/// Tells if the triangle is marked to be deleted.
+			bool isBad() const { return (m_flags & BAD_FLAG) != 0; }
+
+			/// Marks the triangle to be deleted, or unmarks it.
+			void setBad(bool isBad) { m_flags = (unsigned char)(isBad ? (m_flags | BAD_FLAG) : (m_flags & ~BAD_FLAG)); }
+
+			/// Tells if the edge opposite to the given vertex is a constrained segment.
+			bool isConstrained(size_t edge) const { return ((m_flags >> edge) & 1u) != 0; }
+
+			/// Marks the edge opposite to the given vertex as a constrained segment, or unmarks it.
+			void setConstrained(size_t edge, bool isConstrained) {
+				unsigned bit = 1u << edge;
+				m_flags = (unsigned char)(isConstrained ? (m_flags | bit) : (m_flags & ~bit));
+			}
+
+			/// Returns all the edges of this triangle.
+			std::array<Edge, 3> getEdges(BowyerWatson2D & ctx);
 
 			/// \brief Checks whether the given point is contained inside the circumscribed circle 
-			/// of this triangle. 
-			bool containsInCircumCircle(const Eigen::Vector2d & point);
+			/// of this triangle. (Points lying exactly on the circle are not contained.)
+			bool containsInCircumCircle(BowyerWatson2D & ctx, const Eigen::Vector2d & point);
+
+			/// The same test on a point of the plane XY, as called by BowyerWatson::findCavity().
+			bool containsInCircumsphere(BowyerWatson2D & ctx, const Eigen::Vector3d & point) {
+				return containsInCircumCircle(ctx, Eigen::Vector2d(point.x(), point.y()));
+			}
 
 			/// \brief Tells if this triangle contains the virtual bounding vertex, i.e. it is not
 			/// a part of the returned triangulation.
 			bool isBounding(BowyerWatson2D & ctx);
+
+			/// \brief Tells if the given point (of the plane XY) lies strictly on the inner side of 
+			/// the edge opposite to the given vertex.
+			bool seesFacet(BowyerWatson2D & ctx, size_t vertex, const Eigen::Vector3d & point);
 		};
 
 	private:
 		using vertexCollection = std::vector<Eigen::Vector3d>;
 		using edgeCollection = std::vector<Edge>;
-		using triangleCollection = std::vector<Triangle>;
+		using trianglePool = ElementPool<Triangle>;
 
-		/// The input vertices that are to be triangulated.
-		vertexCollection m_vertices = std::vector<Eigen::Vector3d>();
+		/// The faces of the returned Mesh.
+		FaceSides m_faceSides;
 		/// Current triangulation. After each vertex insertion it should hold valid 2D delaunay
 		/// triangulation.
-		triangleCollection m_currentTriangulation = std::vector<Triangle>();
+		trianglePool m_currentTriangulation = trianglePool();
+
+		// Scratch buffers of insertVertex(). They are kept between the insertions, so that no 
+		// memory is allocated once they grow to the size of the largest cavity.
+
+		/// Indices of the bad triangles of the current cavity.
+		std::vector<size_t> m_badTriangles = std::vector<size_t>();
+		/// New triangles that fill the current cavity.
+		std::vector<Triangle> m_newTriangles = std::vector<Triangle>();
+		/// Edge indices in the outer neighbors that point back to the new triangles.
+		std::vector<size_t> m_outerEdges = std::vector<size_t>();
+		/// Pairs up the edges shared by the new triangles.
+		FaceMatcher<Edge> m_innerEdges = FaceMatcher<Edge>();
+		/// \brief When set, the vertices of the triangles released by each insertion are appended
+		/// to it, three for each triangle.
+		std::vector<size_t> * m_releasedVertices = nullptr;
+
+		/// Constrained segments, each given by two consecutive input vertex indices.
+		std::vector<size_t> m_constraints = std::vector<size_t>();
+		/// Number of the constrained segments that could not be inserted by the last invocation.
+		size_t m_rejectedConstraintCount = 0;
+
+		// Scratch buffers of insertConstraints().
+
+		/// Some triangle incident to each vertex, or NO_NEIGHBOR when there is none.
+		std::vector<size_t> m_vertexTriangles = std::vector<size_t>();
+		/// \brief Vertices of the cavity on the left (right) of the inserted segment, from its 
+		/// start to its end.
+		std::vector<size_t> m_leftChain = std::vector<size_t>();
+		std::vector<size_t> m_rightChain = std::vector<size_t>();
+		/// Sub-polygons waiting to be triangulated, see triangulatePseudoPolygon().
+		std::vector<std::array<size_t, 4>> m_polygonStack = std::vector<std::array<size_t, 4>>();
+
+		/// Lower bound on the angles of the refined triangles in degrees, or 0 when there is none.
+		double m_minAngle = 0.0;
+		/// Upper bound on the areas of the refined triangles, or 0 when there is none.
+		double m_maxArea = 0.0;
+
+		// State of refine().
+
+		/// Triangle that does not meet the quality bounds, waiting to be refined.
+		struct BadTriangle {
+			double m_priority;				///< How much the triangle violates the bounds.
+			size_t m_index;					///< Index of the triangle.
+			std::array<CompactIndex, 3> m_v;	///< Its vertices, to recognize a reused slot.
+
+			bool operator<(const BadTriangle & other) const { return m_priority < other.m_priority; }
+		};
+
+		/// Constrained edge whose diametral circle contains a vertex, waiting to be split.
+		struct EncroachedSegment {
+			size_t m_index;		///< Index of a triangle that contains the edge.
+			size_t m_edge;		///< Index of the edge in the triangle.
+			size_t m_v0;		///< The vertices of the edge, to recognize a changed triangle.
+			size_t m_v1;
+		};
+
+		/// The bad triangles, the worst one on the top.
+		std::priority_queue<BadTriangle> m_badQueue = std::priority_queue<BadTriangle>();
+		/// The encroached segments, they are split before any bad triangle is refined.
+		std::vector<EncroachedSegment> m_encroachedSegments = std::vector<EncroachedSegment>();
+		/// Triangles whose circle contains the circumcenter that is to be inserted.
+		std::vector<size_t> m_refinementCavity = std::vector<size_t>();
+		/// Squared sine of the minimal angle.
+		double m_sinMinAngleSquared = 0.0;
+		/// Squared length of the shortest edges that are refined, which ensures termination.
+		double m_minEdgeLengthSquared = 0.0;
+		/// Index of the first vertex inserted by the refinement, the ones before it are the input.
+		size_t m_firstRefinementVertex = 0;
+		/// \brief Ends of the input segment that each vertex inserted by the refinement splits, 
+		/// NO_NEIGHBOR for the circumcenters.
+		std::vector<std::array<size_t, 2>> m_splitSegments = std::vector<std::array<size_t, 2>>();
+
+		// Scratch buffers of removeVertex().
+
+		/// Vertices of the link polygon of the removed vertex, in counter-clockwise order.
+		std::vector<size_t> m_linkVertices = std::vector<size_t>();
+		/// \brief Triangle behind each edge of the link polygon, together with the index of the 
+		/// edge inside of it.
+		std::vector<std::pair<size_t, size_t>> m_linkNeighbors = std::vector<std::pair<size_t, size_t>>();
+		/// Previous and next remaining vertex of each vertex of the link polygon.
+		std::vector<std::pair<size_t, size_t>> m_linkSiblings = std::vector<std::pair<size_t, size_t>>();
+		/// Marks the vertices of the link polygon whose ears are cut off.
+		std::vector<bool> m_linkIsCut = std::vector<bool>();
 
 		/// \brief Construct the starting triangulation that contains all the input vertices. 
 		///
@@ -70,12 +231,141 @@ namespace delaunay {
 		/// triangulation.
 		void makeBoundingTriangles(const vertexCollection & vertices);
 
+		/// Constructs the starting triangulation of the box with given corners.
+		void makeBoundingTriangles(const Eigen::Vector3d & minCorner, const Eigen::Vector3d & maxCorner);
+
+		/// Computes the circumscribed circle of the triangle with given index and caches it.
+		void cacheCircumCircle(size_t index);
+
+		/// \brief Finds the triangle that contains the given point by walking through the 
+		/// triangulation from the last created triangle.
+		size_t locateTriangle(const Eigen::Vector2d & point);
+
+		/// \brief Finds the triangle that contains the given point by testing all of them. Serves
+		/// when the walk is blocked by missing neighbors.
+		size_t findContainingTriangle(const Eigen::Vector2d & point);
+
+		/// \brief Inserts the vertex with given index into the current triangulation. Only the
+		/// triangles whose circumscribed circle contains the vertex are visited.
+		void insertVertex(size_t vertexIndex);
+
+		/// \brief Checks whether the link vertices (a, b, c) form an ear of the link polygon that is
+		/// a delaunay triangle, i.e. it is convex and no other link vertex lies in its circle.
+		bool isDelaunayEar(size_t a, size_t b, size_t c);
+
+		/// \brief Removes the vertex that lies at the given point from the triangulation. Only the
+		/// triangles around the vertex are replaced, by a delaunay triangulation of the polygon 
+		/// they form. Returns false, without changing anything, when there is no such vertex.
+		bool removeVertex(const Eigen::Vector3d & point);
+
+		/// \brief Inserts the constrained segments into the triangulation of all the input 
+		/// vertices. Each segment is inserted in time proportional to the number of the 
+		/// triangles it crosses.
+		void insertConstraints();
+
+		/// \brief Returns the vertex of the triangulation that lies at the position of the given
+		/// vertex, i.e. the vertex itself, or the one it duplicates. Returns NO_NEIGHBOR when 
+		/// there is none.
+		size_t findConnectedVertex(size_t vertexIndex);
+
+		/// \brief Inserts the segment between the two vertices, up to the first vertex that lies 
+		/// on it. The triangles crossed by the segment are removed and the cavities on both sides
+		/// of it are re-triangulated. Returns the vertex where the inserted part ends, or 
+		/// NO_NEIGHBOR when the segment crosses another constrained one.
+		size_t insertSegmentPart(size_t start, size_t end);
+
+		/// \brief Triangulates the pseudo-polygon formed by the edge (start, end) and the vertices
+		/// of the chain in the given range (from start to end, on the left of the edge) by the 
+		/// constrained delaunay triangles. The triangles are appended to m_newTriangles.
+		void triangulatePseudoPolygon(size_t start, size_t end, const std::vector<size_t> & chain, size_t first, size_t last);
+
+		/// Marks the edge of the triangle (and of its neighbor) as a constrained segment.
+		void markConstrainedEdge(size_t index, size_t edge);
+
+		/// \brief Refines the triangulation by the algorithm of J. Ruppert (A Delaunay Refinement
+		/// Algorithm for Quality 2-Dimensional Mesh Generation, 1995), until all the triangles 
+		/// meet the angle and area bounds. The convex hull is kept as the boundary.
+		void refine();
+
+		/// \brief Puts the triangle into the queue when it does not meet the bounds, and its 
+		/// encroached constrained edges into the list.
+		void enqueueRefinement(size_t index);
+
+		/// \brief Tells if the diametral circle of the constrained edge contains the vertex 
+		/// opposite to it on any side.
+		bool isEncroached(size_t index, size_t edge);
+
+		/// \brief Splits the constrained edge, both halves stay constrained. Returns false when the
+		/// edge is too short to be split. An edge by an input vertex is split at a power of two 
+		/// distance from it (concentric shells), so the segments meeting there are split at the
+		/// same distances. Other edges are split by their midpoint.
+		bool splitSegment(size_t index, size_t edge);
+
+		/// Returns the ends of the input segment that contains the constrained edge.
+		std::array<size_t, 2> inputSegment(size_t v0, size_t v1) const;
+
+		/// \brief Tells if the edge joins two input segments that meet at an angle below 60 degrees,
+		/// at the same distance from their common vertex. The small input angle forces a skinny 
+		/// triangle by such an edge, so it is not refined by the angle bound (J. R. Shewchuk, 
+		/// Delaunay Refinement Algorithms for Triangular Mesh Generation, 2002).
+		bool isSeditious(size_t v0, size_t v1) const;
+
+		/// \brief Walks from the triangle to the one that contains the point, without crossing
+		/// the constrained edges. When one of them blocks the walk, returns NO_NEIGHBOR and sets 
+		/// the blocking triangle and edge.
+		size_t locateVisibleTriangle(size_t start, const Eigen::Vector2d & point, size_t & blockingIndex, size_t & blockingEdge);
+
+		/// \brief Appends the vertex created by the refinement, numbered after the input vertices, 
+		/// and returns its index. The segment is the input one that the vertex splits.
+		size_t addSteinerVertex(const Eigen::Vector3d & vertex, const std::array<size_t, 2> & segment);
+
+		/// Constructs the delaunay triangulation of the input vertices.
+		void triangulate(const vertexCollection & inputVertices);
+
+		/// \brief Inserts more vertices into the constructed triangulation, numbering them from the
+		/// given input index. Returns false, without inserting anything, when some of them do not 
+		/// lie strictly inside of the bounding triangles.
+		bool insertMore(const vertexCollection & inputVertices, size_t firstInputIndex);
+
 		/// Converts the computed triangulation into 3ds Max Mesh structure. 
 		Mesh* convertTriangulationIntoMesh();
 
 	public:
+		explicit BowyerWatson2D(InsertionOrder insertionOrder = InsertionOrder::BRIO, FaceSides faceSides = FaceSides::DOUBLE_SIDED)
+			: BowyerWatson(insertionOrder), m_faceSides(faceSides)
+		{ }
+
 		virtual Mesh* invoke(const std::vector<Eigen::Vector3d> & vertices) override;
+		virtual std::vector<size_t> invokeEdges(const std::vector<Eigen::Vector3d> & vertices) override;
+		virtual std::vector<size_t> invokeAdjacency(const std::vector<Eigen::Vector3d> & vertices) override;
+		virtual RunStatistics statistics() const override { return RunStatistics{ m_phaseTimes, m_counters, m_currentTriangulation.peakCount() }; }
 		virtual ~BowyerWatson2D() {}
+
+		/// \brief Sets the segments that are kept as edges by the following invocations, each
+		/// given by two consecutive input vertex indices. The result is then the constrained 
+		/// delaunay triangulation. The segments are split at the vertices that lie on them. The 
+		/// segments must not cross, a segment is left out from the point where it crosses another
+		/// one.
+		void setConstraints(std::vector<size_t> segments) { m_constraints = std::move(segments); }
+
+		/// \brief Sets the bounds on the triangles of the following invocations, they are then 
+		/// refined by inserting new vertices until they meet them. The minimal angle is given in 
+		/// degrees, the bounds above MAX_MIN_ANGLE are lowered to it as the refinement need not 
+		/// terminate for them. A zero disables the bound. The new vertices follow the input ones, 
+		/// their z-coordinate is interpolated from the triangulation.
+		void setRefinement(double minAngle, double maxArea) { m_minAngle = minAngle; m_maxArea = maxArea; }
+
+		/// Number of the constrained segments that were (partially) left out by the last invocation.
+		size_t rejectedConstraintCount() const { return m_rejectedConstraintCount; }
+
+		/// \brief Invoke the algorithm. The triangles are passed to the sink one by one, instead
+		/// of being converted into a Mesh.
+		void invokeStreamed(const std::vector<Eigen::Vector3d> & vertices, ITriangleSink & sink);
+
+		/// \brief Returns the lower left and the upper right corner of the bounding triangles that
+		/// are built for the given vertices. The triangles whose circumcircles contain a corner are
+		/// not a part of the result.
+		static std::pair<Eigen::Vector3d, Eigen::Vector3d> boundingBox(const std::vector<Eigen::Vector3d> & vertices);
 	};
 
 }
\ No newline at end of file
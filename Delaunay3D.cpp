@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Delaunay3D.h"
 #include "Common.h"
+#include "Predicates.h"
 
 using Eigen::Vector3d;
 using Eigen::Vector2d;
@@ -28,16 +29,44 @@ namespace delaunay {
 		COUNT				///< Signalizes how many known vertices there are.
 	};
 
+	/// \brief Vertices of the face opposite to the i-th vertex of a tetrahedron, ordered so that
+	/// the face is counter-clockwise when looked at from the outside.
+	static const size_t OUTWARD_FACES[4][3] = {
+		{ 1, 2, 3 },
+		{ 0, 3, 2 },
+		{ 0, 1, 3 },
+		{ 0, 2, 1 }
+	};
+
 
 	// =============================================================================
 	// IMPLEMENTATION
 	// =============================================================================
 
+
 	// OVERLOADED OPERATORS
 	// ====================
 
-	// Following operators on Triangle struct are needed so that a collection of triangles can 
-	// be sorted, checked for repeating triangles etc.
+	// Following operators on Edge and Triangle structs are needed so that a collection of them 
+	// can be sorted, checked for repeating items etc.
+
+	inline bool operator==(const BowyerWatson3D::Edge & lhs, const BowyerWatson3D::Edge & rhs) {
+		return (lhs.m_v0 == rhs.m_v0) && (lhs.m_v1 == rhs.m_v1);
+	}
+
+	inline bool operator!=(const BowyerWatson3D::Edge & lhs, const BowyerWatson3D::Edge & rhs) {
+		return !(lhs == rhs);
+	}
+
+	inline bool operator<(const BowyerWatson3D::Edge & lhs, const BowyerWatson3D::Edge & rhs) {
+		if (lhs.m_v0 < rhs.m_v0)
+			return true;
+
+		if (lhs.m_v0 == rhs.m_v0)
+			return (lhs.m_v1 < rhs.m_v1);
+
+		return false;
+	}
 
 	inline bool operator==(const BowyerWatson3D::Triangle & lhs, const BowyerWatson3D::Triangle & rhs) {
 		return (lhs.m_v0 == rhs.m_v0) && (lhs.m_v1 == rhs.m_v1) && (lhs.m_v2 == rhs.m_v2);
@@ -67,6 +96,17 @@ namespace delaunay {
 	}
 
 
+	// BOWYER WATSON EDGE IMPLEMENTATION
+	// =================================
+
+	BowyerWatson3D::Edge::Edge(BowyerWatson3D & UNUSED(ctx), size_t v0, size_t v1)
+		: m_v0(v0), m_v1(v1)
+	{
+		if (m_v0 > m_v1)
+			std::swap(m_v0, m_v1);
+	}
+
+
 	// BOWYER WATSON TRIANGLE IMPLEMENTATION
 	// =====================================
 
@@ -84,74 +124,51 @@ namespace delaunay {
 		m_v2 = indices[2];
 	}
 
-	BowyerWatson3D::Tetrahedron BowyerWatson3D::Triangle::formTetrahedron(BowyerWatson3D & ctx, size_t vertex)
-	{
-		return Tetrahedron(ctx, m_v0, m_v1, m_v2, vertex);
-	}
-
 
 	// BOWYER WATSON TETRAHEDRON IMPLEMENTATION
 	// ========================================
 
-	BowyerWatson3D::Tetrahedron::Tetrahedron(BowyerWatson3D & ctx, size_t v0, size_t v1, size_t v2, size_t v3)
-		: m_v0(v0), m_v1(v1), m_v2(v2), m_v3(v3)
-	{
-		const Vector3d vec0 = ctx.m_vertices[v0];
-		const Vector3d vec1 = ctx.m_vertices[v1];
-		const Vector3d vec2 = ctx.m_vertices[v2];
-		const Vector3d vec3 = ctx.m_vertices[v3];
-
-		// The logic behind this is the same as in 2D version. More info can be found in 
-		// BowyerWatson2D::Triangle::Triangle() in "Delaunay2D.cpp".
-
-		Matrix3d matrix;
-		matrix.row(0) = 2.0 * (vec0 - vec1);
-		matrix.row(1) = 2.0 * (vec0 - vec2);
-		matrix.row(2) = 2.0 * (vec0 - vec3);
+	BowyerWatson3D::Tetrahedron::Tetrahedron(BowyerWatson3D & UNUSED(ctx), size_t v0, size_t v1, size_t v2, size_t v3)
+		: m_v{ { v0, v1, v2, v3 } }
+		, m_neighbors{ { NO_NEIGHBOR, NO_NEIGHBOR, NO_NEIGHBOR, NO_NEIGHBOR } }
+	{ }
 
-		Vector3d rhs;
-		rhs(0) = squareSum(vec0) - squareSum(vec1);
-		rhs(1) = squareSum(vec0) - squareSum(vec2);
-		rhs(2) = squareSum(vec0) - squareSum(vec3);
-
-		Vector3d circumCenter = matrix.fullPivLu().solve(rhs);
-		Vector3d vec0d = vec0 - circumCenter;
-		double circumRadiusSquared = squareSum(vec0d);
-
-		m_circumCenter = circumCenter;
-		m_circumRadiusSquared = circumRadiusSquared;
+	std::array<BowyerWatson3D::Triangle, 4> BowyerWatson3D::Tetrahedron::getTriangles(BowyerWatson3D & ctx)
+	{
+		return { {
+			Triangle(ctx, m_v[0], m_v[1], m_v[2]),
+			Triangle(ctx, m_v[0], m_v[1], m_v[3]),
+			Triangle(ctx, m_v[0], m_v[2], m_v[3]),
+			Triangle(ctx, m_v[1], m_v[2], m_v[3])
+		} };
 	}
 
-	std::vector<BowyerWatson3D::Triangle> BowyerWatson3D::Tetrahedron::getTriangles(BowyerWatson3D & ctx)
+	BowyerWatson3D::Triangle BowyerWatson3D::Tetrahedron::getFace(BowyerWatson3D & ctx, size_t vertex)
 	{
-		vector<BowyerWatson3D::Triangle> result;
-		result.push_back(Triangle(ctx, m_v0, m_v1, m_v2));
-		result.push_back(Triangle(ctx, m_v0, m_v1, m_v3));
-		result.push_back(Triangle(ctx, m_v0, m_v2, m_v3));
-		result.push_back(Triangle(ctx, m_v1, m_v2, m_v3));
-		return result;
+		return Triangle(ctx, m_v[(vertex + 1) % 4], m_v[(vertex + 2) % 4], m_v[(vertex + 3) % 4]);
 	}
 
-	bool BowyerWatson3D::Tetrahedron::containsInCircumSphere(const Eigen::Vector3d & point)
+	std::array<size_t, 3> BowyerWatson3D::Tetrahedron::getOutwardFace(size_t vertex) const
 	{
-		double d = m_circumRadiusSquared;
-		d -= square(point.x() - m_circumCenter.x());
-		d -= square(point.y() - m_circumCenter.y());
-		d -= square(point.z() - m_circumCenter.z());
+		return { { m_v[OUTWARD_FACES[vertex][0]], m_v[OUTWARD_FACES[vertex][1]], m_v[OUTWARD_FACES[vertex][2]] } };
+	}
 
-		if (d > 0.0) {
-			return true;
-		}
+	bool BowyerWatson3D::Tetrahedron::containsInCircumsphere(BowyerWatson3D & ctx, const Eigen::Vector3d & point)
+	{
+		const Vector3d & vec0 = ctx.m_vertices[m_v[0]];
+		const Vector3d & vec1 = ctx.m_vertices[m_v[1]];
+		const Vector3d & vec2 = ctx.m_vertices[m_v[2]];
+		const Vector3d & vec3 = ctx.m_vertices[m_v[3]];
 
-		return false;
+		return insphere(vec0, vec1, vec2, vec3, point) > 0.0;
 	}
 
 	bool BowyerWatson3D::Tetrahedron::isBounding(BowyerWatson3D & UNUSED(ctx))
 	{
-		bool v0_bounding = m_v0 < size_t(KnownVertices::COUNT);
-		bool v1_bounding = m_v1 < size_t(KnownVertices::COUNT);
-		bool v2_bounding = m_v2 < size_t(KnownVertices::COUNT);
-		bool v3_bounding = m_v3 < size_t(KnownVertices::COUNT);
+		bool v0_bounding = m_v[0] < size_t(KnownVertices::COUNT);
+		bool v1_bounding = m_v[1] < size_t(KnownVertices::COUNT);
+		bool v2_bounding = m_v[2] < size_t(KnownVertices::COUNT);
+		bool v3_bounding = m_v[3] < size_t(KnownVertices::COUNT);
 
 		if (v0_bounding || v1_bounding || v2_bounding || v3_bounding)
 			return true;
@@ -159,6 +176,17 @@ namespace delaunay {
 			return false;
 	}
 
+	bool BowyerWatson3D::Tetrahedron::seesFacet(BowyerWatson3D & ctx, size_t vertex, const Vector3d & point)
+	{
+		// The point is on the inner side of the face exactly when the tetrahedron formed by the
+		// face and the point (put in place of the opposite vertex) keeps the positive orientation.
+		std::array<Vector3d, 4> vecs;
+		for (size_t i = 0; i < 4; ++i)
+			vecs[i] = (i == vertex) ? point : ctx.m_vertices[m_v[i]];
+
+		return orient3d(vecs[0], vecs[1], vecs[2], vecs[3]) > 0.0;
+	}
+
 
 	// BOWYER WATSON ALGORITHM IMPLEMENTATION
 	// ======================================
@@ -193,12 +221,17 @@ namespace delaunay {
 		double dz = zMax - zMin;
 		double maxD = std::max(dx, std::max(dy, dz));
 
-		double left = xMin - maxD;
-		double right = xMax + maxD;
-		double top = yMax + maxD;
-		double bottom = yMin - maxD;
-		double front = zMax + maxD;
-		double back = zMin - maxD;
+		makeBoundingTetrahedrons(Vector3d(xMin - maxD, yMin - maxD, zMin - maxD), Vector3d(xMax + maxD, yMax + maxD, zMax + maxD));
+	}
+
+	void BowyerWatson3D::makeBoundingTetrahedrons(const Vector3d & minCorner, const Vector3d & maxCorner)
+	{
+		double left = minCorner.x();
+		double right = maxCorner.x();
+		double top = maxCorner.y();
+		double bottom = minCorner.y();
+		double front = maxCorner.z();
+		double back = minCorner.z();
 
 		Vector3d lbf(left, bottom, front);
 		Vector3d rbf(right, bottom, front);
@@ -218,32 +251,230 @@ namespace delaunay {
 		size_t rtbIndex = size_t(KnownVertices::BBOX_RTB);
 		size_t ltbIndex = size_t(KnownVertices::BBOX_LTB);
 
+		// The bounding tetrahedrons take the first slots, so the previous invocation is forgotten.
+		m_currentTetrahedration.clear();
+		clearVertices();
 		m_vertices.resize(size_t(KnownVertices::COUNT));
-		m_vertices[lbfIndex] = lbf;
-		m_vertices[rbfIndex] = rbf;
-		m_vertices[rtfIndex] = rtf;
-		m_vertices[ltfIndex] = ltf;
-		m_vertices[lbbIndex] = lbb;
-		m_vertices[rbbIndex] = rbb;
-		m_vertices[rtbIndex] = rtb;
-		m_vertices[ltbIndex] = ltb;
-
-		m_currentTetrahedration.push_back(Tetrahedron(*this, lbfIndex, rbbIndex, lbbIndex, ltbIndex));
-		m_currentTetrahedration.push_back(Tetrahedron(*this, lbfIndex, rbbIndex, rbfIndex, rtfIndex));
-		m_currentTetrahedration.push_back(Tetrahedron(*this, ltbIndex, rtfIndex, ltfIndex, lbfIndex));
-		m_currentTetrahedration.push_back(Tetrahedron(*this, ltbIndex, rtfIndex, rtbIndex, rbbIndex));
-		m_currentTetrahedration.push_back(Tetrahedron(*this, ltbIndex, rtfIndex, lbfIndex, rbbIndex));
+		m_vertices.set(lbfIndex, lbf);
+		m_vertices.set(rbfIndex, rbf);
+		m_vertices.set(rtfIndex, rtf);
+		m_vertices.set(ltfIndex, ltf);
+		m_vertices.set(lbbIndex, lbb);
+		m_vertices.set(rbbIndex, rbb);
+		m_vertices.set(rtbIndex, rtb);
+		m_vertices.set(ltbIndex, ltb);
+
+		m_currentTetrahedration.allocate(Tetrahedron(*this, lbfIndex, rbbIndex, lbbIndex, ltbIndex));
+		m_currentTetrahedration.allocate(Tetrahedron(*this, lbfIndex, rbbIndex, rbfIndex, rtfIndex));
+		m_currentTetrahedration.allocate(Tetrahedron(*this, ltbIndex, rtfIndex, ltfIndex, lbfIndex));
+		m_currentTetrahedration.allocate(Tetrahedron(*this, ltbIndex, rtfIndex, rtbIndex, rbbIndex));
+		m_currentTetrahedration.allocate(Tetrahedron(*this, ltbIndex, rtfIndex, lbfIndex, rbbIndex));
+
+		// Make all the tetrahedrons positively oriented and connect the ones sharing a face.
+		size_t tetraCount = m_currentTetrahedration.size();
+		for (size_t iTetra = 0; iTetra < tetraCount; ++iTetra) {
+			Tetrahedron & tetra = m_currentTetrahedration[iTetra];
+			const auto & v = tetra.m_v;
+			if (orient3d(m_vertices[v[0]], m_vertices[v[1]], m_vertices[v[2]], m_vertices[v[3]]) < 0.0)
+				std::swap(tetra.m_v[0], tetra.m_v[1]);
+		}
+
+		for (size_t iTetra = 0; iTetra < tetraCount; ++iTetra) {
+			for (size_t jTetra = iTetra + 1; jTetra < tetraCount; ++jTetra) {
+				Tetrahedron & tetra0 = m_currentTetrahedration[iTetra];
+				Tetrahedron & tetra1 = m_currentTetrahedration[jTetra];
+
+				for (size_t face0 = 0; face0 < 4; ++face0) {
+					for (size_t face1 = 0; face1 < 4; ++face1) {
+						Triangle triangle0 = tetra0.getFace(*this, face0);
+						Triangle triangle1 = tetra1.getFace(*this, face1);
+
+						if (triangle0 == triangle1) {
+							tetra0.m_neighbors[face0] = jTetra;
+							tetra0.setNeighborFace(face0, face1);
+							tetra1.m_neighbors[face1] = iTetra;
+							tetra1.setNeighborFace(face1, face0);
+						}
+					}
+				}
+			}
+		}
+
+		for (size_t iTetra = 0; iTetra < tetraCount; ++iTetra)
+			cacheCircumSphere(iTetra);
+
+		m_lastSimplex = 0;
+	}
+
+	void BowyerWatson3D::cacheCircumSphere(size_t index)
+	{
+		if (m_circumSpheres.size() <= index)
+			m_circumSpheres.resize(m_currentTetrahedration.size());
+
+		const Tetrahedron & tetra = m_currentTetrahedration[index];
+		const Vector3d vec0 = m_vertices[tetra.m_v[0]];
+		const Vector3d vec1 = m_vertices[tetra.m_v[1]];
+		const Vector3d vec2 = m_vertices[tetra.m_v[2]];
+		const Vector3d vec3 = m_vertices[tetra.m_v[3]];
+
+		// The logic behind this is the same as in 2D version. More info can be found in 
+		// BowyerWatson2D::cacheCircumCircle() in "Delaunay2D.cpp". The closed formula for the 
+		// center relative to the first vertex is:
+		//		X = (|b|^2 * (c x d) + |c|^2 * (d x b) + |d|^2 * (b x c)) / (2 * b.(c x d))
+
+		const Vector3d b = vec1 - vec0;
+		const Vector3d c = vec2 - vec0;
+		const Vector3d d = vec3 - vec0;
+
+		const Vector3d cd = c.cross(d);
+		const Vector3d db = d.cross(b);
+		const Vector3d bc = b.cross(c);
+		const double denominator = 2.0 * b.dot(cd);
+
+		Vector3d offset = (squareSum(b) * cd + squareSum(c) * db + squareSum(d) * bc) / denominator;
+
+		Vector3d circumCenter = vec0 + offset;
+		double circumRadiusSquared = squareSum(offset);
+
+		const double epsilon = std::numeric_limits<double>::epsilon();
+		const double length = std::sqrt(std::max(squareSum(b), std::max(squareSum(c), squareSum(d))));
+		const double length3 = length * length * length;
+		const double centerError =
+			64.0 * epsilon * (length3 * length + std::sqrt(circumRadiusSquared) * length3) / std::abs(denominator)
+			+ 4.0 * epsilon * circumCenter.cwiseAbs().maxCoeff();
+
+		m_circumSpheres.set(index, circumCenter, circumRadiusSquared, centerError);
+	}
+
+	size_t BowyerWatson3D::locateTetrahedron(const Vector3d & point)
+	{
+		// The bounding tetrahedrons contain all the vertices, so the walk is never blocked.
+		bool isBlocked = false;
+		return walk(m_currentTetrahedration, m_lastSimplex, point, isBlocked);
+	}
+
+	void BowyerWatson3D::fillCavity(size_t vertexIndex, const vector<size_t> & badTetrahedra, vector<Tetrahedron> & newTetrahedra)
+	{
+		// Each face between a bad and a good tetrahedron is connected with the new vertex. The new
+		// tetrahedron is the bad one with the opposite vertex replaced, so it stays positively 
+		// oriented.
+
+		newTetrahedra.clear();
+		for (size_t badIndex : badTetrahedra) {
+			Tetrahedron & tetra = m_currentTetrahedration[badIndex];
+
+			for (size_t face = 0; face < 4; ++face) {
+				size_t neighborIndex = tetra.m_neighbors[face];
+				if (neighborIndex != NO_NEIGHBOR && m_currentTetrahedration[neighborIndex].isBad())
+					continue;
+
+				std::array<CompactIndex, 4> v = tetra.m_v;
+				v[face] = vertexIndex;
+
+				Tetrahedron newTetra(*this, v[0], v[1], v[2], v[3]);
+				newTetra.m_neighbors[face] = neighborIndex;
+				newTetra.setNeighborFace(face, tetra.neighborFace(face));
+				newTetrahedra.push_back(newTetra);
+			}
+		}
+	}
+
+	void BowyerWatson3D::connectNewTetrahedra(size_t vertexIndex, const vector<size_t> & newIndices, FaceMatcher<Edge> & innerFaces)
+	{
+		// Cache the spheres and redirect the outer neighbors to the new tetrahedrons. Each face 
+		// incident to the new vertex contains one edge of the cavity boundary, which is shared by
+		// exactly two new tetrahedrons. These are then paired up in a hash table.
+
+		innerFaces.begin(3 * newIndices.size());
+		for (size_t iNew = 0; iNew < newIndices.size(); ++iNew) {
+			size_t index = newIndices[iNew];
+			Tetrahedron & tetra = m_currentTetrahedration[index];
+			cacheCircumSphere(index);
+
+			size_t newVertex = 0;
+			while (tetra.m_v[newVertex] != vertexIndex)
+				++newVertex;
+
+			size_t outerIndex = tetra.m_neighbors[newVertex];
+			if (outerIndex != NO_NEIGHBOR) {
+				Tetrahedron & outer = m_currentTetrahedration[outerIndex];
+				outer.m_neighbors[tetra.neighborFace(newVertex)] = index;
+				outer.setNeighborFace(tetra.neighborFace(newVertex), newVertex);
+			}
+
+			// The face opposite to one of the other three vertices is formed by the new vertex
+			// and the edge between the remaining two.
+			for (size_t face = 0; face < 4; ++face) {
+				if (face == newVertex)
+					continue;
+
+				std::array<size_t, 2> edge;
+				size_t edgeSize = 0;
+				for (size_t i = 0; i < 4; ++i) {
+					if (i != face && i != newVertex)
+						edge[edgeSize++] = tetra.m_v[i];
+				}
+
+				size_t otherIndex, otherFace;
+				if (innerFaces.match(Edge(*this, edge[0], edge[1]), index, face, otherIndex, otherFace)) {
+					Tetrahedron & other = m_currentTetrahedration[otherIndex];
+					tetra.m_neighbors[face] = otherIndex;
+					tetra.setNeighborFace(face, otherFace);
+					other.m_neighbors[otherFace] = index;
+					other.setNeighborFace(otherFace, face);
+				}
+			}
+		}
+	}
+
+	void BowyerWatson3D::insertVertex(size_t vertexIndex)
+	{
+		const Vector3d point = m_vertices[vertexIndex];
+
+		// FINDING THE BAD TETRAHEDRONS
+		// ============================
+
+		vector<size_t> & badTetrahedra = m_badTetrahedra;
+		badTetrahedra.clear();
+		size_t startIndex = locateTetrahedron(point);
+		reportReplacedDuplicate(m_currentTetrahedration[startIndex], vertexIndex);
+		findCavity(*this, m_currentTetrahedration, startIndex, point, m_counters, badTetrahedra, [](size_t) { return true; });
+
+		// CONSTRUCTING THE NEW TETRAHEDRONS
+		// =================================
+
+		vector<Tetrahedron> & newTetrahedra = m_newTetrahedra;
+		fillCavity(vertexIndex, badTetrahedra, newTetrahedra);
+
+		// The slots of the bad tetrahedrons are released and then reused by the new ones.
+		vector<size_t> & newIndices = m_newIndices;
+		replaceSimplices(m_currentTetrahedration, badTetrahedra, newTetrahedra, newIndices);
+
+		connectNewTetrahedra(vertexIndex, newIndices, m_innerFaces);
+
+		m_lastSimplex = newIndices.back();
+		m_counters.countInsertion(badTetrahedra.size(), newTetrahedra.size());
 	}
 
 	Mesh* BowyerWatson3D::convertTetrahedrationIntoMesh()
+	{
+		if (m_output == TetrahedronOutput::SEPARATE)
+			return convertIntoSeparateTetrahedrons();
+		else
+			return convertIntoSharedFaces();
+	}
+
+	Mesh* BowyerWatson3D::convertIntoSeparateTetrahedrons()
 	{
 		// CONSTRUCTION OF THE 3DS MAX MESH
 		// ================================
 
-		size_t tetraCount = std::count_if(
-			m_currentTetrahedration.begin(),
-			m_currentTetrahedration.end(),
-			[this](Tetrahedron & tetra) { return (tetra.isBounding(*this) == false); }
+		size_t tetraCount = 0;
+		m_currentTetrahedration.forEachLive(
+			[this, &tetraCount](size_t, Tetrahedron & tetra) {
+				if (tetra.isBounding(*this) == false)
+					++tetraCount;
+			}
 		);
 
 		size_t verticesCount = 4 * tetraCount;
@@ -254,110 +485,414 @@ namespace delaunay {
 		result->setNumFaces(int(facesCount));
 
 		size_t iTetra = 0;
-		for (Tetrahedron & tetra : m_currentTetrahedration) {
-			if (tetra.isBounding(*this))
-				continue;
-
-			Vector3d vec0 = m_vertices[tetra.m_v0];
-			Vector3d vec1 = m_vertices[tetra.m_v1];
-			Vector3d vec2 = m_vertices[tetra.m_v2];
-			Vector3d vec3 = m_vertices[tetra.m_v3];
-
-			int i0 = int(iTetra) * 4 + 0;
-			int i1 = int(iTetra) * 4 + 1;
-			int i2 = int(iTetra) * 4 + 2;
-			int i3 = int(iTetra) * 4 + 3;
-
-			result->setVert(i0, toPoint3(vec0));
-			result->setVert(i1, toPoint3(vec1));
-			result->setVert(i2, toPoint3(vec2));
-			result->setVert(i3, toPoint3(vec3));
-
-			result->faces[i0].v[0] = i0;
-			result->faces[i0].v[1] = i1;
-			result->faces[i0].v[2] = i2;
+		m_currentTetrahedration.forEachLive(
+			[this, result, &iTetra](size_t, Tetrahedron & tetra) {
+				if (tetra.isBounding(*this))
+					return;
+
+				Vector3d vec0 = m_vertices[tetra.m_v[0]];
+				Vector3d vec1 = m_vertices[tetra.m_v[1]];
+				Vector3d vec2 = m_vertices[tetra.m_v[2]];
+				Vector3d vec3 = m_vertices[tetra.m_v[3]];
+
+				int i0 = int(iTetra) * 4 + 0;
+				int i1 = int(iTetra) * 4 + 1;
+				int i2 = int(iTetra) * 4 + 2;
+				int i3 = int(iTetra) * 4 + 3;
+
+				result->setVert(i0, toPoint3(vec0));
+				result->setVert(i1, toPoint3(vec1));
+				result->setVert(i2, toPoint3(vec2));
+				result->setVert(i3, toPoint3(vec3));
+
+				result->faces[i0].v[0] = i0;
+				result->faces[i0].v[1] = i1;
+				result->faces[i0].v[2] = i2;
 			
-			result->faces[i1].v[0] = i0;
-			result->faces[i1].v[1] = i1;
-			result->faces[i1].v[2] = i3;
+				result->faces[i1].v[0] = i0;
+				result->faces[i1].v[1] = i1;
+				result->faces[i1].v[2] = i3;
 
-			result->faces[i2].v[0] = i0;
-			result->faces[i2].v[1] = i2;
-			result->faces[i2].v[2] = i3;
+				result->faces[i2].v[0] = i0;
+				result->faces[i2].v[1] = i2;
+				result->faces[i2].v[2] = i3;
 
-			result->faces[i3].v[0] = i1;
-			result->faces[i3].v[1] = i2;
-			result->faces[i3].v[2] = i3;
+				result->faces[i3].v[0] = i1;
+				result->faces[i3].v[1] = i2;
+				result->faces[i3].v[2] = i3;
 
-			++iTetra;
-		}
+				++iTetra;
+			}
+		);
+
+		result->InvalidateGeomCache();
+		return result;
+	}
+
+	Mesh* BowyerWatson3D::convertIntoSharedFaces()
+	{
+		// CHOOSING THE FACES
+		// ==================
+
+		// A face lies on the boundary when there is no tetrahedron of the result behind it. A face
+		// inside of the tetrahedration is shared by two tetrahedrons and it is stored only by the
+		// one with the lower index.
+		auto isStored = [this](size_t index, Tetrahedron & tetra, size_t face) {
+			size_t neighborIndex = tetra.m_neighbors[face];
+			bool isBoundary = (neighborIndex == NO_NEIGHBOR) || m_currentTetrahedration[neighborIndex].isBounding(*this);
+
+			switch (m_output) {
+			case TetrahedronOutput::SHARED_FACES:
+				return isBoundary || (index < neighborIndex);
+			case TetrahedronOutput::BOUNDARY:
+				return isBoundary;
+			default:
+				return true;
+			}
+		};
+
+		size_t facesCount = 0;
+		m_currentTetrahedration.forEachLive(
+			[this, &isStored, &facesCount](size_t index, Tetrahedron & tetra) {
+				if (tetra.isBounding(*this))
+					return;
+
+				for (size_t face = 0; face < 4; ++face) {
+					if (isStored(index, tetra, face))
+						++facesCount;
+				}
+			}
+		);
+
+
+		// CONSTRUCTION OF THE 3DS MAX MESH
+		// ================================
+
+		// The vertices keep the indices they have in the input.
+		size_t firstVertexIndex = size_t(KnownVertices::COUNT);
+		size_t verticesCount = m_inputIndices.size();
+
+		Mesh* result = new Mesh;
+		result->setNumVerts(int(verticesCount));
+		result->setNumFaces(int(facesCount));
+
+		for (size_t i = 0; i < verticesCount; ++i)
+			result->setVert(int(m_inputIndices[i]), toPoint3(m_vertices[firstVertexIndex + i]));
+
+		size_t iFace = 0;
+		m_currentTetrahedration.forEachLive(
+			[this, result, &isStored, &iFace, firstVertexIndex](size_t index, Tetrahedron & tetra) {
+				if (tetra.isBounding(*this))
+					return;
 
+				for (size_t face = 0; face < 4; ++face) {
+					if (isStored(index, tetra, face) == false)
+						continue;
+
+					std::array<size_t, 3> vertices = tetra.getOutwardFace(face);
+					for (size_t i = 0; i < 3; ++i)
+						result->faces[iFace].v[i] = DWORD(m_inputIndices[vertices[i] - firstVertexIndex]);
+					++iFace;
+				}
+			}
+		);
 
 		result->InvalidateGeomCache();
 		return result;
 	}
 
-	Mesh* BowyerWatson3D::invoke(const std::vector<Eigen::Vector3d>& inputVertices)
+	std::pair<size_t, size_t> BowyerWatson3D::prepareInsertion(const vector<Vector3d> & inputVertices)
 	{
-		// PREPARATION PHASE
-		// =================
+		PhaseClock clock;
+		m_counters = InsertionCounters();
+
+		// A tetrahedration of n (random) vertices has about 6.5n tetrahedrons.
+		size_t expectedTetraCount = size_t(6.5 * double(inputVertices.size() + size_t(KnownVertices::COUNT)));
+		m_currentTetrahedration.reserve(expectedTetraCount);
+		m_circumSpheres.reserve(expectedTetraCount);
+		m_vertices.reserve(inputVertices.size() + size_t(KnownVertices::COUNT));
+		m_inputIndices.reserve(inputVertices.size());
 
 		// Calculate the initial triangulation which bounds the input vertices.
 		makeBoundingTetrahedrons(inputVertices);
+		m_phaseTimes.m_bounding = clock.lap();
 
-		// Insert the input vertices.
-		m_vertices.insert(m_vertices.end(), inputVertices.begin(), inputVertices.end());
+		// Sort the input data vertices into the insertion order. Their input indices are kept, so 
+		// the result can refer to them.
+		std::pair<size_t, size_t> insertedRange = appendSorted(inputVertices, 0);
 
-		// Sort the input data vertices by x-coordinate.
-		size_t firstVertexIndex = size_t(KnownVertices::COUNT);
-		auto beginIt = m_vertices.begin() + firstVertexIndex;
-		std::sort(beginIt, m_vertices.end(), compareVectorByXCoord);
+		m_phaseTimes.m_sort = clock.lap();
+		return insertedRange;
+	}
+
+	void BowyerWatson3D::triangulate(const vector<Vector3d> & inputVertices)
+	{
+		size_t firstVertexIndex, endVertexIndex;
+		std::tie(firstVertexIndex, endVertexIndex) = prepareInsertion(inputVertices);
+
+		PhaseClock clock;
+		insertRange(firstVertexIndex, endVertexIndex, [this](size_t iVertex) { insertVertex(iVertex); });
+
+		m_phaseTimes.m_insertion = clock.lap();
+	}
+
+	BowyerWatson3D::Removal BowyerWatson3D::removeVertex(const Vector3d & removedPoint)
+	{
+		// The vertices are compared as they are stored.
+		const Vector3d point = m_vertices.round(removedPoint);
 
+		// FINDING THE STAR OF THE VERTEX
+		// ==============================
 
-		// INSERTING THE VERTICES
-		// ======================
+		// The walk ends in one of the tetrahedrons around the vertex. The rest of them is found by
+		// flood-fill over the faces incident to the vertex. The faces opposite to the vertex form
+		// the boundary of the star.
 
-		size_t totalVertexCount = m_vertices.size();
-		for (size_t iVertex = firstVertexIndex; iVertex < totalVertexCount; ++iVertex) {
-			Vector3d & vertex = m_vertices[iVertex];
+		size_t startIndex = locateTetrahedron(point);
+		const Tetrahedron & start = m_currentTetrahedration[startIndex];
 
-			vector<Triangle> badTriangles;
+		size_t vertexIndex = NO_NEIGHBOR;
+		for (size_t i = 0; i < 4; ++i) {
+			if (m_vertices[start.m_v[i]] == point)
+				vertexIndex = start.m_v[i];
+		}
+
+		if (vertexIndex == NO_NEIGHBOR || vertexIndex < size_t(KnownVertices::COUNT))
+			return Removal::NOT_FOUND;
+
+		vector<size_t> & star = m_badTetrahedra;
+		star.clear();
+		m_currentTetrahedration[startIndex].setBad(true);
+		star.push_back(startIndex);
+
+		vector<BoundaryFace> & boundary = m_starBoundary;
+		vector<size_t> & link = m_linkVertices;
+		boundary.clear();
+		link.clear();
+		for (size_t iStar = 0; iStar < star.size(); ++iStar) {
+			const Tetrahedron & tetra = m_currentTetrahedration[star[iStar]];
+
+			for (size_t face = 0; face < 4; ++face) {
+				if (tetra.m_v[face] == vertexIndex) {
+					const Triangle key(*this, tetra.m_v[(face + 1) % 4], tetra.m_v[(face + 2) % 4], tetra.m_v[(face + 3) % 4]);
+					boundary.push_back({ key, tetra.m_neighbors[face], tetra.neighborFace(face), NO_NEIGHBOR, 0 });
+					continue;
+				}
+
+				link.push_back(tetra.m_v[face]);
+
+				Tetrahedron & neighbor = m_currentTetrahedration[tetra.m_neighbors[face]];
+				if (!neighbor.isBad()) {
+					neighbor.setBad(true);
+					star.push_back(tetra.m_neighbors[face]);
+				}
+			}
+		}
 
-			size_t tetraCount = m_currentTetrahedration.size();
-			for (size_t iTetra = 0; iTetra < tetraCount; ++iTetra) {
-				Tetrahedron & tetra = m_currentTetrahedration[iTetra];
+		std::sort(link.begin(), link.end());
+		link.erase(std::unique(link.begin(), link.end()), link.end());
+
+		auto byKey = [](const BoundaryFace & lhs, const BoundaryFace & rhs) { return lhs.m_key < rhs.m_key; };
+		std::sort(boundary.begin(), boundary.end(), byKey);
+
+		// TETRAHEDRATION OF THE LINK
+		// ==========================
+
+		// The faces of the star boundary belong to the delaunay tetrahedration of the link too, 
+		// so they cut out the tetrahedrons that fill the star. These are found by flood-fill from
+		// the tetrahedron that contains the point, which never crosses the boundary. Cospherical
+		// vertices can make the two tetrahedrations differ on the boundary, then the flood-fill 
+		// leaks out and the star can not be filled. The link is tetrahedrated inside of the same
+		// bounding box, so that the box vertices have the same indices and the faces incident to
+		// them stay delaunay too.
+
+		const size_t boxVertexCount = size_t(KnownVertices::COUNT);
+		vector<size_t> & inserted = m_linkInserted;
+		vertexCollection & insertedVertices = m_linkInsertedVertices;
+		inserted.clear();
+		insertedVertices.clear();
+		for (size_t linkIndex : link) {
+			if (linkIndex >= boxVertexCount) {
+				inserted.push_back(linkIndex);
+				insertedVertices.push_back(m_vertices[linkIndex]);
+			}
+		}
 
-				if (tetra.containsInCircumSphere(vertex)) {
-					// Tetrahedron is bad, it must be cut out.
-					tetra.m_isBad = true;
-					auto tetraTriangles = tetra.getTriangles(*this);
-					badTriangles.insert(badTriangles.end(), tetraTriangles.begin(), tetraTriangles.end());
+		if (m_linkTetrahedration == nullptr)
+			m_linkTetrahedration = std::make_unique<BowyerWatson3D>();
+
+		BowyerWatson3D & local = *m_linkTetrahedration;
+		local.makeBoundingTetrahedrons(m_vertices[size_t(KnownVertices::BBOX_LBB)], m_vertices[size_t(KnownVertices::BBOX_RTF)]);
+		local.insertMore(insertedVertices, 0);
+
+		auto globalIndex = [&](size_t localIndex) {
+			return (localIndex < boxVertexCount) ? localIndex : inserted[local.m_inputIndices[localIndex - boxVertexCount]];
+		};
+
+		vector<size_t> & selected = m_linkSelected;
+		vector<size_t> & newOfLocal = m_linkNewOfLocal;
+		selected.clear();
+		newOfLocal.assign(local.m_currentTetrahedration.size(), NO_NEIGHBOR);
+		size_t seedIndex = local.locateTetrahedron(point);
+		newOfLocal[seedIndex] = 0;
+		selected.push_back(seedIndex);
+
+		bool isFilled = true;
+		size_t coveredCount = 0;
+		for (size_t iSelected = 0; isFilled && iSelected < selected.size(); ++iSelected) {
+			const Tetrahedron & tetra = local.m_currentTetrahedration[selected[iSelected]];
+
+			for (size_t face = 0; isFilled && face < 4; ++face) {
+				size_t neighborIndex = tetra.m_neighbors[face];
+				if (neighborIndex != NO_NEIGHBOR && newOfLocal[neighborIndex] != NO_NEIGHBOR)
+					continue;
+
+				const Triangle key(*this,
+					globalIndex(tetra.m_v[(face + 1) % 4]),
+					globalIndex(tetra.m_v[(face + 2) % 4]),
+					globalIndex(tetra.m_v[(face + 3) % 4]));
+
+				BoundaryFace probe = { key, 0, 0, 0, 0 };
+				auto found = std::lower_bound(boundary.begin(), boundary.end(), probe, byKey);
+				if (found != boundary.end() && found->m_key == key) {
+					isFilled = (found->m_inner == NO_NEIGHBOR);
+					found->m_inner = iSelected;
+					found->m_innerFace = face;
+					++coveredCount;
+				}
+				else {
+					isFilled = (neighborIndex != NO_NEIGHBOR);
+					if (isFilled) {
+						newOfLocal[neighborIndex] = selected.size();
+						selected.push_back(neighborIndex);
+					}
 				}
 			}
+		}
+
+		if (!isFilled || coveredCount != boundary.size()) {
+			for (size_t starIndex : star)
+				m_currentTetrahedration[starIndex].setBad(false);
+			return Removal::DEGENERATE;
+		}
+
+		// FILLING THE STAR
+		// ================
+
+		// The slots of the star are released and then reused by the new tetrahedrons. Those keep
+		// the vertex order of the local ones, so the face indices of their links stay valid.
+
+		for (size_t starIndex : star)
+			m_currentTetrahedration.release(starIndex);
+
+		vector<size_t> & newIndices = m_newIndices;
+		newIndices.clear();
+		for (size_t localIndex : selected) {
+			const Tetrahedron & tetra = local.m_currentTetrahedration[localIndex];
+			Tetrahedron newTetra(*this, globalIndex(tetra.m_v[0]), globalIndex(tetra.m_v[1]), globalIndex(tetra.m_v[2]), globalIndex(tetra.m_v[3]));
+			newIndices.push_back(m_currentTetrahedration.allocate(newTetra));
+		}
+
+		for (size_t iSelected = 0; iSelected < selected.size(); ++iSelected) {
+			const Tetrahedron & localTetra = local.m_currentTetrahedration[selected[iSelected]];
+			Tetrahedron & tetra = m_currentTetrahedration[newIndices[iSelected]];
 
-			// Simply remove all the bad tetrahedrons.
-			m_currentTetrahedration.erase(
-				std::remove_if(
-					m_currentTetrahedration.begin(),
-					m_currentTetrahedration.end(),
-					[this](const Tetrahedron & t) { return t.m_isBad; }
-				),
-				m_currentTetrahedration.end()
-			);
-
-			// Construct the polytope that forms the boundary of the bad tetrahedrons
-			// and create new tetrahedrons from this polytope.
-			std::sort(badTriangles.begin(), badTriangles.end());
-			for_each_nonrepeating(
-				badTriangles.begin(),
-				badTriangles.end(),
-				[this, iVertex](Triangle & triangle) {
-					m_currentTetrahedration.push_back(triangle.formTetrahedron(*this, iVertex));
+			for (size_t face = 0; face < 4; ++face) {
+				size_t neighborIndex = localTetra.m_neighbors[face];
+				if (neighborIndex != NO_NEIGHBOR && newOfLocal[neighborIndex] != NO_NEIGHBOR) {
+					tetra.m_neighbors[face] = newIndices[newOfLocal[neighborIndex]];
+					tetra.setNeighborFace(face, localTetra.neighborFace(face));
 				}
-			);
+			}
+
+			cacheCircumSphere(newIndices[iSelected]);
+		}
+
+		for (const BoundaryFace & face : boundary) {
+			Tetrahedron & inner = m_currentTetrahedration[newIndices[face.m_inner]];
+			inner.m_neighbors[face.m_innerFace] = face.m_outer;
+			inner.setNeighborFace(face.m_innerFace, face.m_outerFace);
+
+			if (face.m_outer != NO_NEIGHBOR) {
+				Tetrahedron & outer = m_currentTetrahedration[face.m_outer];
+				outer.m_neighbors[face.m_outerFace] = newIndices[face.m_inner];
+				outer.setNeighborFace(face.m_outerFace, face.m_innerFace);
+			}
+		}
+
+		if (m_changedSlots != nullptr) {
+			m_changedSlots->insert(m_changedSlots->end(), star.begin(), star.end());
+			m_changedSlots->insert(m_changedSlots->end(), newIndices.begin(), newIndices.end());
+		}
+
+		m_lastSimplex = newIndices.back();
+		return Removal::REMOVED;
+	}
+
+	bool BowyerWatson3D::insertMore(const vector<Vector3d> & inputVertices, size_t firstInputIndex)
+	{
+		// The bounding tetrahedrons can not grow, so the vertices outside of them need a new 
+		// tetrahedration.
+		const Vector3d minCorner = m_vertices[size_t(KnownVertices::BBOX_LBB)];
+		const Vector3d maxCorner = m_vertices[size_t(KnownVertices::BBOX_RTF)];
+		for (const Vector3d & inputVertex : inputVertices) {
+			Vector3d vertex = m_vertices.round(inputVertex);
+			bool isInside = (minCorner.array() < vertex.array()).all() && (vertex.array() < maxCorner.array()).all();
+			if (isInside == false)
+				return false;
+		}
+
+		size_t firstVertexIndex, endVertexIndex;
+		std::tie(firstVertexIndex, endVertexIndex) = appendSorted(inputVertices, firstInputIndex);
+
+		for (size_t iVertex = firstVertexIndex; iVertex < endVertexIndex; ++iVertex) {
+			insertVertex(iVertex);
 		}
 
-		return convertTetrahedrationIntoMesh();
+		return true;
+	}
+
+	Mesh* BowyerWatson3D::invoke(const std::vector<Eigen::Vector3d>& inputVertices)
+	{
+		triangulate(inputVertices);
+
+		PhaseClock clock;
+		Mesh* mesh = convertTetrahedrationIntoMesh();
+		m_phaseTimes.m_conversion = clock.lap();
+
+		return mesh;
+	}
+
+	void BowyerWatson3D::invokeStreamed(const vector<Vector3d> & inputVertices, ITetrahedronSink & sink)
+	{
+		triangulate(inputVertices);
+		PhaseClock clock;
+
+		size_t tetraCount = 0;
+		m_currentTetrahedration.forEachLive(
+			[this, &tetraCount](size_t, Tetrahedron & tetra) {
+				if (tetra.isBounding(*this) == false)
+					++tetraCount;
+			}
+		);
+
+		sink.begin(tetraCount);
+
+		size_t firstVertexIndex = size_t(KnownVertices::COUNT);
+		m_currentTetrahedration.forEachLive(
+			[this, &sink, firstVertexIndex](size_t, Tetrahedron & tetra) {
+				if (tetra.isBounding(*this))
+					return;
+
+				sink.tetrahedron(
+					m_inputIndices[tetra.m_v[0] - firstVertexIndex],
+					m_inputIndices[tetra.m_v[1] - firstVertexIndex],
+					m_inputIndices[tetra.m_v[2] - firstVertexIndex],
+					m_inputIndices[tetra.m_v[3] - firstVertexIndex]);
+			}
+		);
+
+		m_phaseTimes.m_conversion = clock.lap();
 	}
 
 }
\ No newline at end of file
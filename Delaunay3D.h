@@ -1,7 +1,27 @@
 #pragma once
+#include "BowyerWatson.h"
+#include "FaceMatcher.h"
 
 namespace delaunay {
 
+	/// The form of the Mesh that the 3D algorithms return.
+	enum class TetrahedronOutput {
+		/// \brief Every tetrahedron has its own 4 vertices and 4 faces, so the faces inside of the
+		/// tetrahedration are stored twice.
+		SEPARATE,
+		/// \brief The vertices of the mesh are the input vertices and every face of the 
+		/// tetrahedration is stored once.
+		SHARED_FACES,
+		/// \brief The vertices of the mesh are the input vertices and only the faces on the 
+		/// boundary of the tetrahedration (its convex hull) are stored, facing outwards.
+		BOUNDARY,
+		/// \brief The vertices of the mesh are the input vertices and each tetrahedron is stored as
+		/// 4 consecutive faces facing outwards. The i-th face of the k-th tetrahedron (face 4k + i)
+		/// lies opposite to its i-th vertex, so the tetrahedron is formed by the first vertex of 
+		/// face 4k + 1 and the vertices of face 4k.
+		ELEMENTS
+	};
+
 	/// \brief Interface class for general 3D delaunay algorithm that can be invoked on collection
 	/// of vertices.
 	class IDelaunay3D {
@@ -9,61 +29,163 @@ namespace delaunay {
 		/// \brief Invoke the algorithm. Constructs the tetrahedration that is returned in form of 
 		/// Mesh instance. (The caller is responsible for freeing the returned Mesh)
 		virtual Mesh* invoke(const std::vector<Eigen::Vector3d> & vertices) = 0;
+
+		/// Returns the statistics of the last invocation.
+		virtual RunStatistics statistics() const = 0;
+	};
+
+	/// \brief Receiver of the tetrahedrons of a tetrahedration, which lets the caller store them 
+	/// in its own format without building a Mesh.
+	class ITetrahedronSink {
+	public:
+		/// Called once, before the tetrahedrons, with their count.
+		virtual void begin(size_t tetrahedronCount) = 0;
+
+		/// \brief Called for each tetrahedron with the input indices of its vertices. They are 
+		/// positively oriented, so the faces (v1, v2, v3), (v0, v3, v2), (v0, v1, v3) and 
+		/// (v0, v2, v1) are counter-clockwise when looked at from the outside.
+		virtual void tetrahedron(size_t v0, size_t v1, size_t v2, size_t v3) = 0;
+
+		virtual ~ITetrahedronSink() {}
 	};
 
+	class DynamicTriangulation3D;	// forward declaration
+
 	/// \brief Implementation class of Bowyer-Watson algorithm for construction of 3D delaunay 
 	/// triangulation (tetrahedration).
-	class BowyerWatson3D : public IDelaunay3D {
+	class BowyerWatson3D : public IDelaunay3D, public BowyerWatson<3, VertexScalar> {
+		friend class DynamicTriangulation3D;
+
 	public:
 		struct Tetrahedron;		// forward declaration
 
+		/// The outcome of a vertex removal.
+		enum class Removal {
+			REMOVED,		///< The vertex was removed.
+			NOT_FOUND,		///< There is no vertex at the given point.
+			/// \brief The star of the vertex could not be filled locally (due to cospherical 
+			/// vertices), nothing was changed.
+			DEGENERATE
+		};
+
+		/// Structure representing an edge between two vertices.
+		struct Edge {
+			CompactIndex m_v0;	///< Index of the first vertex.
+			CompactIndex m_v1;	///< Index of the second vertex.
+
+			Edge(BowyerWatson3D & ctx, size_t v0, size_t v1);
+		};
+
 		/// Structure representing a triangle formed by three vertices.
 		struct Triangle {
-			size_t m_v0;	///< Index of the first vertex.
-			size_t m_v1;	///< Index of the second vertex.
-			size_t m_v2;	///< Index of the third vertex.
+			CompactIndex m_v0;	///< Index of the first vertex.
+			CompactIndex m_v1;	///< Index of the second vertex.
+			CompactIndex m_v2;	///< Index of the third vertex.
 
 			Triangle(BowyerWatson3D & ctx, size_t v0, size_t v1, size_t v2);
-
-			/// Forms a new tetrahedron by connecting this triangle with a vertex.
-			Tetrahedron formTetrahedron(BowyerWatson3D & ctx, size_t vertex);
 		};
 
+		/// \brief Structure representing a tetrahedron formed by four vertices.
+		///
+		/// The vertices are always stored in positive orientation. The i-th neighbor is the 
+		/// tetrahedron that shares the face opposite to the i-th vertex. The face index of the 
+		/// shared face inside of the neighbor is stored too, so the link can be followed back.
 		struct Tetrahedron {
-			size_t m_v0;	///< Index of the first vertex.
-			size_t m_v1;	///< Index of the second vertex.
-			size_t m_v2;	///< Index of the third vertex.
-			size_t m_v3;	///< Index of the fourth vertex.
+			std::array<CompactIndex, 4> m_v;			///< Indices of the vertices.
+			std::array<CompactIndex, 4> m_neighbors;	///< Indices of the neighboring tetrahedrons.
+			unsigned char m_neighborFaces = 0;			///< Indices of the shared faces in the neighbors, two bits each.
 
-			Eigen::Vector3d m_circumCenter;	///< Cached center of circumscribed sphere.
-			double m_circumRadiusSquared;	///< Cached squared radius of circumscribed sphere.
 			bool m_isBad = false;			///< A flag that marks to-be-deleted tetrahedrons.
 
 			Tetrahedron(BowyerWatson3D & ctx, size_t v0, size_t v1, size_t v2, size_t v3);
 
-			/// Returns collection of all the triangles of this tetrahedron.
-			std::vector<Triangle> getTriangles(BowyerWatson3D & ctx);
+			/// Tells if the tetrahedron is marked to be deleted.
+			bool isBad() const { return m_isBad; }
+
+			/// Marks the tetrahedron to be deleted, or unmarks it.
+			void setBad(bool isBad) { m_isBad = isBad; }
+
+			/// The tetrahedrations have no constrained faces, the cavities spread across all of them.
+			bool isConstrained(size_t /*face*/) const { return false; }
+
+			/// Returns the index of the shared face inside of the neighbor across the given face.
+			size_t neighborFace(size_t face) const { return (m_neighborFaces >> (2 * face)) & 3u; }
+
+			/// Sets the index of the shared face inside of the neighbor across the given face.
+			void setNeighborFace(size_t face, size_t neighborFace) {
+				unsigned shift = unsigned(2 * face);
+				m_neighborFaces = (unsigned char)((m_neighborFaces & ~(3u << shift)) | (neighborFace << shift));
+			}
+
+			/// Returns all the triangles of this tetrahedron.
+			std::array<Triangle, 4> getTriangles(BowyerWatson3D & ctx);
+
+			/// Returns the face of this tetrahedron that lies opposite to the given vertex.
+			Triangle getFace(BowyerWatson3D & ctx, size_t vertex);
+
+			/// \brief Returns the vertices of the face opposite to the given vertex, ordered 
+			/// counter-clockwise when looked at from outside of the tetrahedron.
+			std::array<size_t, 3> getOutwardFace(size_t vertex) const;
 
 			/// \brief Checks whether the given point is contained inside the circumscribed sphere 
-			/// of this tetrahedron. 
-			bool containsInCircumSphere(const Eigen::Vector3d & point);
+			/// of this tetrahedron. (Points lying exactly on the sphere are not contained.)
+			bool containsInCircumsphere(BowyerWatson3D & ctx, const Eigen::Vector3d & point);
 
 			/// \brief Tells if this tetrahedron contains the virtual bounding vertex, i.e. it is 
 			/// not a part of the returned tetrahedration.
 			bool isBounding(BowyerWatson3D & ctx);
+
+			/// \brief Tells if the given point lies strictly on the inner side of the face opposite 
+			/// to the given vertex.
+			bool seesFacet(BowyerWatson3D & ctx, size_t vertex, const Eigen::Vector3d & point);
 		};
 
-	private:
+	protected:
 		using vertexCollection = std::vector<Eigen::Vector3d>;
 		using edgeCollection = std::vector<Edge>;
 		using triangleCollection = std::vector<Triangle>;
-		using tetraCollection = std::vector<Tetrahedron>;
+		using tetraPool = ElementPool<Tetrahedron>;
 
-		/// The input vertices that are to be triangulated.
-		vertexCollection m_vertices = std::vector<Eigen::Vector3d>();
+		/// The form of the returned Mesh.
+		TetrahedronOutput m_output;
 		/// Current tetrahedration. After each vertex insertion it should hold valid 3D delaunay
 		/// tetrahedration.
-		tetraCollection m_currentTetrahedration = std::vector<Tetrahedron>();
+		tetraPool m_currentTetrahedration = tetraPool();
+
+		// Scratch buffers of insertVertex(). They are kept between the insertions, so that no 
+		// memory is allocated once they grow to the size of the largest cavity.
+
+		/// Indices of the bad tetrahedrons of the current cavity.
+		std::vector<size_t> m_badTetrahedra = std::vector<size_t>();
+		/// New tetrahedrons that fill the current cavity.
+		std::vector<Tetrahedron> m_newTetrahedra = std::vector<Tetrahedron>();
+		/// Pairs up the faces shared by the new tetrahedrons.
+		FaceMatcher<Edge> m_innerFaces = FaceMatcher<Edge>();
+
+		// Scratch buffers of removeVertex().
+
+		/// \brief Boundary face of the star of the removed vertex, with the tetrahedron behind it
+		/// and the new tetrahedron that covers it.
+		struct BoundaryFace {
+			Triangle m_key;
+			size_t m_outer, m_outerFace;
+			size_t m_inner, m_innerFace;
+		};
+
+		/// Faces of the star boundary, sorted by their keys.
+		std::vector<BoundaryFace> m_starBoundary = std::vector<BoundaryFace>();
+		/// Vertices of the link of the removed vertex (the ones of the star boundary).
+		std::vector<size_t> m_linkVertices = std::vector<size_t>();
+		/// Link vertices that are inserted into the link tetrahedration, and their positions.
+		std::vector<size_t> m_linkInserted = std::vector<size_t>();
+		vertexCollection m_linkInsertedVertices = vertexCollection();
+		/// Tetrahedrons of the link tetrahedration that fill the star.
+		std::vector<size_t> m_linkSelected = std::vector<size_t>();
+		/// Position in m_linkSelected of each tetrahedron of the link tetrahedration.
+		std::vector<size_t> m_linkNewOfLocal = std::vector<size_t>();
+		/// \brief The tetrahedration of the link, created by the first removal and reused by the
+		/// next ones, so that its storage is kept too.
+		std::unique_ptr<BowyerWatson3D> m_linkTetrahedration = nullptr;
 
 		/// \brief Construct the starting tetrahedration that contains all the input vertices. 
 		///
@@ -72,12 +194,66 @@ namespace delaunay {
 		/// tetrahedration.
 		void makeBoundingTetrahedrons(const vertexCollection & vertices);
 
-		/// Converts the computed triangulation into 3ds Max Mesh structure. 
+		/// Constructs the starting tetrahedration of the box with given corners.
+		void makeBoundingTetrahedrons(const Eigen::Vector3d & minCorner, const Eigen::Vector3d & maxCorner);
+
+		/// Computes the circumscribed sphere of the tetrahedron with given index and caches it.
+		void cacheCircumSphere(size_t index);
+
+		/// \brief Finds the tetrahedron that contains the given point by walking through the 
+		/// tetrahedration from the last created tetrahedron.
+		size_t locateTetrahedron(const Eigen::Vector3d & point);
+
+		/// \brief Constructs the tetrahedrons that connect the boundary of the cavity formed by the 
+		/// bad tetrahedrons with the vertex.
+		void fillCavity(size_t vertexIndex, const std::vector<size_t> & badTetrahedra, std::vector<Tetrahedron> & newTetrahedra);
+
+		/// \brief Links the new tetrahedrons (already stored with given indices) with each other and
+		/// with the tetrahedrons around the cavity, and caches their spheres.
+		void connectNewTetrahedra(size_t vertexIndex, const std::vector<size_t> & newIndices, FaceMatcher<Edge> & innerFaces);
+
+		/// \brief Inserts the vertex with given index into the current tetrahedration. Only the
+		/// tetrahedrons whose circumscribed sphere contains the vertex are visited.
+		void insertVertex(size_t vertexIndex);
+
+		/// \brief Constructs the bounding tetrahedrons and appends the input vertices sorted into 
+		/// the insertion order. Returns the range of the vertices to insert.
+		std::pair<size_t, size_t> prepareInsertion(const vertexCollection & inputVertices);
+
+		/// Constructs the delaunay tetrahedration of the input vertices.
+		virtual void triangulate(const vertexCollection & inputVertices);
+
+		/// \brief Removes the vertex that lies at the given point from the tetrahedration. Only the
+		/// tetrahedrons around the vertex are replaced, by the ones that the delaunay tetrahedration
+		/// of its link (the vertices of the faces opposite to it) has inside of them.
+		Removal removeVertex(const Eigen::Vector3d & point);
+
+		/// \brief Inserts more vertices into the constructed tetrahedration, numbering them from 
+		/// the given input index. Returns false, without inserting anything, when some of them do
+		/// not lie strictly inside of the bounding tetrahedrons.
+		bool insertMore(const vertexCollection & inputVertices, size_t firstInputIndex);
+
+		/// Converts the computed triangulation into 3ds Max Mesh structure of the chosen form.
 		Mesh* convertTetrahedrationIntoMesh();
 
+		/// Stores every tetrahedron with its own vertices (see TetrahedronOutput::SEPARATE).
+		Mesh* convertIntoSeparateTetrahedrons();
+
+		/// Stores the faces over the input vertices (see the other TetrahedronOutput values).
+		Mesh* convertIntoSharedFaces();
+
 	public:
+		explicit BowyerWatson3D(InsertionOrder insertionOrder = InsertionOrder::BRIO, TetrahedronOutput output = TetrahedronOutput::SEPARATE)
+			: BowyerWatson(insertionOrder), m_output(output)
+		{ }
+
 		virtual Mesh* invoke(const std::vector<Eigen::Vector3d> & vertices) override;
+		virtual RunStatistics statistics() const override { return RunStatistics{ m_phaseTimes, m_counters, m_currentTetrahedration.peakCount() }; }
 		virtual ~BowyerWatson3D() {}
+
+		/// \brief Invoke the algorithm. The tetrahedrons are passed to the sink one by one, 
+		/// instead of being converted into a Mesh.
+		void invokeStreamed(const std::vector<Eigen::Vector3d> & vertices, ITetrahedronSink & sink);
 	};
 
 }
\ No newline at end of file
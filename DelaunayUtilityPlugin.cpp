@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "DelaunayUtilityPlugin.h"
+#include "Common.h"
 
 #define DelaunayUtilityPlugin_CLASS_ID	Class_ID(0x73620695, 0x651f0af4)
 #define DelaunayUtilityPlugin_FP_INTERFACE_ID Interface_ID(0x789b0621, 0xa5ef0346)
@@ -11,6 +12,13 @@ using std::make_unique;
 
 class DelaunayUtilityPlugin;
 
+/// Inputs of at least this many vertices are triangulated in 2D by the parallel algorithm.
+static const size_t PARALLEL_2D_VERTEX_COUNT = 100000;
+/// Inputs of at least this many vertices are triangulated in 3D by the parallel algorithm.
+static const size_t PARALLEL_3D_VERTEX_COUNT = 50000;
+/// The shortest time between two updates of the progress bar, in seconds.
+static const double PROGRESS_UPDATE_SECONDS = 0.1;
+
 /// Extracts the vertices from the Mesh class.
 vector<Vector3d> makeVector(Mesh* mesh) {
 	vector<Vector3d> result;
@@ -25,6 +33,224 @@ vector<Vector3d> makeVector(Mesh* mesh) {
 	return result;
 }
 
+/// \brief Extracts the chosen edges of the faces from the Mesh class, each as two consecutive 
+/// vertex indices. (An edge shared by two faces is listed twice.)
+vector<size_t> makeConstraints(Mesh* mesh, ConstraintEdges constraints) {
+	vector<size_t> result;
+	if (constraints == ConstraintEdges::NONE)
+		return result;
+
+	int faceCount = mesh->getNumFaces();
+	bool hasSelection = (mesh->edgeSel.GetSize() == 3 * faceCount);
+	for (int i = 0; i < faceCount; ++i) {
+		Face & face = mesh->faces[i];
+		for (int edge = 0; edge < 3; ++edge) {
+			bool isChosen = (constraints == ConstraintEdges::VISIBLE)
+				? (face.getEdgeVis(edge) != 0)
+				: (hasSelection && mesh->edgeSel[3 * i + edge] != 0);
+
+			if (isChosen) {
+				result.push_back(size_t(face.v[edge]));
+				result.push_back(size_t(face.v[(edge + 1) % 3]));
+			}
+		}
+	}
+
+	return result;
+}
+
+/// Extracts the points from the Tab class.
+vector<Vector3d> makeVector(const Tab<Point3> & points) {
+	vector<Vector3d> result;
+
+	size_t pointCount = size_t(points.Count());
+	result.reserve(pointCount);
+	for (size_t i = 0; i < pointCount; ++i) {
+		const Point3 & point = points[int(i)];
+		result.push_back(Vector3d(point.x, point.y, point.z));
+	}
+
+	return result;
+}
+
+/// Extracts the meshes from the Tab class.
+vector<Mesh*> makeMeshVector(const Tab<Mesh*> & meshes) {
+	vector<Mesh*> result;
+
+	size_t meshCount = size_t(meshes.Count());
+	result.reserve(meshCount);
+	for (size_t i = 0; i < meshCount; ++i)
+		result.push_back(meshes[int(i)]);
+
+	return result;
+}
+
+/// Converts the meshes into a Tab, which MAXScript receives as an array.
+Tab<Mesh*> makeMeshTab(const vector<Mesh*> & meshes) {
+	Tab<Mesh*> result;
+
+	result.SetCount(int(meshes.size()));
+	for (size_t i = 0; i < meshes.size(); ++i)
+		result[int(i)] = meshes[i];
+
+	return result;
+}
+
+/// \brief Converts the indices into a Tab, which MAXScript receives as an array of 1-based 
+/// indices. (Missing indices, such as IDelaunay2D::NO_TRIANGLE, become zeros.)
+Tab<int> makeIndexTab(const vector<size_t> & indices) {
+	Tab<int> result;
+
+	result.SetCount(int(indices.size()));
+	for (size_t i = 0; i < indices.size(); ++i)
+		result[int(i)] = (indices[i] == delaunay::IDelaunay2D::NO_TRIANGLE) ? -1 : int(indices[i]);
+
+	return result;
+}
+
+/// \brief Converts the statistics into a MAXScript array of #(name, value) pairs, such as 
+/// #(#insertedVertices, 1000). The times are in seconds.
+Value* makeStatisticsArray(const delaunay::RunStatistics & statistics) {
+	const delaunay::InsertionCounters & counters = statistics.m_counters;
+	const delaunay::PhaseTimes & phases = statistics.m_phases;
+
+	const std::pair<const TCHAR*, size_t> counts[] = {
+		{ _T("insertedVertices"), counters.m_insertedVertices },
+		{ _T("conflictTests"), counters.m_conflictTests },
+		{ _T("maxCavitySize"), counters.m_maxCavitySize },
+		{ _T("createdElements"), counters.m_createdElements },
+		{ _T("destroyedElements"), counters.m_destroyedElements },
+		{ _T("peakElements"), statistics.m_peakElements }
+	};
+
+	const std::pair<const TCHAR*, double> values[] = {
+		{ _T("averageCavitySize"), statistics.averageCavitySize() },
+		{ _T("boundingTime"), phases.m_bounding },
+		{ _T("sortTime"), phases.m_sort },
+		{ _T("insertionTime"), phases.m_insertion },
+		{ _T("conversionTime"), phases.m_conversion }
+	};
+
+	// The arrays are kept in the value locals, so the garbage collector does not free them 
+	// while the others are created.
+	two_typed_value_locals(Array* result, Array* pair);
+	vl.result = new Array(0);
+	for (const auto & count : counts) {
+		vl.pair = new Array(2);
+		vl.pair->append(Name::intern(count.first));
+		vl.pair->append(Integer64::intern(INT64(count.second)));
+		vl.result->append(vl.pair);
+	}
+
+	for (const auto & value : values) {
+		vl.pair = new Array(2);
+		vl.pair->append(Name::intern(value.first));
+		vl.pair->append(Float::intern(float(value.second)));
+		vl.result->append(vl.pair);
+	}
+
+	return_value(vl.result);
+}
+
+/// \brief Converts the voronoi cells into a Mesh, each cell as a polygon facing up. The polygon 
+/// is stored as a fan of triangles whose inner edges are hidden.
+Mesh* makeVoronoiMesh(const delaunay::VoronoiCells & cells) {
+	size_t faceCount = 0;
+	for (size_t cell = 0; cell < cells.cellCount(); ++cell) {
+		size_t cornerCount = cells.m_cellStarts[cell + 1] - cells.m_cellStarts[cell];
+		if (cornerCount >= 3)
+			faceCount += cornerCount - 2;
+	}
+
+	Mesh* result = new Mesh;
+	result->setNumVerts(int(cells.m_corners.size()));
+	result->setNumFaces(int(faceCount));
+	for (size_t i = 0; i < cells.m_corners.size(); ++i)
+		result->setVert(int(i), toPoint3(cells.m_corners[i]));
+
+	int iFace = 0;
+	for (size_t cell = 0; cell < cells.cellCount(); ++cell) {
+		size_t start = cells.m_cellStarts[cell];
+		size_t cornerCount = cells.m_cellStarts[cell + 1] - start;
+		for (size_t i = 1; i + 1 < cornerCount; ++i) {
+			Face & face = result->faces[iFace++];
+			face.setVerts(
+				int(cells.m_cellCorners[start]),
+				int(cells.m_cellCorners[start + i]),
+				int(cells.m_cellCorners[start + i + 1]));
+			face.setEdgeVisFlags(
+				(i == 1) ? EDGE_VISIBLE : EDGE_INVIS,
+				EDGE_VISIBLE,
+				(i + 2 == cornerCount) ? EDGE_VISIBLE : EDGE_INVIS);
+		}
+	}
+
+	result->InvalidateGeomCache();
+	result->InvalidateTopologyCache();
+	return result;
+}
+
+/// Creates a spline shape in the scene with a closed spline of line segments for each cell.
+INode* makeVoronoiShape(const delaunay::VoronoiCells & cells) {
+	SplineShape* shape = static_cast<SplineShape*>(CreateInstance(SHAPE_CLASS_ID, splineShapeClassID));
+	BezierShape & bezierShape = shape->shape;
+
+	for (size_t cell = 0; cell < cells.cellCount(); ++cell) {
+		size_t start = cells.m_cellStarts[cell];
+		size_t end = cells.m_cellStarts[cell + 1];
+		if (end - start < 3)
+			continue;
+
+		Spline3D* spline = bezierShape.NewSpline();
+		for (size_t i = start; i < end; ++i) {
+			Point3 point = toPoint3(cells.m_corners[cells.m_cellCorners[i]]);
+			spline->AddKnot(SplineKnot(KTYPE_CORNER, LTYPE_LINE, point, point, point));
+		}
+		spline->SetClosed();
+		spline->ComputeBezPoints();
+	}
+
+	bezierShape.UpdateSels();
+	bezierShape.InvalidateGeomCache();
+	return GetCOREInterface()->CreateObjectNode(shape);
+}
+
+
+// PROGRESS
+// ========
+
+/// \brief Shows the progress of a triangulation in the progress bar of 3ds Max while it exists. 
+/// The triangulation is cancelled when the user presses ESC or the Cancel button of the bar. It 
+/// can only be used on the main thread.
+class MaxProgress : public delaunay::IProgress {
+	Interface* m_interface;
+	/// The time of the last update of the bar.
+	std::chrono::steady_clock::time_point m_lastUpdate;
+
+public:
+	explicit MaxProgress(const TCHAR* title) 
+		: m_interface(GetCOREInterface()), m_lastUpdate(std::chrono::steady_clock::now())
+	{
+		m_interface->ProgressStart(title, TRUE, nullptr, nullptr);
+	}
+
+	virtual ~MaxProgress() {
+		m_interface->ProgressEnd();
+		m_interface->SetCancel(FALSE);
+	}
+
+	virtual bool update(double fraction) override {
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (std::chrono::duration<double>(now - m_lastUpdate).count() < PROGRESS_UPDATE_SECONDS)
+			return false;
+
+		// The update processes the messages of the bar, which is when the cancel flag is set.
+		m_lastUpdate = now;
+		m_interface->ProgressUpdate(int(100.0 * fraction));
+		return m_interface->GetCancel() != FALSE;
+	}
+};
+
 
 // PLUGIN CLASS
 // ============
@@ -46,25 +272,219 @@ public:
 	virtual void Init(HWND hWnd);
 	virtual void Destroy(HWND hWnd);
 	
-	// Singleton access
+	/// \brief Singleton access. The instance is created by the first call, which is safe to be 
+	/// made from several threads at once.
 	static DelaunayUtilityPlugin* GetInstance();
 
-	Mesh* triangulate2D(Mesh* mesh) {
-		unique_ptr<delaunay::IDelaunay2D> algorithm = make_unique<delaunay::BowyerWatson2D>();
-		return algorithm->invoke(makeVector(mesh));
+	/// \brief Triangulates the mesh in 2D. When the minAngle or maxArea bound is not zero, the 
+	/// triangles are refined by new vertices, which follow the vertices of the mesh.
+	Mesh* triangulate2D(Mesh* mesh, delaunay::FaceSides faceSides, ConstraintEdges constraints, double minAngle, double maxArea, double mergeDistance) {
+		vector<Vector3d> vertices = makeVector(mesh);
+		MaxProgress progress(GetString(IDS_PROGRESS_2D));
+		unique_ptr<delaunay::IDelaunay2D> algorithm = make2DAlgorithm(vertices.size(), faceSides, makeConstraints(mesh, constraints), minAngle, maxArea, mergeDistance, &progress);
+		return invokeCancellable(*algorithm, [&]() { return algorithm->invoke(vertices); });
+	}
+
+	vector<size_t> triangulate2DEdges(Mesh* mesh, ConstraintEdges constraints, double mergeDistance) {
+		vector<Vector3d> vertices = makeVector(mesh);
+		MaxProgress progress(GetString(IDS_PROGRESS_2D));
+		unique_ptr<delaunay::IDelaunay2D> algorithm = make2DAlgorithm(vertices.size(), delaunay::FaceSides::SINGLE_SIDED, makeConstraints(mesh, constraints), 0.0, 0.0, mergeDistance, &progress);
+		return invokeCancellable(*algorithm, [&]() { return algorithm->invokeEdges(vertices); });
+	}
+
+	vector<size_t> triangulate2DAdjacency(Mesh* mesh, ConstraintEdges constraints, double mergeDistance) {
+		vector<Vector3d> vertices = makeVector(mesh);
+		MaxProgress progress(GetString(IDS_PROGRESS_2D));
+		unique_ptr<delaunay::IDelaunay2D> algorithm = make2DAlgorithm(vertices.size(), delaunay::FaceSides::SINGLE_SIDED, makeConstraints(mesh, constraints), 0.0, 0.0, mergeDistance, &progress);
+		return invokeCancellable(*algorithm, [&]() { return algorithm->invokeAdjacency(vertices); });
+	}
+
+	/// Computes the voronoi cells of the vertices of the mesh, clipped to the bounds.
+	delaunay::VoronoiCells voronoi2D(Mesh* mesh, const Box3 & bounds) {
+		Vector3d minCorner(bounds.pmin.x, bounds.pmin.y, bounds.pmin.z);
+		Vector3d maxCorner(bounds.pmax.x, bounds.pmax.y, bounds.pmax.z);
+		return delaunay::Voronoi2D(minCorner, maxCorner).invoke(makeVector(mesh));
+	}
+
+	Mesh* triangulate3D(Mesh* mesh, delaunay::TetrahedronOutput output, double mergeDistance) {
+		vector<Vector3d> vertices = makeVector(mesh);
+		MaxProgress progress(GetString(IDS_PROGRESS_3D));
+		unique_ptr<delaunay::IDelaunay3D> algorithm = make3DAlgorithm(vertices.size(), output, mergeDistance, &progress);
+		return invokeCancellable(*algorithm, [&]() { return algorithm->invoke(vertices); });
+	}
+
+	/// \brief Triangulates each of the meshes in 2D, the meshes are processed concurrently on 
+	/// the worker pool. (A null mesh gives a null result)
+	vector<Mesh*> triangulate2DBatch(const vector<Mesh*> & meshes, delaunay::FaceSides faceSides) {
+		return runBatch(meshes, [this, faceSides](const vector<Vector3d> & vertices) {
+			unique_ptr<delaunay::IDelaunay2D> algorithm = make2DAlgorithm(vertices.size(), faceSides);
+			Mesh* result = algorithm->invoke(vertices);
+			storeStatistics(algorithm->statistics());
+			return result;
+		});
+	}
+
+	/// \brief Triangulates each of the meshes in 3D, the meshes are processed concurrently on 
+	/// the worker pool. (A null mesh gives a null result)
+	vector<Mesh*> triangulate3DBatch(const vector<Mesh*> & meshes, delaunay::TetrahedronOutput output) {
+		return runBatch(meshes, [this, output](const vector<Vector3d> & vertices) {
+			unique_ptr<delaunay::IDelaunay3D> algorithm = make3DAlgorithm(vertices.size(), output);
+			Mesh* result = algorithm->invoke(vertices);
+			storeStatistics(algorithm->statistics());
+			return result;
+		});
+	}
+
+	/// \brief Returns the statistics of the last finished triangulation (of a batch, the one 
+	/// that finished last).
+	delaunay::RunStatistics lastStatistics() {
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		return m_lastStatistics;
+	}
+
+	/// Stores the triangulation and returns a new handle to it.
+	int storeTriangulation(std::shared_ptr<delaunay::DynamicTriangulation> triangulation) {
+		std::lock_guard<std::mutex> lock(m_triangulationsMutex);
+		int handle = m_nextHandle++;
+		m_triangulations[handle] = std::move(triangulation);
+		return handle;
+	}
+
+	/// \brief Returns the triangulation with given handle, or null when there is none. It stays 
+	/// alive while it is used, even when it is released meanwhile.
+	std::shared_ptr<delaunay::DynamicTriangulation> findTriangulation(int handle) {
+		std::lock_guard<std::mutex> lock(m_triangulationsMutex);
+		auto it = m_triangulations.find(handle);
+		return (it != m_triangulations.end()) ? it->second : nullptr;
 	}
 
-	Mesh* triangulate3D(Mesh* mesh) {
-		unique_ptr<delaunay::IDelaunay3D> algorithm =  make_unique<delaunay::BowyerWatson3D>();
-		return algorithm->invoke(makeVector(mesh));
+	/// Frees the triangulation with given handle. Returns false when there is none.
+	bool releaseTriangulation(int handle) {
+		std::lock_guard<std::mutex> lock(m_triangulationsMutex);
+		return m_triangulations.erase(handle) > 0;
 	}
 
 private:
 
+	/// \brief Returns the pool that runs the batches and the parallel algorithms. It is created 
+	/// by the first call, so that no threads are started while the plugin is being loaded.
+	delaunay::ThreadPool & workerPool() {
+		std::call_once(m_poolCreated, [this]() {
+			m_pool = make_unique<delaunay::ThreadPool>();
+			RegisterNotification(releasePool, this, NOTIFY_SYSTEM_SHUTDOWN);
+		});
+		return *m_pool;
+	}
+
+	/// \brief Stops the worker threads when 3ds Max shuts down, as they can not be joined once 
+	/// the plugin is being unloaded. The pool is replaced by one without threads, which runs the
+	/// tasks of any later call on the caller.
+	static void releasePool(void* param, NotifyInfo* /*info*/) {
+		static_cast<DelaunayUtilityPlugin*>(param)->m_pool = make_unique<delaunay::ThreadPool>(1);
+	}
+
+	/// Remembers the statistics of a finished triangulation.
+	void storeStatistics(const delaunay::RunStatistics & statistics) {
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		m_lastStatistics = statistics;
+	}
+
+	/// \brief Runs the invocation of the algorithm and remembers its statistics. An invocation
+	/// cancelled by the user returns an empty result (a null mesh).
+	template <typename Algorithm, typename F>
+	auto invokeCancellable(const Algorithm & algorithm, F invoke) -> decltype(invoke()) {
+		decltype(invoke()) result{};
+		try {
+			result = invoke();
+		}
+		catch (const delaunay::Cancelled &) {
+			// The partial triangulation is freed with the algorithm.
+		}
+
+		storeStatistics(algorithm.statistics());
+		return result;
+	}
+
+	/// \brief Chooses the 2D algorithm by the number of vertices. Only the Bowyer-Watson 
+	/// algorithm supports the constrained segments, the refinement and the merging.
+	unique_ptr<delaunay::IDelaunay2D> make2DAlgorithm(size_t vertexCount, delaunay::FaceSides faceSides, vector<size_t> constraints = vector<size_t>(), double minAngle = 0.0, double maxArea = 0.0, double mergeDistance = 0.0, delaunay::IProgress * progress = nullptr) {
+		bool isRefined = (minAngle > 0.0 || maxArea > 0.0);
+		if (vertexCount >= PARALLEL_2D_VERTEX_COUNT && constraints.empty() && !isRefined && mergeDistance <= 0.0) {
+			unique_ptr<delaunay::DivideAndConquer2D> algorithm = make_unique<delaunay::DivideAndConquer2D>(&workerPool(), faceSides);
+			algorithm->setProgress(progress);
+			return std::move(algorithm);
+		}
+
+		unique_ptr<delaunay::BowyerWatson2D> algorithm = make_unique<delaunay::BowyerWatson2D>(delaunay::InsertionOrder::BRIO, faceSides);
+		algorithm->setConstraints(std::move(constraints));
+		algorithm->setRefinement(minAngle, maxArea);
+		algorithm->setMergeDistance(mergeDistance);
+		algorithm->setProgress(progress);
+		return std::move(algorithm);
+	}
+
+	/// Chooses the 3D algorithm by the number of vertices.
+	unique_ptr<delaunay::IDelaunay3D> make3DAlgorithm(size_t vertexCount, delaunay::TetrahedronOutput output, double mergeDistance = 0.0, delaunay::IProgress * progress = nullptr) {
+		unique_ptr<delaunay::BowyerWatson3D> algorithm;
+		if (vertexCount >= PARALLEL_3D_VERTEX_COUNT)
+			algorithm = make_unique<delaunay::ParallelBowyerWatson3D>(&workerPool(), delaunay::InsertionOrder::BRIO, output);
+		else
+			algorithm = make_unique<delaunay::BowyerWatson3D>(delaunay::InsertionOrder::BRIO, output);
+
+		algorithm->setMergeDistance(mergeDistance);
+		algorithm->setProgress(progress);
+		return std::move(algorithm);
+	}
+
+	/// \brief Runs the triangulation function on the vertices of each mesh as a task of the 
+	/// worker pool. Each task has its own algorithm instance, so they share no state.
+	template <typename F>
+	vector<Mesh*> runBatch(const vector<Mesh*> & meshes, F triangulate) {
+		vector<Mesh*> results(meshes.size(), nullptr);
+
+		delaunay::ThreadPool & pool = workerPool();
+		delaunay::ThreadPool::TaskGroup group;
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			if (meshes[i] == nullptr)
+				continue;
+
+			pool.submit(group, [&meshes, &results, &triangulate, i]() {
+				results[i] = triangulate(makeVector(meshes[i]));
+			});
+		}
+
+		try {
+			pool.wait(group);
+		}
+		catch (...) {
+			for (Mesh* result : results)
+				delete result;
+			throw;
+		}
+
+		return results;
+	}
+
 	static INT_PTR CALLBACK DlgProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 	HWND   hPanel;
 	IUtil* iu;
+
+	/// The triangulations kept alive between the calls, by their handles.
+	std::map<int, std::shared_ptr<delaunay::DynamicTriangulation>> m_triangulations;
+	/// The handle of the next created triangulation.
+	int m_nextHandle;
+	/// Guards the triangulations and the handle counter.
+	std::mutex m_triangulationsMutex;
+
+	/// The statistics of the last finished triangulation.
+	delaunay::RunStatistics m_lastStatistics;
+	/// Guards the statistics, as the batches finish on the worker threads.
+	std::mutex m_statisticsMutex;
+
+	/// The worker pool, created by workerPool().
+	unique_ptr<delaunay::ThreadPool> m_pool;
+	std::once_flag m_poolCreated;
 };
 
 
@@ -93,16 +513,133 @@ public:
 class DelaunayFpImplementation : public DelaunayFpInterface {
 	DECLARE_DESCRIPTOR(DelaunayFpImplementation)
 	BEGIN_FUNCTION_MAP
-		FN_1((int)DelaunayFpFunctions::DELAUNAY2D, TYPE_MESH, delaunay2D, TYPE_MESH)
-		FN_1((int)DelaunayFpFunctions::DELAUNAY3D, TYPE_MESH, delaunay3D, TYPE_MESH)
+		FN_6((int)DelaunayFpFunctions::DELAUNAY2D, TYPE_FPVALUE_BV, delaunay2D, TYPE_MESH, TYPE_ENUM, TYPE_ENUM, TYPE_FLOAT, TYPE_FLOAT, TYPE_FLOAT)
+		FN_3((int)DelaunayFpFunctions::DELAUNAY3D, TYPE_MESH, delaunay3D, TYPE_MESH, TYPE_ENUM, TYPE_FLOAT)
+		FN_1((int)DelaunayFpFunctions::CREATE_TRIANGULATION2D, TYPE_INT, createTriangulation2D, TYPE_bool)
+		FN_0((int)DelaunayFpFunctions::CREATE_TRIANGULATION3D, TYPE_INT, createTriangulation3D)
+		FN_2((int)DelaunayFpFunctions::ADD_POINTS, TYPE_bool, addPoints, TYPE_INT, TYPE_POINT3_TAB_BR)
+		FN_1((int)DelaunayFpFunctions::TO_MESH, TYPE_MESH, toMesh, TYPE_INT)
+		FN_1((int)DelaunayFpFunctions::RELEASE_TRIANGULATION, TYPE_bool, releaseTriangulation, TYPE_INT)
+		FN_2((int)DelaunayFpFunctions::REMOVE_POINTS, TYPE_bool, removePoints, TYPE_INT, TYPE_INDEX_TAB_BR)
+		FN_2((int)DelaunayFpFunctions::DELAUNAY2D_BATCH, TYPE_FPVALUE_BV, delaunay2DBatch, TYPE_MESH_TAB_BR, TYPE_bool)
+		FN_2((int)DelaunayFpFunctions::DELAUNAY3D_BATCH, TYPE_FPVALUE_BV, delaunay3DBatch, TYPE_MESH_TAB_BR, TYPE_ENUM)
+		FN_3((int)DelaunayFpFunctions::VORONOI2D, TYPE_FPVALUE_BV, voronoi2D, TYPE_MESH, TYPE_BOX3_BR, TYPE_ENUM)
+		FN_3((int)DelaunayFpFunctions::MERGE_VERTICES, TYPE_INDEX_TAB_BV, mergeVertices, TYPE_MESH, TYPE_FLOAT, TYPE_bool)
+		FN_0((int)DelaunayFpFunctions::GET_LAST_STATS, TYPE_VALUE, getLastStats)
 	END_FUNCTION_MAP
 
-	virtual Mesh* delaunay2D(Mesh* mesh) {
-		return DelaunayUtilityPlugin::GetInstance()->triangulate2D(mesh);
+	virtual FPValue delaunay2D(Mesh* mesh, int output, int constraints, float minAngle, float maxArea, float mergeDistance) {
+		DelaunayUtilityPlugin* plugin = DelaunayUtilityPlugin::GetInstance();
+		ConstraintEdges constraintEdges = ConstraintEdges(constraints);
+		FPValue result;
+		Tab<int> indices;
+
+		switch (TriangleOutput(output)) {
+		case TriangleOutput::EDGES:
+			indices = makeIndexTab(plugin->triangulate2DEdges(mesh, constraintEdges, mergeDistance));
+			result.Load(TYPE_INDEX_TAB_BV, &indices);
+			break;
+
+		case TriangleOutput::ADJACENCY:
+			indices = makeIndexTab(plugin->triangulate2DAdjacency(mesh, constraintEdges, mergeDistance));
+			result.Load(TYPE_INDEX_TAB_BV, &indices);
+			break;
+
+		case TriangleOutput::SINGLE_SIDED:
+			result.Load(TYPE_MESH, plugin->triangulate2D(mesh, delaunay::FaceSides::SINGLE_SIDED, constraintEdges, minAngle, maxArea, mergeDistance));
+			break;
+
+		default:
+			result.Load(TYPE_MESH, plugin->triangulate2D(mesh, delaunay::FaceSides::DOUBLE_SIDED, constraintEdges, minAngle, maxArea, mergeDistance));
+			break;
+		}
+
+		return result;
+	}
+
+	virtual Mesh* delaunay3D(Mesh* mesh, int output, float mergeDistance) {
+		return DelaunayUtilityPlugin::GetInstance()->triangulate3D(mesh, delaunay::TetrahedronOutput(output), mergeDistance);
 	}
 
-	virtual Mesh* delaunay3D(Mesh* mesh) {
-		return DelaunayUtilityPlugin::GetInstance()->triangulate3D(mesh);
+	virtual FPValue delaunay2DBatch(Tab<Mesh*> & meshes, bool singleSided) {
+		delaunay::FaceSides faceSides = singleSided ? delaunay::FaceSides::SINGLE_SIDED : delaunay::FaceSides::DOUBLE_SIDED;
+		vector<Mesh*> results = DelaunayUtilityPlugin::GetInstance()->triangulate2DBatch(makeMeshVector(meshes), faceSides);
+
+		FPValue result;
+		Tab<Mesh*> resultTab = makeMeshTab(results);
+		result.Load(TYPE_MESH_TAB_BV, &resultTab);
+		return result;
+	}
+
+	virtual FPValue delaunay3DBatch(Tab<Mesh*> & meshes, int output) {
+		vector<Mesh*> results = DelaunayUtilityPlugin::GetInstance()->triangulate3DBatch(makeMeshVector(meshes), delaunay::TetrahedronOutput(output));
+
+		FPValue result;
+		Tab<Mesh*> resultTab = makeMeshTab(results);
+		result.Load(TYPE_MESH_TAB_BV, &resultTab);
+		return result;
+	}
+
+	virtual FPValue voronoi2D(Mesh* mesh, Box3 & bounds, int output) {
+		delaunay::VoronoiCells cells = DelaunayUtilityPlugin::GetInstance()->voronoi2D(mesh, bounds);
+
+		FPValue result;
+		if (VoronoiOutput(output) == VoronoiOutput::SHAPE)
+			result.Load(TYPE_INODE, makeVoronoiShape(cells));
+		else
+			result.Load(TYPE_MESH, makeVoronoiMesh(cells));
+
+		return result;
+	}
+
+	virtual Value* getLastStats() {
+		return makeStatisticsArray(DelaunayUtilityPlugin::GetInstance()->lastStatistics());
+	}
+
+	virtual Tab<int> mergeVertices(Mesh* mesh, float distance, bool planar) {
+		return makeIndexTab(delaunay::mergeNearbyVertices(makeVector(mesh), distance, planar ? 2 : 3));
+	}
+
+	virtual int createTriangulation2D(bool singleSided) {
+		delaunay::FaceSides faceSides = singleSided ? delaunay::FaceSides::SINGLE_SIDED : delaunay::FaceSides::DOUBLE_SIDED;
+		return DelaunayUtilityPlugin::GetInstance()->storeTriangulation(make_unique<delaunay::DynamicTriangulation2D>(faceSides));
+	}
+
+	virtual int createTriangulation3D() {
+		return DelaunayUtilityPlugin::GetInstance()->storeTriangulation(make_unique<delaunay::DynamicTriangulation3D>());
+	}
+
+	virtual bool addPoints(int handle, Tab<Point3> & points) {
+		std::shared_ptr<delaunay::DynamicTriangulation> triangulation = DelaunayUtilityPlugin::GetInstance()->findTriangulation(handle);
+		if (triangulation == nullptr)
+			return false;
+
+		triangulation->addVertices(makeVector(points));
+		return true;
+	}
+
+	virtual bool removePoints(int handle, Tab<int> & indices) {
+		std::shared_ptr<delaunay::DynamicTriangulation> triangulation = DelaunayUtilityPlugin::GetInstance()->findTriangulation(handle);
+		if (triangulation == nullptr)
+			return false;
+
+		std::vector<size_t> vertexIndices;
+		for (int i = 0; i < indices.Count(); ++i) {
+			if (indices[i] >= 0)
+				vertexIndices.push_back(size_t(indices[i]));
+		}
+
+		triangulation->removeVertices(vertexIndices);
+		return true;
+	}
+
+	virtual Mesh* toMesh(int handle) {
+		std::shared_ptr<delaunay::DynamicTriangulation> triangulation = DelaunayUtilityPlugin::GetInstance()->findTriangulation(handle);
+		return (triangulation != nullptr) ? triangulation->toMesh() : nullptr;
+	}
+
+	virtual bool releaseTriangulation(int handle) {
+		return DelaunayUtilityPlugin::GetInstance()->releaseTriangulation(handle);
 	}
 };
 
@@ -110,7 +647,6 @@ class DelaunayFpImplementation : public DelaunayFpInterface {
 // STATIC INSTANCES
 // ================
 
-static DelaunayUtilityPlugin theDelaunayUtilityPlugin;
 static DelaunayUtilityPluginClassDesc delaunayUtilityPluginDesc;
 static DelaunayFpImplementation delaunayFpImplementationDesc(
 	// INTERFACE ID | INTERNAL NAME | DESCRIPTION | CLASS DESCRIPTOR | FLAGS
@@ -118,11 +654,77 @@ static DelaunayFpImplementation delaunayFpImplementationDesc(
 	// Here starts the var-args magic.
 	// FUNCTION ID | INTERNAL NAME | LOCALIZABLE DESCRIPTION | RETURN TYPE | FLAGS | PARAMETER COUNT
 	// for each parameter: INTERNAL PARAMETER NAME | LOCALIZABLE DESCRIPTION | TYPE
-	(int)DelaunayFpFunctions::DELAUNAY2D, _T("delaunay2D"), IDS_FN_DELAUNAY2D, TYPE_MESH, 0, 1,
+	(int)DelaunayFpFunctions::DELAUNAY2D, _T("delaunay2D"), IDS_FN_DELAUNAY2D, TYPE_FPVALUE_BV, 0, 6,
+	_T("mesh"), IDS_FNP_VERTICES, TYPE_MESH,
+	_T("output"), IDS_FNP_TRIANGLE_OUTPUT, TYPE_ENUM, (int)DelaunayFpEnums::TRIANGLE_OUTPUT, f_keyArgDefault, (int)TriangleOutput::DOUBLE_SIDED,
+	_T("constraints"), IDS_FNP_CONSTRAINTS, TYPE_ENUM, (int)DelaunayFpEnums::CONSTRAINT_EDGES, f_keyArgDefault, (int)ConstraintEdges::NONE,
+	_T("minAngle"), IDS_FNP_MIN_ANGLE, TYPE_FLOAT, f_keyArgDefault, 0.0f,
+	_T("maxArea"), IDS_FNP_MAX_AREA, TYPE_FLOAT, f_keyArgDefault, 0.0f,
+	_T("mergeDistance"), IDS_FNP_MERGE_DISTANCE, TYPE_FLOAT, f_keyArgDefault, 0.0f,
+
+	(int)DelaunayFpFunctions::DELAUNAY3D, _T("delaunay3D"), IDS_FN_DELAUNAY3D, TYPE_MESH, 0, 3,
+	_T("mesh"), IDS_FNP_VERTICES, TYPE_MESH,
+	_T("output"), IDS_FNP_TETRA_OUTPUT, TYPE_ENUM, (int)DelaunayFpEnums::TETRAHEDRON_OUTPUT, f_keyArgDefault, (int)delaunay::TetrahedronOutput::SEPARATE,
+	_T("mergeDistance"), IDS_FNP_MERGE_DISTANCE, TYPE_FLOAT, f_keyArgDefault, 0.0f,
+
+	(int)DelaunayFpFunctions::CREATE_TRIANGULATION2D, _T("createTriangulation2D"), IDS_FN_CREATE_TRIANGULATION2D, TYPE_INT, 0, 1,
+	_T("singleSided"), IDS_FNP_SINGLE_SIDED, TYPE_bool, f_keyArgDefault, false,
+
+	(int)DelaunayFpFunctions::CREATE_TRIANGULATION3D, _T("createTriangulation3D"), IDS_FN_CREATE_TRIANGULATION3D, TYPE_INT, 0, 0,
+
+	(int)DelaunayFpFunctions::ADD_POINTS, _T("addPoints"), IDS_FN_ADD_POINTS, TYPE_bool, 0, 2,
+	_T("handle"), IDS_FNP_HANDLE, TYPE_INT,
+	_T("points"), IDS_FNP_POINTS, TYPE_POINT3_TAB_BR,
+
+	(int)DelaunayFpFunctions::TO_MESH, _T("toMesh"), IDS_FN_TO_MESH, TYPE_MESH, 0, 1,
+	_T("handle"), IDS_FNP_HANDLE, TYPE_INT,
+
+	(int)DelaunayFpFunctions::RELEASE_TRIANGULATION, _T("releaseTriangulation"), IDS_FN_RELEASE_TRIANGULATION, TYPE_bool, 0, 1,
+	_T("handle"), IDS_FNP_HANDLE, TYPE_INT,
+
+	(int)DelaunayFpFunctions::REMOVE_POINTS, _T("removePoints"), IDS_FN_REMOVE_POINTS, TYPE_bool, 0, 2,
+	_T("handle"), IDS_FNP_HANDLE, TYPE_INT,
+	_T("indices"), IDS_FNP_INDICES, TYPE_INDEX_TAB_BR,
+
+	(int)DelaunayFpFunctions::DELAUNAY2D_BATCH, _T("delaunay2DBatch"), IDS_FN_DELAUNAY2D_BATCH, TYPE_FPVALUE_BV, 0, 2,
+	_T("meshes"), IDS_FNP_MESHES, TYPE_MESH_TAB_BR,
+	_T("singleSided"), IDS_FNP_SINGLE_SIDED, TYPE_bool, f_keyArgDefault, false,
+
+	(int)DelaunayFpFunctions::DELAUNAY3D_BATCH, _T("delaunay3DBatch"), IDS_FN_DELAUNAY3D_BATCH, TYPE_FPVALUE_BV, 0, 2,
+	_T("meshes"), IDS_FNP_MESHES, TYPE_MESH_TAB_BR,
+	_T("output"), IDS_FNP_TETRA_OUTPUT, TYPE_ENUM, (int)DelaunayFpEnums::TETRAHEDRON_OUTPUT, f_keyArgDefault, (int)delaunay::TetrahedronOutput::SEPARATE,
+
+	(int)DelaunayFpFunctions::VORONOI2D, _T("voronoi2D"), IDS_FN_VORONOI2D, TYPE_FPVALUE_BV, 0, 3,
 	_T("mesh"), IDS_FNP_VERTICES, TYPE_MESH,
+	_T("bounds"), IDS_FNP_BOUNDS, TYPE_BOX3_BR,
+	_T("output"), IDS_FNP_VORONOI_OUTPUT, TYPE_ENUM, (int)DelaunayFpEnums::VORONOI_OUTPUT, f_keyArgDefault, (int)VoronoiOutput::MESH,
 
-	(int)DelaunayFpFunctions::DELAUNAY3D, _T("delaunay3D"), IDS_FN_DELAUNAY3D, TYPE_MESH, 0, 1,
+	(int)DelaunayFpFunctions::MERGE_VERTICES, _T("mergeVertices"), IDS_FN_MERGE_VERTICES, TYPE_INDEX_TAB_BV, 0, 3,
 	_T("mesh"), IDS_FNP_VERTICES, TYPE_MESH,
+	_T("distance"), IDS_FNP_MERGE_DISTANCE, TYPE_FLOAT,
+	_T("planar"), IDS_FNP_PLANAR, TYPE_bool, f_keyArgDefault, false,
+
+	(int)DelaunayFpFunctions::GET_LAST_STATS, _T("getLastStats"), IDS_FN_GET_LAST_STATS, TYPE_VALUE, 0, 0,
+
+	// ENUMERATION ID | VALUE COUNT | for each value: NAME | VALUE
+	enums,
+	(int)DelaunayFpEnums::TETRAHEDRON_OUTPUT, 4,
+	_T("separate"), (int)delaunay::TetrahedronOutput::SEPARATE,
+	_T("sharedFaces"), (int)delaunay::TetrahedronOutput::SHARED_FACES,
+	_T("boundary"), (int)delaunay::TetrahedronOutput::BOUNDARY,
+	_T("elements"), (int)delaunay::TetrahedronOutput::ELEMENTS,
+	(int)DelaunayFpEnums::TRIANGLE_OUTPUT, 4,
+	_T("doubleSided"), (int)TriangleOutput::DOUBLE_SIDED,
+	_T("singleSided"), (int)TriangleOutput::SINGLE_SIDED,
+	_T("edges"), (int)TriangleOutput::EDGES,
+	_T("adjacency"), (int)TriangleOutput::ADJACENCY,
+	(int)DelaunayFpEnums::CONSTRAINT_EDGES, 3,
+	_T("none"), (int)ConstraintEdges::NONE,
+	_T("visibleEdges"), (int)ConstraintEdges::VISIBLE,
+	_T("selectedEdges"), (int)ConstraintEdges::SELECTED,
+	(int)DelaunayFpEnums::VORONOI_OUTPUT, 2,
+	_T("mesh"), (int)VoronoiOutput::MESH,
+	_T("shape"), (int)VoronoiOutput::SHAPE,
 	p_end
 );
 
@@ -131,7 +733,9 @@ ClassDesc2* GetDelaunayUtilityPluginDesc() {
 }
 
 DelaunayUtilityPlugin* DelaunayUtilityPlugin::GetInstance() {
-	return &theDelaunayUtilityPlugin;
+	// The initialization of a local static variable is thread-safe since C++11.
+	static DelaunayUtilityPlugin instance;
+	return &instance;
 }
 
 
@@ -141,6 +745,8 @@ DelaunayUtilityPlugin* DelaunayUtilityPlugin::GetInstance() {
 DelaunayUtilityPlugin::DelaunayUtilityPlugin()
 	: hPanel(nullptr)
 	, iu(nullptr)
+	, m_nextHandle(1)
+	, m_lastStatistics()
 { }
 
 DelaunayUtilityPlugin::~DelaunayUtilityPlugin()
@@ -3,20 +3,119 @@
 #include "resource.h"
 #include "Delaunay3D.h"
 #include "Delaunay2D.h"
+#include "DivideAndConquer2D.h"
+#include "ParallelBowyerWatson3D.h"
+#include "DynamicTriangulation.h"
+#include "Voronoi2D.h"
 
 /// Function Publishing IDs for functions.
 enum class DelaunayFpFunctions {
 	DELAUNAY2D,		///< Funciton that provides user with 2D delaunay triangulation capability.
-	DELAUNAY3D		///< Function that provides user with 3D delaunay tetrahedration capability.
+	DELAUNAY3D,		///< Function that provides user with 3D delaunay tetrahedration capability.
+	CREATE_TRIANGULATION2D,	///< Function that creates a persistent 2D triangulation.
+	CREATE_TRIANGULATION3D,	///< Function that creates a persistent 3D triangulation.
+	ADD_POINTS,				///< Function that inserts points into a persistent triangulation.
+	TO_MESH,				///< Function that returns the mesh of a persistent triangulation.
+	RELEASE_TRIANGULATION,	///< Function that frees a persistent triangulation.
+	REMOVE_POINTS,			///< Function that removes points from a persistent triangulation.
+	DELAUNAY2D_BATCH,		///< Function that triangulates an array of meshes in 2D concurrently.
+	DELAUNAY3D_BATCH,		///< Function that triangulates an array of meshes in 3D concurrently.
+	VORONOI2D,				///< Function that computes the 2D voronoi diagram.
+	MERGE_VERTICES,			///< Function that finds the vertices merged by the triangulation functions.
+	GET_LAST_STATS			///< Function that returns the statistics of the last triangulation.
+};
+
+/// Function Publishing IDs for enumerations used by the functions.
+enum class DelaunayFpEnums {
+	TETRAHEDRON_OUTPUT,	///< Values of delaunay::TetrahedronOutput.
+	TRIANGLE_OUTPUT,	///< Values of TriangleOutput.
+	CONSTRAINT_EDGES,	///< Values of ConstraintEdges.
+	VORONOI_OUTPUT		///< Values of VoronoiOutput.
+};
+
+/// The forms of the result of the 2D delaunay triangulation function.
+enum class TriangleOutput {
+	DOUBLE_SIDED,	///< Mesh with each triangle facing both up and down.
+	SINGLE_SIDED,	///< Mesh with each triangle facing up.
+	EDGES,			///< Array of the edges, each as two consecutive vertex indices.
+	ADJACENCY		///< Array of the triangles, each as three vertex indices and the three neighboring triangles.
+};
+
+/// The edges of the input mesh that are kept in the result of the 2D delaunay triangulation.
+enum class ConstraintEdges {
+	NONE,		///< No edges, the result is the delaunay triangulation.
+	VISIBLE,	///< The visible edges of the faces.
+	SELECTED	///< The selected edges of the faces.
+};
+
+/// The forms of the result of the 2D voronoi diagram function.
+enum class VoronoiOutput {
+	MESH,	///< Mesh with each cell as a polygon facing up, its inner edges are hidden.
+	SHAPE	///< New spline shape in the scene with a closed spline for each cell.
 };
 
 /// Abstract interface class that serves as FP interface.
 class DelaunayFpInterface : public FPStaticInterface {
-	/// Call the 2D delaunay triangulation algorithm on the vertices from the mesh. 
-	virtual Mesh* delaunay2D(Mesh* mesh) = 0;
+	/// \brief Call the 2D delaunay triangulation algorithm on the vertices from the mesh. The 
+	/// output parameter is one of the TriangleOutput values, which gives the type of the result.
+	/// The constraints parameter is one of the ConstraintEdges values, the chosen edges of the 
+	/// mesh are then kept in the constrained delaunay triangulation. The mesh outputs are refined
+	/// by new vertices until no angle is below minAngle (in degrees) and no triangle is larger 
+	/// than maxArea, a zero disables the bound. The vertices within mergeDistance of each other
+	/// are merged into the first of them (see mergeVertices), a zero disables the merging.
+	virtual FPValue delaunay2D(Mesh* mesh, int output, int constraints, float minAngle, float maxArea, float mergeDistance) = 0;
+
+	/// \brief Call the 3D delaunay tetrahedration algorithm on the vertices from the mesh. The
+	/// output parameter is one of the delaunay::TetrahedronOutput values. The vertices within 
+	/// mergeDistance of each other are merged into the first of them, a zero disables the merging.
+	virtual Mesh* delaunay3D(Mesh* mesh, int output, float mergeDistance) = 0;
+
+	/// \brief Call the 2D delaunay triangulation algorithm on each of the meshes, the meshes are
+	/// triangulated concurrently. Returns the array of the resulting meshes.
+	virtual FPValue delaunay2DBatch(Tab<Mesh*> & meshes, bool singleSided) = 0;
+
+	/// \brief Call the 3D delaunay tetrahedration algorithm on each of the meshes, the meshes are
+	/// tetrahedrated concurrently. Returns the array of the resulting meshes.
+	virtual FPValue delaunay3DBatch(Tab<Mesh*> & meshes, int output) = 0;
+
+	/// \brief Compute the 2D voronoi diagram of the vertices from the mesh, its cells are clipped
+	/// to the bounds. The output parameter is one of the VoronoiOutput values, which gives the 
+	/// type of the result.
+	virtual FPValue voronoi2D(Mesh* mesh, Box3 & bounds, int output) = 0;
+
+	/// \brief Find the vertices of the mesh that the triangulation functions merge with given 
+	/// distance (by the x and y coordinates only when planar is set). Returns the index of the
+	/// vertex that each vertex is merged into, or its own index when it is not merged.
+	virtual Tab<int> mergeVertices(Mesh* mesh, float distance, bool planar) = 0;
+
+	/// \brief Return the statistics of the last finished triangulation, as an array of 
+	/// #(name, value) pairs (see delaunay::RunStatistics).
+	virtual Value* getLastStats() = 0;
+
+	/// \brief Create an empty 2D triangulation that is kept alive between the calls. Returns its
+	/// handle for the other functions.
+	virtual int createTriangulation2D(bool singleSided) = 0;
+
+	/// \brief Create an empty 3D triangulation that is kept alive between the calls. Returns its
+	/// handle for the other functions.
+	virtual int createTriangulation3D() = 0;
+
+	/// \brief Insert the points into the triangulation with given handle. Returns false when there
+	/// is no such triangulation.
+	virtual bool addPoints(int handle, Tab<Point3> & points) = 0;
+
+	/// \brief Remove the points with given indices from the triangulation with given handle. The 
+	/// indices of the other points do not change. Returns false when there is no such 
+	/// triangulation.
+	virtual bool removePoints(int handle, Tab<int> & indices) = 0;
+
+	/// \brief Return the mesh of the triangulation with given handle (see 
+	/// delaunay::DynamicTriangulation), or null when there is no such triangulation.
+	virtual Mesh* toMesh(int handle) = 0;
 
-	/// Call the 3D delaunay tetrahedration algorithm on the vertices from the mesh.
-	virtual Mesh* delaunay3D(Mesh* mesh) = 0;
+	/// \brief Free the triangulation with given handle. Returns false when there is no such 
+	/// triangulation.
+	virtual bool releaseTriangulation(int handle) = 0;
 };
 
 extern TCHAR *GetString(int id);
@@ -0,0 +1,662 @@
+#include "stdafx.h"
+#include "DivideAndConquer2D.h"
+#include "Common.h"
+#include "Predicates.h"
+
+using Eigen::Vector3d;
+using Eigen::Vector2d;
+using std::vector;
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	using EdgeRef = DivideAndConquer2D::EdgeRef;
+
+	/// Subproblems with fewer vertices than this are not split among the threads.
+	static const size_t PARALLEL_GRAIN = 4096;
+	/// The parallel part of the recursion has this many subproblems per thread (for load balancing).
+	static const size_t SUBPROBLEMS_PER_THREAD = 4;
+	/// \brief The progress counts the finished subproblems with fewer vertices than this, whose 
+	/// parent has more. (These subproblems split the vertices without overlaps.)
+	static const size_t PROGRESS_GRAIN = 4096;
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	// QUAD-EDGE OPERATORS
+	// ===================
+
+	// The four directed edges of a record are: the edge, its dual rotated counter-clockwise, the
+	// edge reversed and the dual rotated clockwise. See the paper by Guibas and Stolfi.
+
+	inline static EdgeRef rot(EdgeRef e) { return (e->m_rotation < 3) ? e + 1 : e - 3; }
+	inline static EdgeRef invRot(EdgeRef e) { return (e->m_rotation > 0) ? e - 1 : e + 3; }
+	inline static EdgeRef sym(EdgeRef e) { return (e->m_rotation < 2) ? e + 2 : e - 2; }
+	inline static EdgeRef onext(EdgeRef e) { return e->m_next; }
+	inline static EdgeRef oprev(EdgeRef e) { return rot(onext(rot(e))); }
+	inline static EdgeRef lnext(EdgeRef e) { return rot(onext(invRot(e))); }
+	inline static EdgeRef rprev(EdgeRef e) { return onext(sym(e)); }
+	inline static size_t org(EdgeRef e) { return e->m_origin; }
+	inline static size_t dest(EdgeRef e) { return sym(e)->m_origin; }
+
+	/// The first edge of the record, which holds the deleted flag.
+	inline static EdgeRef record(EdgeRef e) { return e - e->m_rotation; }
+
+	/// \brief Joins the rings of edges around the origins of a and b, or splits them when they
+	/// are the same ring.
+	static void splice(EdgeRef a, EdgeRef b)
+	{
+		EdgeRef alpha = rot(onext(a));
+		EdgeRef beta = rot(onext(b));
+
+		std::swap(a->m_next, b->m_next);
+		std::swap(alpha->m_next, beta->m_next);
+	}
+
+
+	// VERTEX ORDER
+	// ============
+
+	// The halves are split alternately by a vertical and a horizontal line (R. A. Dwyer, A Faster
+	// Divide-and-Conquer Algorithm for Constructing Delaunay Triangulations, 1987). The merge is
+	// the same in both cases, as the predicates do not change when the plane is rotated. For a
+	// horizontal split the plane is thought of as rotated clockwise by 90 degrees, so the lower
+	// half becomes the left one. The axis of the split defines the order of the vertices:
+	//		AXIS_X: by x-coordinate, then by y-coordinate,
+	//		AXIS_Y: by y-coordinate, then by x-coordinate in descending order.
+
+	static const size_t AXIS_X = 0;
+	static const size_t AXIS_Y = 1;
+
+	/// Tells if the vertex a comes before the vertex b in the order of given axis.
+	inline static bool precedes(const Vector2d & a, const Vector2d & b, size_t axis)
+	{
+		if (axis == AXIS_X)
+			return (a.x() < b.x()) || (a.x() == b.x() && a.y() < b.y());
+		else
+			return (a.y() < b.y()) || (a.y() == b.y() && a.x() > b.x());
+	}
+
+
+	// PARALLEL SORT
+	// =============
+
+	/// \brief Sorts the range by sorting its halves in parallel (up to the given depth) and
+	/// merging them.
+	template<typename I, typename C>
+	static void parallelSort(ThreadPool & pool, I begin, I end, C compare, size_t depth)
+	{
+		size_t count = size_t(end - begin);
+		if (depth == 0 || count < PARALLEL_GRAIN) {
+			std::sort(begin, end, compare);
+			return;
+		}
+
+		I middle = begin + count / 2;
+
+		ThreadPool::TaskGroup group;
+		pool.submit(group, [&pool, begin, middle, compare, depth]() { parallelSort(pool, begin, middle, compare, depth - 1); });
+		parallelSort(pool, middle, end, compare, depth - 1);
+		pool.wait(group);
+
+		std::inplace_merge(begin, middle, end, compare);
+	}
+
+
+	// DIVIDE AND CONQUER ALGORITHM IMPLEMENTATION
+	// ===========================================
+
+	void DivideAndConquer2D::prepareVertices(ThreadPool & pool, const vector<Vector3d> & vertices)
+	{
+		vector<size_t> order(vertices.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+
+		parallelSort(
+			pool,
+			order.begin(),
+			order.end(),
+			[&vertices](size_t lhs, size_t rhs) {
+				return precedes(toVector2d(vertices[lhs]), toVector2d(vertices[rhs]), AXIS_X);
+			},
+			m_parallelDepth
+		);
+
+		// The duplicates are next to each other after the sort.
+		auto isDuplicate = [&vertices](size_t lhs, size_t rhs) {
+			return toVector2d(vertices[lhs]) == toVector2d(vertices[rhs]);
+		};
+		order.erase(std::unique(order.begin(), order.end(), isDuplicate), order.end());
+
+		arrangeVertices(pool, vertices, order, 0, order.size(), AXIS_Y, 0);
+
+		m_vertices.resize(order.size());
+		m_inputIndices = order;
+		for (size_t i = 0; i < order.size(); ++i)
+			m_vertices[i] = toVector2d(vertices[order[i]]);
+	}
+
+	void DivideAndConquer2D::arrangeVertices(ThreadPool & pool, const vector<Vector3d> & vertices, vector<size_t> & order, size_t begin, size_t end, size_t axis, size_t depth)
+	{
+		auto compare = [&vertices](size_t axis) {
+			return [&vertices, axis](size_t lhs, size_t rhs) {
+				return precedes(toVector2d(vertices[lhs]), toVector2d(vertices[rhs]), axis);
+			};
+		};
+
+		// The trivial subproblems are sorted, so that their hull edges are known.
+		size_t count = end - begin;
+		if (count <= 3) {
+			std::sort(order.begin() + begin, order.begin() + end, compare(axis));
+			return;
+		}
+
+		size_t splitAxis = 1 - axis;
+		size_t middle = begin + count / 2;
+		std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, compare(splitAxis));
+
+		if (depth < m_parallelDepth && count >= PARALLEL_GRAIN) {
+			ThreadPool::TaskGroup group;
+			pool.submit(group, [this, &pool, &vertices, &order, begin, middle, splitAxis, depth]() {
+				arrangeVertices(pool, vertices, order, begin, middle, splitAxis, depth + 1);
+			});
+			arrangeVertices(pool, vertices, order, middle, end, splitAxis, depth + 1);
+			pool.wait(group);
+		}
+		else {
+			arrangeVertices(pool, vertices, order, begin, middle, splitAxis, m_parallelDepth);
+			arrangeVertices(pool, vertices, order, middle, end, splitAxis, m_parallelDepth);
+		}
+	}
+
+	EdgeRef DivideAndConquer2D::makeEdge(edgeArena & arena, size_t origin, size_t destination)
+	{
+		arena.emplace_back();
+		std::array<QuadEdge, 4> & quad = arena.back();
+
+		for (size_t r = 0; r < 4; ++r) {
+			quad[r].m_rotation = (unsigned char)r;
+			quad[r].m_isDeleted = false;
+			quad[r].m_origin = 0;
+		}
+
+		// The edge is alone in the rings around its endpoints, its duals form a loop.
+		quad[0].m_next = &quad[0];
+		quad[1].m_next = &quad[3];
+		quad[2].m_next = &quad[2];
+		quad[3].m_next = &quad[1];
+
+		quad[0].m_origin = origin;
+		quad[2].m_origin = destination;
+		return &quad[0];
+	}
+
+	EdgeRef DivideAndConquer2D::connect(edgeArena & arena, EdgeRef a, EdgeRef b)
+	{
+		// Adds an edge from the destination of a to the origin of b, inside of their common face.
+		EdgeRef e = makeEdge(arena, dest(a), org(b));
+		splice(e, lnext(a));
+		splice(sym(e), b);
+		return e;
+	}
+
+	void DivideAndConquer2D::deleteEdge(EdgeRef e)
+	{
+		splice(e, oprev(e));
+		splice(sym(e), oprev(sym(e)));
+		record(e)->m_isDeleted = true;
+	}
+
+	std::pair<EdgeRef, EdgeRef> DivideAndConquer2D::findExtremeEdges(EdgeRef hullEdge, size_t axis)
+	{
+		// Walk around the hull. The counter-clockwise hull edge that follows e is rprev(e).
+		EdgeRef outOfFirst = hullEdge;
+		EdgeRef intoLast = hullEdge;
+
+		EdgeRef e = hullEdge;
+		do {
+			if (precedes(m_vertices[org(e)], m_vertices[org(outOfFirst)], axis))
+				outOfFirst = e;
+			if (precedes(m_vertices[dest(intoLast)], m_vertices[dest(e)], axis))
+				intoLast = e;
+			e = rprev(e);
+		} while (e != hullEdge);
+
+		return std::make_pair(outOfFirst, sym(intoLast));
+	}
+
+	std::pair<EdgeRef, EdgeRef> DivideAndConquer2D::triangulate(ThreadPool & pool, size_t begin, size_t end, size_t axis, size_t node, size_t depth)
+	{
+		edgeArena & arena = *m_arenas[node];
+		size_t count = end - begin;
+
+		auto ccw = [this](size_t a, size_t b, size_t c) {
+			return orient2d(m_vertices[a], m_vertices[b], m_vertices[c]) > 0.0;
+		};
+
+		// TRIVIAL CASES
+		// =============
+
+		if (count == 2) {
+			EdgeRef a = makeEdge(arena, begin, begin + 1);
+			return std::make_pair(a, sym(a));
+		}
+
+		if (count == 3) {
+			EdgeRef a = makeEdge(arena, begin, begin + 1);
+			EdgeRef b = makeEdge(arena, begin + 1, begin + 2);
+			splice(sym(a), b);
+
+			// Close the triangle, unless the vertices are collinear.
+			if (ccw(begin, begin + 1, begin + 2)) {
+				connect(arena, b, a);
+				return std::make_pair(a, sym(b));
+			}
+			else if (ccw(begin, begin + 2, begin + 1)) {
+				EdgeRef c = connect(arena, b, a);
+				return std::make_pair(sym(c), c);
+			}
+			else {
+				return std::make_pair(a, sym(b));
+			}
+		}
+
+		// DIVIDING THE VERTICES
+		// =====================
+
+		// The vertices were arranged by arrangeVertices(), the halves are split along the other
+		// axis than the one of this subproblem. The upper levels of the recursion run the left 
+		// half as a separate task. Below them, the whole subproblem stays in the current thread
+		// and uses its arena.
+
+		size_t splitAxis = 1 - axis;
+		size_t middle = begin + count / 2;
+		std::pair<EdgeRef, EdgeRef> left, right;
+
+		if (depth < m_parallelDepth && count >= PARALLEL_GRAIN) {
+			ThreadPool::TaskGroup group;
+			pool.submit(group, [this, &pool, &left, begin, middle, splitAxis, node, depth]() {
+				left = triangulate(pool, begin, middle, splitAxis, 2 * node, depth + 1);
+			});
+			try {
+				right = triangulate(pool, middle, end, splitAxis, 2 * node + 1, depth + 1);
+			}
+			catch (...) {
+				// The task of the left half refers to this frame, so it has to end first.
+				try {
+					pool.wait(group);
+				}
+				catch (...) {
+				}
+				throw;
+			}
+			pool.wait(group);
+		}
+		else {
+			left = triangulate(pool, begin, middle, splitAxis, node, m_parallelDepth);
+			right = triangulate(pool, middle, end, splitAxis, node, m_parallelDepth);
+		}
+
+		if (count >= PROGRESS_GRAIN) {
+			size_t finishedCount = 0;
+			if (middle - begin < PROGRESS_GRAIN)
+				finishedCount += middle - begin;
+			if (end - middle < PROGRESS_GRAIN)
+				finishedCount += end - middle;
+			if (finishedCount > 0)
+				reportProgress(finishedCount);
+		}
+
+		std::pair<EdgeRef, EdgeRef> merged = merge(arena, left.first, left.second, right.first, right.second);
+
+		// The merge returns the hull edges out of the extreme vertices along the split axis, 
+		// the caller needs them along the axis of this subproblem.
+		return findExtremeEdges(merged.first, axis);
+	}
+
+	void DivideAndConquer2D::reportProgress(size_t count)
+	{
+		if (m_progress == nullptr)
+			return;
+
+		size_t triangulatedCount = (m_triangulatedCount += count);
+		if (std::this_thread::get_id() == m_invokingThread && m_progress->update(double(triangulatedCount) / m_vertices.size()))
+			m_isCancelled = true;
+
+		// A cancelled task ends the whole invocation by ThreadPool::wait().
+		if (m_isCancelled)
+			throw Cancelled();
+	}
+
+	std::pair<EdgeRef, EdgeRef> DivideAndConquer2D::merge(edgeArena & arena, EdgeRef ldo, EdgeRef ldi, EdgeRef rdi, EdgeRef rdo)
+	{
+		auto ccw = [this](size_t a, size_t b, size_t c) {
+			return orient2d(m_vertices[a], m_vertices[b], m_vertices[c]) > 0.0;
+		};
+		auto rightOf = [&ccw](size_t x, EdgeRef e) { return ccw(x, dest(e), org(e)); };
+		auto leftOf = [&ccw](size_t x, EdgeRef e) { return ccw(x, org(e), dest(e)); };
+		auto inCircle = [this](size_t a, size_t b, size_t c, size_t d) {
+			// The candidate loops ask about a vertex of the circle itself when there are no more
+			// candidates. The answer is known and the predicate would need the exact arithmetic.
+			if (d == a || d == b || d == c)
+				return false;
+			return incircle(m_vertices[a], m_vertices[b], m_vertices[c], m_vertices[d]) > 0.0;
+		};
+
+		// Find the lower common tangent of the two hulls.
+		while (true) {
+			if (leftOf(org(rdi), ldi))
+				ldi = lnext(ldi);
+			else if (rightOf(org(ldi), rdi))
+				rdi = rprev(rdi);
+			else
+				break;
+		}
+
+		// Create the first cross edge from the right to the left triangulation.
+		EdgeRef basel = connect(arena, sym(rdi), ldi);
+		if (org(ldi) == org(ldo))
+			ldo = sym(basel);
+		if (org(rdi) == org(rdo))
+			rdo = basel;
+
+		// Zip the triangulations together from the bottom up. In each step, the edges that would
+		// cross the next cross edge are deleted and the next cross edge goes to the candidate
+		// whose circle with the current one is empty.
+		while (true) {
+			auto valid = [&rightOf, &basel](EdgeRef e) { return rightOf(dest(e), basel); };
+
+			EdgeRef lcand = onext(sym(basel));
+			if (valid(lcand)) {
+				while (inCircle(dest(basel), org(basel), dest(lcand), dest(onext(lcand)))) {
+					EdgeRef next = onext(lcand);
+					deleteEdge(lcand);
+					lcand = next;
+				}
+			}
+
+			EdgeRef rcand = oprev(basel);
+			if (valid(rcand)) {
+				while (inCircle(dest(basel), org(basel), dest(rcand), dest(oprev(rcand)))) {
+					EdgeRef next = oprev(rcand);
+					deleteEdge(rcand);
+					rcand = next;
+				}
+			}
+
+			bool lvalid = valid(lcand);
+			bool rvalid = valid(rcand);
+			if (!lvalid && !rvalid)
+				break;
+
+			if (!lvalid || (rvalid && inCircle(dest(lcand), org(lcand), org(rcand), dest(rcand))))
+				basel = connect(arena, rcand, sym(basel));
+			else
+				basel = connect(arena, sym(basel), sym(lcand));
+		}
+
+		return std::make_pair(ldo, rdo);
+	}
+
+	bool DivideAndConquer2D::isKept(size_t v0, size_t v1, size_t v2) const
+	{
+		const Vector2d & a = m_vertices[v0];
+		const Vector2d & b = m_vertices[v1];
+		const Vector2d & c = m_vertices[v2];
+
+		// The circumradius is R = |ab| |bc| |ca| / (2 |cross(ab, ac)|), the triangles of the small
+		// circles are kept without the exact tests.
+		const Vector2d ab = b - a;
+		const Vector2d ac = c - a;
+		double cross = ab.x() * ac.y() - ab.y() * ac.x();
+		double lengthProduct = squareSum(ab) * squareSum(ac) * squareSum(Vector2d(c - b));
+		if (lengthProduct < 4.0 * cross * cross * m_safeRadiusSquared)
+			return true;
+
+		for (const Vector2d & corner : m_boundingCorners) {
+			if (incircle(a, b, c, corner) > 0.0)
+				return false;
+		}
+		return true;
+	}
+
+	template <typename Func>
+	void DivideAndConquer2D::forEachTriangle(Func func)
+	{
+		// Each triangle is the left face of its three edges. It is reported by the edge going
+		// out of its lowest vertex. The outer face is skipped as it is not counter-clockwise.
+
+		for (const std::unique_ptr<edgeArena> & arena : m_arenas) {
+			for (std::array<QuadEdge, 4> & quad : *arena) {
+				if (quad[0].m_isDeleted)
+					continue;
+
+				std::array<EdgeRef, 2> directions = { { &quad[0], &quad[2] } };
+				for (EdgeRef e0 : directions) {
+					EdgeRef e1 = lnext(e0);
+					EdgeRef e2 = lnext(e1);
+					if (lnext(e2) != e0)
+						continue;
+
+					size_t v0 = org(e0);
+					size_t v1 = org(e1);
+					size_t v2 = org(e2);
+					if (v0 > v1 || v0 > v2)
+						continue;
+
+					if (orient2d(m_vertices[v0], m_vertices[v1], m_vertices[v2]) > 0.0 && isKept(v0, v1, v2))
+						func(e0);
+				}
+			}
+		}
+	}
+
+	size_t DivideAndConquer2D::numberTriangles()
+	{
+		// The dual edges are not used by the algorithm, so their origins are free to hold the
+		// faces of the subdivision. Every face starts as the outer one.
+		for (const std::unique_ptr<edgeArena> & arena : m_arenas) {
+			for (std::array<QuadEdge, 4> & quad : *arena) {
+				quad[1].m_origin = NO_TRIANGLE;
+				quad[3].m_origin = NO_TRIANGLE;
+			}
+		}
+
+		size_t triangleCount = 0;
+		forEachTriangle([&triangleCount](EdgeRef e0) {
+			EdgeRef e1 = lnext(e0);
+			EdgeRef e2 = lnext(e1);
+			invRot(e0)->m_origin = triangleCount;
+			invRot(e1)->m_origin = triangleCount;
+			invRot(e2)->m_origin = triangleCount;
+			++triangleCount;
+		});
+
+		return triangleCount;
+	}
+
+	Mesh* DivideAndConquer2D::convertTriangulationIntoMesh(const vector<Vector3d> & inputVertices)
+	{
+		// COLLECTING THE TRIANGLES
+		// ========================
+
+		vector<std::array<size_t, 3>> triangles;
+		forEachTriangle([this, &triangles](EdgeRef e0) {
+			EdgeRef e1 = lnext(e0);
+			EdgeRef e2 = lnext(e1);
+			triangles.push_back({ { m_inputIndices[org(e0)], m_inputIndices[org(e1)], m_inputIndices[org(e2)] } });
+		});
+
+		// CONSTRUCTION OF THE 3DS MAX MESH
+		// ================================
+
+		size_t verticesCount = inputVertices.size();
+		size_t triangleCount = triangles.size();
+		bool isDoubleSided = (m_faceSides == FaceSides::DOUBLE_SIDED);
+
+		Mesh* result = new Mesh;
+		result->setNumVerts(int(verticesCount));
+		result->setNumFaces(int(isDoubleSided ? 2 * triangleCount : triangleCount));
+
+		for (size_t iVertex = 0; iVertex < verticesCount; ++iVertex)
+			result->setVert(int(iVertex), toPoint3(inputVertices[iVertex]));
+
+		for (size_t iFace = 0; iFace < triangleCount; ++iFace) {
+			DWORD index0 = DWORD(triangles[iFace][0]);
+			DWORD index1 = DWORD(triangles[iFace][1]);
+			DWORD index2 = DWORD(triangles[iFace][2]);
+
+			result->faces[iFace].v[0] = index0;
+			result->faces[iFace].v[1] = index1;
+			result->faces[iFace].v[2] = index2;
+
+			if (isDoubleSided) {
+				result->faces[triangleCount + iFace].v[0] = index2;
+				result->faces[triangleCount + iFace].v[1] = index1;
+				result->faces[triangleCount + iFace].v[2] = index0;
+			}
+		}
+
+		result->InvalidateGeomCache();
+		return result;
+	}
+
+	void DivideAndConquer2D::construct(const vector<Vector3d> & inputVertices)
+	{
+		// PREPARATION PHASE
+		// =================
+
+		PhaseClock clock;
+		m_phaseTimes = PhaseTimes();
+
+		std::unique_ptr<ThreadPool> ownPool;
+		ThreadPool * pool = m_pool;
+		if (pool == nullptr) {
+			ownPool = std::make_unique<ThreadPool>();
+			pool = ownPool.get();
+		}
+
+		// The recursion is split among the threads up to the depth where there are enough
+		// subproblems for all of them.
+		m_parallelDepth = 0;
+		if (pool->threadCount() > 1) {
+			while ((size_t(1) << m_parallelDepth) < SUBPROBLEMS_PER_THREAD * pool->threadCount())
+				++m_parallelDepth;
+		}
+
+		m_invokingThread = std::this_thread::get_id();
+		m_triangulatedCount = 0;
+		m_isCancelled = false;
+
+		m_arenas.clear();
+		for (size_t i = 0; i < (size_t(2) << m_parallelDepth); ++i)
+			m_arenas.push_back(std::make_unique<edgeArena>());
+
+		prepareVertices(*pool, inputVertices);
+		m_phaseTimes.m_sort = clock.lap();
+
+		// The bounding triangles of BowyerWatson2D span three times the larger extent of the 
+		// vertices, so each corner lies at least extent * sqrt(2) away from every vertex and only
+		// a circle of the radius above extent / sqrt(2) can contain it.
+		std::pair<Vector3d, Vector3d> box = BowyerWatson2D::boundingBox(inputVertices);
+		Vector3d minCorner = VertexStore<VertexScalar>::round(box.first);
+		Vector3d maxCorner = VertexStore<VertexScalar>::round(box.second);
+		m_boundingCorners = { {
+			Vector2d(minCorner.x(), minCorner.y()),
+			Vector2d(maxCorner.x(), minCorner.y()),
+			Vector2d(maxCorner.x(), maxCorner.y()),
+			Vector2d(minCorner.x(), maxCorner.y())
+		} };
+		double extent = std::max(maxCorner.x() - minCorner.x(), maxCorner.y() - minCorner.y()) / 3.0;
+		m_safeRadiusSquared = square(extent / 4.0);
+
+
+		// TRIANGULATING THE VERTICES
+		// ==========================
+
+		if (m_vertices.size() >= 2)
+			triangulate(*pool, 0, m_vertices.size(), AXIS_Y, 1, 0);
+
+		m_phaseTimes.m_insertion = clock.lap();
+	}
+
+	Mesh* DivideAndConquer2D::invoke(const vector<Vector3d> & inputVertices)
+	{
+		construct(inputVertices);
+
+		PhaseClock clock;
+		Mesh* result = convertTriangulationIntoMesh(inputVertices);
+		m_arenas.clear();
+		m_phaseTimes.m_conversion = clock.lap();
+		return result;
+	}
+
+	vector<size_t> DivideAndConquer2D::invokeEdges(const vector<Vector3d> & inputVertices)
+	{
+		construct(inputVertices);
+		PhaseClock clock;
+
+		// An edge inside of the triangulation is shared by two triangles and it is reported only
+		// by the one with the lower number. (The edges of the left out triangles only are not a 
+		// part of the result.)
+		numberTriangles();
+
+		vector<size_t> edges;
+		edges.reserve(6 * m_vertices.size());
+		forEachTriangle([this, &edges](EdgeRef e0) {
+			EdgeRef e = e0;
+			for (size_t i = 0; i < 3; ++i, e = lnext(e)) {
+				size_t index = invRot(e)->m_origin;
+				size_t neighborIndex = rot(e)->m_origin;
+				if (neighborIndex == NO_TRIANGLE || index < neighborIndex) {
+					edges.push_back(m_inputIndices[org(e)]);
+					edges.push_back(m_inputIndices[dest(e)]);
+				}
+			}
+		});
+
+		m_arenas.clear();
+		m_phaseTimes.m_conversion = clock.lap();
+		return edges;
+	}
+
+	vector<size_t> DivideAndConquer2D::invokeAdjacency(const vector<Vector3d> & inputVertices)
+	{
+		construct(inputVertices);
+		PhaseClock clock;
+
+		vector<size_t> adjacency;
+		adjacency.reserve(6 * numberTriangles());
+
+		// The triangle across an edge is its right face, i.e. the origin of rot(e). The i-th 
+		// neighbor lies opposite to the i-th vertex.
+		forEachTriangle([this, &adjacency](EdgeRef e0) {
+			EdgeRef e1 = lnext(e0);
+			EdgeRef e2 = lnext(e1);
+			adjacency.push_back(m_inputIndices[org(e0)]);
+			adjacency.push_back(m_inputIndices[org(e1)]);
+			adjacency.push_back(m_inputIndices[org(e2)]);
+			adjacency.push_back(rot(e1)->m_origin);
+			adjacency.push_back(rot(e2)->m_origin);
+			adjacency.push_back(rot(e0)->m_origin);
+		});
+
+		m_arenas.clear();
+		m_phaseTimes.m_conversion = clock.lap();
+		return adjacency;
+	}
+
+	RunStatistics DivideAndConquer2D::statistics() const
+	{
+		RunStatistics result = RunStatistics();
+		result.m_phases = m_phaseTimes;
+		result.m_counters.m_insertedVertices = m_vertices.size();
+		return result;
+	}
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "Delaunay2D.h"
+#include "ThreadPool.h"
+#include "Progress.h"
+
+namespace delaunay {
+
+	/// \brief Implementation class of the divide and conquer algorithm (L. Guibas, J. Stolfi,
+	/// Primitives for the Manipulation of General Subdivisions and the Computation of Voronoi
+	/// Diagrams, 1985) for construction of 2D delaunay triangulation.
+	///
+	/// The vertices are split in halves alternately by a vertical and a horizontal line. The
+	/// halves are triangulated independently and then merged. The halves at the upper levels of
+	/// the recursion are triangulated in parallel on a thread pool. For vertices in general 
+	/// position the result is the same triangulation as the one of BowyerWatson2D. The thin 
+	/// triangles on the hull that BowyerWatson2D misses due to its bounding triangles are left
+	/// out here too. (Co-circular vertices may be triangulated differently, but both results are
+	/// delaunay.)
+	class DivideAndConquer2D : public IDelaunay2D {
+	public:
+		/// Structure representing one of the four directed edges of a quad-edge record.
+		struct QuadEdge;
+
+		/// Reference to a directed edge.
+		using EdgeRef = QuadEdge *;
+
+		struct QuadEdge {
+			EdgeRef m_next;			///< Next edge counter-clockwise around the origin.
+			size_t m_origin;		///< Index of the origin vertex (only used in the primal edges).
+			unsigned char m_rotation;	///< Index of this edge inside of its record.
+			bool m_isDeleted;		///< A flag that marks deleted edges (stored in the first edge of the record).
+		};
+
+	private:
+		using vertexCollection = std::vector<Eigen::Vector2d>;
+		using edgeArena = std::deque<std::array<QuadEdge, 4>>;
+
+		/// The pool that runs the subproblems, or null to create one for each invocation.
+		ThreadPool * m_pool;
+		/// The faces of the returned Mesh.
+		FaceSides m_faceSides;
+		/// The unique input vertices, in the order given by arrangeVertices().
+		vertexCollection m_vertices = std::vector<Eigen::Vector2d>();
+		/// Index of the input vertex of each sorted vertex.
+		std::vector<size_t> m_inputIndices = std::vector<size_t>();
+		/// \brief Storage of the edge records. Each node of the parallel part of the recursion has
+		/// its own arena, so the threads never allocate from the same one.
+		std::vector<std::unique_ptr<edgeArena>> m_arenas = std::vector<std::unique_ptr<edgeArena>>();
+		/// Depth of the recursion up to which the halves are triangulated in parallel.
+		size_t m_parallelDepth = 0;
+		/// The receiver of the progress, or null.
+		IProgress * m_progress = nullptr;
+		/// The thread that invoked the algorithm, the only one that reports the progress.
+		std::thread::id m_invokingThread = std::thread::id();
+		/// Number of the vertices in the finished subproblems counted by the progress.
+		std::atomic<size_t> m_triangulatedCount{ 0 };
+		/// Set when the progress cancels the invocation, the other threads stop at their next report.
+		std::atomic<bool> m_isCancelled{ false };
+		/// The times of the phases of the last invocation.
+		PhaseTimes m_phaseTimes = PhaseTimes();
+		/// \brief The corners of the bounding triangles of BowyerWatson2D for the same input. The
+		/// triangles whose circumcircles contain any of them are left out of the result.
+		std::array<Eigen::Vector2d, 4> m_boundingCorners = std::array<Eigen::Vector2d, 4>();
+		/// \brief Squared circumradius below which a circle can not reach any bounding corner 
+		/// (with a wide safety margin), so the exact tests are skipped.
+		double m_safeRadiusSquared = 0.0;
+
+		/// \brief Sorts the input vertices and removes the duplicate ones. (Duplicates are left
+		/// out of the triangulation, so they end up as isolated vertices of the mesh.)
+		void prepareVertices(ThreadPool & pool, const std::vector<Eigen::Vector3d> & vertices);
+
+		/// \brief Reorders the vertices in range [begin, end) so that each subproblem of 
+		/// triangulate() is split into halves by the median along its split axis.
+		void arrangeVertices(ThreadPool & pool, const std::vector<Eigen::Vector3d> & vertices, std::vector<size_t> & order, size_t begin, size_t end, size_t axis, size_t depth);
+
+		/// \brief Triangulates the vertices in range [begin, end). Returns the counter-clockwise 
+		/// convex hull edge out of the first vertex and the clockwise convex hull edge out of the
+		/// last vertex, in the order of the given axis.
+		std::pair<EdgeRef, EdgeRef> triangulate(ThreadPool & pool, size_t begin, size_t end, size_t axis, size_t node, size_t depth);
+
+		/// \brief Counts the vertices of a finished subproblem and reports the progress, when 
+		/// called on the invoking thread. Throws Cancelled when the invocation was cancelled.
+		void reportProgress(size_t count);
+
+		/// \brief Given any counter-clockwise convex hull edge, finds the hull edges out of the 
+		/// first and the last vertex in the order of the given axis (see triangulate()).
+		std::pair<EdgeRef, EdgeRef> findExtremeEdges(EdgeRef hullEdge, size_t axis);
+
+		/// Merges two adjacent triangulations, given by their hull edges.
+		std::pair<EdgeRef, EdgeRef> merge(edgeArena & arena, EdgeRef ldo, EdgeRef ldi, EdgeRef rdi, EdgeRef rdo);
+
+		EdgeRef makeEdge(edgeArena & arena, size_t origin, size_t destination);
+		EdgeRef connect(edgeArena & arena, EdgeRef a, EdgeRef b);
+		void deleteEdge(EdgeRef e);
+
+		/// \brief Constructs the delaunay triangulation of the input vertices. The edge records are
+		/// kept until the result is extracted from them.
+		void construct(const std::vector<Eigen::Vector3d> & inputVertices);
+
+		/// \brief Tells if the counter-clockwise triangle is a part of the result, i.e. its 
+		/// circumcircle contains none of the bounding corners.
+		bool isKept(size_t v0, size_t v1, size_t v2) const;
+
+		/// \brief Calls the function for each triangle of the result with its counter-clockwise 
+		/// edge going out of the lowest vertex of the triangle.
+		template <typename Func>
+		void forEachTriangle(Func func);
+
+		/// \brief Numbers the triangles of the result in the order of forEachTriangle(). The number
+		/// of the left face of each edge e is stored as the origin of invRot(e), NO_TRIANGLE for
+		/// the faces out of the result. Returns the number of the triangles.
+		size_t numberTriangles();
+
+		/// Converts the computed triangulation into 3ds Max Mesh structure.
+		Mesh* convertTriangulationIntoMesh(const std::vector<Eigen::Vector3d> & inputVertices);
+
+	public:
+		/// \brief Creates the algorithm that runs on the given thread pool. Without a pool, one
+		/// with a thread per processor is created for each invocation.
+		explicit DivideAndConquer2D(ThreadPool * pool = nullptr, FaceSides faceSides = FaceSides::DOUBLE_SIDED)
+			: m_pool(pool), m_faceSides(faceSides)
+		{ }
+
+		/// \brief Sets the receiver of the progress of the triangulation, which can cancel it by
+		/// Cancelled thrown out of the invocation. It is called only from the invoking thread 
+		/// (while the subproblems on the other threads continue until their next report).
+		void setProgress(IProgress * progress) { m_progress = progress; }
+
+		virtual Mesh* invoke(const std::vector<Eigen::Vector3d> & vertices) override;
+		virtual std::vector<size_t> invokeEdges(const std::vector<Eigen::Vector3d> & vertices) override;
+		virtual std::vector<size_t> invokeAdjacency(const std::vector<Eigen::Vector3d> & vertices) override;
+		/// \brief Returns the times of the phases and the number of the unique vertices, the 
+		/// algorithm has no cavities to count.
+		virtual RunStatistics statistics() const override;
+		virtual ~DivideAndConquer2D() {}
+	};
+
+}
@@ -0,0 +1,315 @@
+#include "stdafx.h"
+#include "DynamicTriangulation.h"
+#include "Common.h"
+
+using Eigen::Vector3d;
+using std::vector;
+
+namespace delaunay {
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	const size_t DynamicTriangulation::NO_BLOCK;
+
+
+	// DYNAMIC TRIANGULATION IMPLEMENTATION
+	// ====================================
+
+	void DynamicTriangulation::addVertices(const vector<Vector3d> & vertices)
+	{
+		if (vertices.empty())
+			return;
+
+		size_t firstIndex = m_vertices.size();
+		m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+		m_isRemoved.resize(m_vertices.size(), false);
+
+		m_changedSlots.clear();
+		if (insertMore(vertices, firstIndex)) {
+			updateElements(m_changedSlots);
+			updateDuplicates();
+		}
+		else {
+			retriangulate();
+		}
+	}
+
+	void DynamicTriangulation::removeVertices(const vector<size_t> & indices)
+	{
+		// Once a removal fails, the rest of the vertices is only flagged, as they are all
+		// triangulated anew.
+		bool isRemoved = true;
+
+		m_changedSlots.clear();
+		for (size_t index : indices) {
+			if (index >= m_vertices.size() || m_isRemoved[index])
+				continue;
+
+			m_isRemoved[index] = true;
+			isRemoved = isRemoved && removeFromEngine(index);
+		}
+
+		if (isRemoved)
+			updateElements(m_changedSlots);
+		else
+			retriangulate();
+	}
+
+	void DynamicTriangulation::retriangulate()
+	{
+		vector<Vector3d> vertices;
+		vector<size_t> indices;
+		for (size_t iVertex = 0; iVertex < m_vertices.size(); ++iVertex) {
+			if (!m_isRemoved[iVertex]) {
+				vertices.push_back(m_vertices[iVertex]);
+				indices.push_back(iVertex);
+			}
+		}
+
+		m_replacedDuplicates.clear();
+		m_connectedOf.clear();
+		m_duplicatesOf.clear();
+
+		triangulateAll(vertices, indices);
+		rebuildElements();
+		updateDuplicates();
+	}
+
+	void DynamicTriangulation::updateDuplicates()
+	{
+		for (size_t iPair = 0; iPair < m_replacedDuplicates.size(); iPair += 2) {
+			size_t replaced = m_replacedDuplicates[iPair];
+			size_t connected = m_replacedDuplicates[iPair + 1];
+
+			// The duplicates of the replaced vertex become the duplicates of the new one.
+			vector<size_t> & duplicates = m_duplicatesOf[connected];
+			auto replacedDuplicates = m_duplicatesOf.find(replaced);
+			if (replacedDuplicates != m_duplicatesOf.end()) {
+				for (size_t duplicate : replacedDuplicates->second) {
+					m_connectedOf[duplicate] = connected;
+					duplicates.push_back(duplicate);
+				}
+				m_duplicatesOf.erase(replacedDuplicates);
+			}
+
+			m_connectedOf[replaced] = connected;
+			duplicates.push_back(replaced);
+		}
+
+		m_replacedDuplicates.clear();
+	}
+
+	bool DynamicTriangulation::removeFromEngine(size_t index)
+	{
+		// The engine looks the vertex up by its position, which would find the connected one.
+		auto connected = m_connectedOf.find(index);
+		if (connected != m_connectedOf.end()) {
+			vector<size_t> & duplicates = m_duplicatesOf[connected->second];
+			duplicates.erase(std::find(duplicates.begin(), duplicates.end(), index));
+			if (duplicates.empty())
+				m_duplicatesOf.erase(connected->second);
+
+			m_connectedOf.erase(connected);
+			return true;
+		}
+
+		// A remaining duplicate has to take the place of the vertex.
+		if (m_duplicatesOf.count(index) != 0)
+			return false;
+
+		return removeVertex(m_vertices[index]);
+	}
+
+	void DynamicTriangulation::updateElements(vector<size_t> & slots)
+	{
+		// A slot may be released and reused by several insertions, it is updated only once.
+		std::sort(slots.begin(), slots.end());
+		slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+		m_blockOfSlot.resize(slotCount(), NO_BLOCK);
+
+		// The removed block is replaced by the last one, so the blocks stay contiguous.
+		for (size_t slot : slots) {
+			size_t block = m_blockOfSlot[slot];
+			if (block == NO_BLOCK)
+				continue;
+
+			size_t lastBlock = m_slotOfBlock.size() - 1;
+			size_t lastSlot = m_slotOfBlock[lastBlock];
+			std::copy_n(
+				m_faces.begin() + lastBlock * m_facesPerElement,
+				m_facesPerElement,
+				m_faces.begin() + block * m_facesPerElement);
+
+			m_slotOfBlock[block] = lastSlot;
+			m_blockOfSlot[lastSlot] = block;
+			m_blockOfSlot[slot] = NO_BLOCK;
+
+			m_slotOfBlock.pop_back();
+			m_faces.resize(m_faces.size() - m_facesPerElement);
+		}
+
+		for (size_t slot : slots) {
+			size_t block = m_slotOfBlock.size();
+			m_faces.resize(m_faces.size() + m_facesPerElement);
+			if (writeElement(slot, &m_faces[block * m_facesPerElement])) {
+				m_blockOfSlot[slot] = block;
+				m_slotOfBlock.push_back(slot);
+			}
+			else {
+				m_faces.resize(m_faces.size() - m_facesPerElement);
+			}
+		}
+	}
+
+	void DynamicTriangulation::rebuildElements()
+	{
+		m_faces.clear();
+		m_slotOfBlock.clear();
+		m_blockOfSlot.assign(slotCount(), NO_BLOCK);
+
+		vector<size_t> slots(slotCount());
+		std::iota(slots.begin(), slots.end(), size_t(0));
+		updateElements(slots);
+	}
+
+	Mesh* DynamicTriangulation::toMesh() const
+	{
+		// CONSTRUCTION OF THE 3DS MAX MESH
+		// ================================
+
+		size_t verticesCount = m_vertices.size();
+		size_t facesCount = m_faces.size();
+
+		Mesh* result = new Mesh;
+		result->setNumVerts(int(verticesCount));
+		result->setNumFaces(int(facesCount));
+
+		for (size_t iVertex = 0; iVertex < verticesCount; ++iVertex)
+			result->setVert(int(iVertex), toPoint3(m_vertices[iVertex]));
+
+		for (size_t iFace = 0; iFace < facesCount; ++iFace) {
+			result->faces[iFace].v[0] = m_faces[iFace][0];
+			result->faces[iFace].v[1] = m_faces[iFace][1];
+			result->faces[iFace].v[2] = m_faces[iFace][2];
+		}
+
+		result->InvalidateGeomCache();
+		return result;
+	}
+
+
+	// DYNAMIC 2D TRIANGULATION IMPLEMENTATION
+	// =======================================
+
+	bool DynamicTriangulation2D::insertMore(const vector<Vector3d> & vertices, size_t firstIndex)
+	{
+		return (m_engine != nullptr) && m_engine->insertMore(vertices, firstIndex);
+	}
+
+	bool DynamicTriangulation2D::removeVertex(const Vector3d & point)
+	{
+		return m_engine->removeVertex(point);
+	}
+
+	void DynamicTriangulation2D::triangulateAll(const vector<Vector3d> & vertices, const vector<size_t> & indices)
+	{
+		m_engine = nullptr;
+		if (vertices.empty())
+			return;
+
+		m_engine = std::make_unique<BowyerWatson2D>();
+		m_engine->m_replacedDuplicates = &m_replacedDuplicates;
+		m_engine->triangulate(vertices);
+		for (size_t & inputIndex : m_engine->m_inputIndices)
+			inputIndex = indices[inputIndex];
+		for (size_t & inputIndex : m_replacedDuplicates)
+			inputIndex = indices[inputIndex];
+
+		m_engine->m_changedSlots = &m_changedSlots;
+	}
+
+	size_t DynamicTriangulation2D::slotCount() const
+	{
+		return (m_engine != nullptr) ? m_engine->m_currentTriangulation.size() : 0;
+	}
+
+	bool DynamicTriangulation2D::writeElement(size_t slot, face * faces)
+	{
+		if (!m_engine->m_currentTriangulation.isLive(slot))
+			return false;
+
+		BowyerWatson2D::Triangle & triangle = m_engine->m_currentTriangulation[slot];
+		if (triangle.isBounding(*m_engine))
+			return false;
+
+		DWORD index0 = DWORD(m_engine->inputIndex(triangle.m_v[0]));
+		DWORD index1 = DWORD(m_engine->inputIndex(triangle.m_v[1]));
+		DWORD index2 = DWORD(m_engine->inputIndex(triangle.m_v[2]));
+
+		faces[0] = { { index0, index1, index2 } };
+		if (m_facesPerElement == 2)
+			faces[1] = { { index2, index1, index0 } };
+
+		return true;
+	}
+
+
+	// DYNAMIC 3D TRIANGULATION IMPLEMENTATION
+	// =======================================
+
+	bool DynamicTriangulation3D::insertMore(const vector<Vector3d> & vertices, size_t firstIndex)
+	{
+		return (m_engine != nullptr) && m_engine->insertMore(vertices, firstIndex);
+	}
+
+	bool DynamicTriangulation3D::removeVertex(const Vector3d & point)
+	{
+		return m_engine->removeVertex(point) == BowyerWatson3D::Removal::REMOVED;
+	}
+
+	void DynamicTriangulation3D::triangulateAll(const vector<Vector3d> & vertices, const vector<size_t> & indices)
+	{
+		m_engine = nullptr;
+		if (vertices.empty())
+			return;
+
+		m_engine = std::make_unique<BowyerWatson3D>();
+		m_engine->m_replacedDuplicates = &m_replacedDuplicates;
+		m_engine->triangulate(vertices);
+		for (size_t & inputIndex : m_engine->m_inputIndices)
+			inputIndex = indices[inputIndex];
+		for (size_t & inputIndex : m_replacedDuplicates)
+			inputIndex = indices[inputIndex];
+
+		m_engine->m_changedSlots = &m_changedSlots;
+	}
+
+	size_t DynamicTriangulation3D::slotCount() const
+	{
+		return (m_engine != nullptr) ? m_engine->m_currentTetrahedration.size() : 0;
+	}
+
+	bool DynamicTriangulation3D::writeElement(size_t slot, face * faces)
+	{
+		if (!m_engine->m_currentTetrahedration.isLive(slot))
+			return false;
+
+		BowyerWatson3D::Tetrahedron & tetra = m_engine->m_currentTetrahedration[slot];
+		if (tetra.isBounding(*m_engine))
+			return false;
+
+		// The same layout as the one of BowyerWatson3D::convertIntoSharedFaces().
+		size_t firstVertexIndex = m_engine->m_vertices.size() - m_engine->m_inputIndices.size();
+		for (size_t iFace = 0; iFace < 4; ++iFace) {
+			std::array<size_t, 3> vertices = tetra.getOutwardFace(iFace);
+			for (size_t i = 0; i < 3; ++i)
+				faces[iFace][i] = DWORD(m_engine->m_inputIndices[vertices[i] - firstVertexIndex]);
+		}
+
+		return true;
+	}
+
+}
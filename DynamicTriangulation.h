@@ -0,0 +1,142 @@
+#pragma once
+#include "Delaunay2D.h"
+#include "Delaunay3D.h"
+
+namespace delaunay {
+
+	/// \brief Triangulation that is kept alive between insertions and removals of vertices, 
+	/// together with the faces of its Mesh.
+	///
+	/// Each element of the triangulation (triangle or tetrahedron) owns a block of consecutive
+	/// faces. An insertion only touches the elements of its cavity and a removal only the elements
+	/// around the removed vertex, so only the blocks of these elements are removed and written 
+	/// again. When some of the new vertices lie outside of the bounding elements (or a removal can
+	/// not be done locally), the whole triangulation is computed anew.
+	///
+	/// Of the vertices at the same position only one is connected in the triangulation, the last 
+	/// inserted one. The others are only flagged when they are removed. When the connected one is
+	/// removed while some of its duplicates remain, the triangulation is computed anew, so that
+	/// one of them takes its place.
+	class DynamicTriangulation {
+	public:
+		/// Inserts the vertices into the triangulation. They are numbered after the vertices inserted before.
+		void addVertices(const std::vector<Eigen::Vector3d> & vertices);
+
+		/// \brief Removes the vertices with given indices from the triangulation. They stay in the
+		/// Mesh as isolated vertices, so that the indices of the other vertices do not change.
+		void removeVertices(const std::vector<size_t> & indices);
+
+		/// \brief Returns the Mesh of the current triangulation. The vertices of the mesh are all the
+		/// inserted vertices. (The caller is responsible for freeing the returned Mesh)
+		Mesh* toMesh() const;
+
+		virtual ~DynamicTriangulation() {}
+
+	protected:
+		using face = std::array<DWORD, 3>;
+
+		/// Value of a block index that signalizes the element has no faces in the mesh.
+		static const size_t NO_BLOCK = size_t(-1);
+
+		/// Number of faces in the block of each element.
+		size_t m_facesPerElement;
+		/// All the inserted vertices.
+		std::vector<Eigen::Vector3d> m_vertices = std::vector<Eigen::Vector3d>();
+		/// Flags of the vertices that were removed from the triangulation.
+		std::vector<bool> m_isRemoved = std::vector<bool>();
+		/// The faces of the mesh, in blocks of m_facesPerElement.
+		std::vector<face> m_faces = std::vector<face>();
+		/// Index of the block of each element slot of the engine, or NO_BLOCK.
+		std::vector<size_t> m_blockOfSlot = std::vector<size_t>();
+		/// Index of the element slot that owns each block.
+		std::vector<size_t> m_slotOfBlock = std::vector<size_t>();
+		/// Element slots changed by the last insertion or removal, filled in by the engine.
+		std::vector<size_t> m_changedSlots = std::vector<size_t>();
+		/// \brief Pairs of the vertices replaced by a duplicate and of the duplicates that replaced
+		/// them, filled in by the engine.
+		std::vector<size_t> m_replacedDuplicates = std::vector<size_t>();
+		/// The connected vertex at the position of each duplicate that is not connected.
+		std::map<size_t, size_t> m_connectedOf = std::map<size_t, size_t>();
+		/// The duplicates that are not connected, for each connected vertex at their position.
+		std::map<size_t, std::vector<size_t>> m_duplicatesOf = std::map<size_t, std::vector<size_t>>();
+
+		explicit DynamicTriangulation(size_t facesPerElement)
+			: m_facesPerElement(facesPerElement)
+		{ }
+
+		/// \brief Inserts the vertices into the current engine, numbering them from the given index.
+		/// Returns false when they need a new triangulation.
+		virtual bool insertMore(const std::vector<Eigen::Vector3d> & vertices, size_t firstIndex) = 0;
+
+		/// \brief Removes the vertex at given point from the current engine. Returns false when the
+		/// vertices need a new triangulation.
+		virtual bool removeVertex(const Eigen::Vector3d & point) = 0;
+
+		/// \brief Creates a new engine, triangulates the vertices by it, numbering them by the given
+		/// indices, and makes it report the changed slots. Without vertices there is no engine.
+		virtual void triangulateAll(const std::vector<Eigen::Vector3d> & vertices, const std::vector<size_t> & indices) = 0;
+
+		/// Number of the element slots of the engine.
+		virtual size_t slotCount() const = 0;
+
+		/// \brief Writes the faces of the element in given slot. Returns false when the slot does not
+		/// hold an element of the result (it is free or bounding).
+		virtual bool writeElement(size_t slot, face * faces) = 0;
+
+		/// Rewrites the blocks of the elements in the given slots.
+		void updateElements(std::vector<size_t> & slots);
+
+		/// Writes the blocks of all the elements anew.
+		void rebuildElements();
+
+		/// Triangulates all the vertices that were not removed anew.
+		void retriangulate();
+
+		/// Takes the duplicates reported by the engine into m_connectedOf and m_duplicatesOf.
+		void updateDuplicates();
+
+		/// \brief Removes the vertex with given index from the engine, or only forgets it when it
+		/// is a duplicate that is not connected. Returns false when the vertices need a new 
+		/// triangulation.
+		bool removeFromEngine(size_t index);
+	};
+
+	/// \brief Dynamic 2D triangulation (see DynamicTriangulation), computed by BowyerWatson2D. Each
+	/// triangle has one face facing up and, when double sided, one facing down.
+	class DynamicTriangulation2D : public DynamicTriangulation {
+	private:
+		/// The engine that holds the triangulation.
+		std::unique_ptr<BowyerWatson2D> m_engine = nullptr;
+
+		virtual bool insertMore(const std::vector<Eigen::Vector3d> & vertices, size_t firstIndex) override;
+		virtual bool removeVertex(const Eigen::Vector3d & point) override;
+		virtual void triangulateAll(const std::vector<Eigen::Vector3d> & vertices, const std::vector<size_t> & indices) override;
+		virtual size_t slotCount() const override;
+		virtual bool writeElement(size_t slot, face * faces) override;
+
+	public:
+		explicit DynamicTriangulation2D(FaceSides faceSides = FaceSides::DOUBLE_SIDED)
+			: DynamicTriangulation((faceSides == FaceSides::DOUBLE_SIDED) ? 2 : 1)
+		{ }
+	};
+
+	/// \brief Dynamic 3D triangulation (see DynamicTriangulation), computed by BowyerWatson3D. The
+	/// mesh has the form of TetrahedronOutput::ELEMENTS.
+	class DynamicTriangulation3D : public DynamicTriangulation {
+	private:
+		/// The engine that holds the tetrahedration.
+		std::unique_ptr<BowyerWatson3D> m_engine = nullptr;
+
+		virtual bool insertMore(const std::vector<Eigen::Vector3d> & vertices, size_t firstIndex) override;
+		virtual bool removeVertex(const Eigen::Vector3d & point) override;
+		virtual void triangulateAll(const std::vector<Eigen::Vector3d> & vertices, const std::vector<size_t> & indices) override;
+		virtual size_t slotCount() const override;
+		virtual bool writeElement(size_t slot, face * faces) override;
+
+	public:
+		DynamicTriangulation3D()
+			: DynamicTriangulation(4)
+		{ }
+	};
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+namespace delaunay {
+
+	/// \brief Index of a vertex or an element stored in 32 bits, which halves the element records.
+	///
+	/// It converts to and from size_t, so the code indexing the containers does not see the 
+	/// difference. The no-neighbor value size_t(-1) is stored as -1 and restored by the sign 
+	/// extension, thus the indices up to MAX_INDEX can be stored.
+	class CompactIndex {
+		int32_t m_value;
+
+	public:
+		/// The largest index that can be stored.
+		static const size_t MAX_INDEX = size_t(INT32_MAX);
+
+		CompactIndex() = default;
+
+		CompactIndex(size_t index)
+			: m_value(int32_t(index))
+		{ }
+
+		operator size_t() const { return size_t(ptrdiff_t(m_value)); }
+	};
+
+	/// \brief Storage of triangulation elements (triangles, tetrahedrons) with stable indices.
+	///
+	/// Released elements are not removed, their slots are put on a free list and reused by the
+	/// elements allocated later. Thus no element is ever moved and the indices stored in the
+	/// neighbor links stay valid.
+	template<typename T>
+	class ElementPool {
+	public:
+		/// Reserves memory for the given number of elements.
+		void reserve(size_t count) {
+			m_elements.reserve(count);
+			m_isLive.reserve(count);
+		}
+
+		/// Removes all the elements. The memory is kept for the following ones.
+		void clear() {
+			m_elements.clear();
+			m_isLive.clear();
+			m_freeSlots.clear();
+			m_liveCount = 0;
+			m_peakCount = 0;
+		}
+
+		/// \brief Stores the element in a free slot (or in a new one when there is none) and
+		/// returns its index.
+		size_t allocate(const T & element) {
+			size_t index;
+			if (m_freeSlots.empty()) {
+				index = m_elements.size();
+				if (index > CompactIndex::MAX_INDEX)
+					throw std::length_error("Too many elements for the 32-bit indices.");
+				m_elements.push_back(element);
+				m_isLive.push_back(true);
+			}
+			else {
+				index = m_freeSlots.back();
+				m_freeSlots.pop_back();
+				m_elements[index] = element;
+				m_isLive[index] = true;
+			}
+
+			++m_liveCount;
+			m_peakCount = std::max(m_peakCount, m_liveCount);
+			return index;
+		}
+
+		/// Puts the slot of the element with given index on the free list.
+		void release(size_t index) {
+			m_isLive[index] = false;
+			m_freeSlots.push_back(index);
+			--m_liveCount;
+		}
+
+		T & operator[](size_t index) { return m_elements[index]; }
+		const T & operator[](size_t index) const { return m_elements[index]; }
+
+		/// Tells if the slot with given index holds an element, i.e. it was not released.
+		bool isLive(size_t index) const { return m_isLive[index]; }
+
+		/// Number of slots, live or free. All the indices are lower than this.
+		size_t size() const { return m_elements.size(); }
+
+		/// Number of live elements.
+		size_t liveCount() const { return m_liveCount; }
+
+		/// Maximal number of live elements at any moment.
+		size_t peakCount() const { return m_peakCount; }
+
+		/// Calls the functor for each live element with its index and the element itself.
+		template<typename F>
+		void forEachLive(F func) {
+			size_t slotCount = m_elements.size();
+			for (size_t index = 0; index < slotCount; ++index) {
+				if (m_isLive[index])
+					func(index, m_elements[index]);
+			}
+		}
+
+	private:
+		std::vector<T> m_elements = std::vector<T>();			///< All the slots.
+		std::vector<bool> m_isLive = std::vector<bool>();		///< Flags of the slots that hold an element.
+		std::vector<size_t> m_freeSlots = std::vector<size_t>();	///< Indices of the free slots.
+		size_t m_liveCount = 0;
+		size_t m_peakCount = 0;
+	};
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+namespace delaunay {
+
+	/// \brief Pairs up the faces shared by two new elements of a re-triangulated cavity.
+	///
+	/// Every face incident to the inserted vertex is shared by exactly two of the new elements, and
+	/// it is identified by its edge that does not contain the inserted vertex (in 2D the edge from
+	/// the inserted vertex serves the same purpose). The faces are matched in a small open-addressing
+	/// hash table. The table is kept between the insertions and invalidated by bumping a stamp,
+	/// so the matching does not allocate and does not clear the table.
+	///
+	/// The key type must have the m_v0, m_v1 members holding the vertex indices of the edge.
+	template<typename Key>
+	class FaceMatcher {
+	public:
+		/// \brief Prepares the table for matching the given number of faces. Faces added before
+		/// are forgotten.
+		void begin(size_t faceCount) {
+			size_t capacity = 16;
+			while (capacity < 2 * faceCount)
+				capacity *= 2;
+
+			if (capacity > m_slots.size()) {
+				m_slots.assign(capacity, Slot());
+				m_stamp = 0;
+			}
+
+			if (++m_stamp == 0) {
+				for (Slot & slot : m_slots)
+					slot.m_stamp = 0;
+				m_stamp = 1;
+			}
+		}
+
+		/// \brief Adds the face of the given element. When the other element sharing the same face
+		/// was added already, returns true and sets its index and face index.
+		bool match(const Key & key, size_t element, size_t face, size_t & otherElement, size_t & otherFace) {
+			size_t mask = m_slots.size() - 1;
+			size_t position = hash(key) & mask;
+
+			while (m_slots[position].m_stamp == m_stamp) {
+				Slot & slot = m_slots[position];
+				if (slot.m_v0 == key.m_v0 && slot.m_v1 == key.m_v1) {
+					otherElement = slot.m_element;
+					otherFace = slot.m_face;
+					return true;
+				}
+				position = (position + 1) & mask;
+			}
+
+			Slot & slot = m_slots[position];
+			slot.m_v0 = key.m_v0;
+			slot.m_v1 = key.m_v1;
+			slot.m_element = element;
+			slot.m_face = face;
+			slot.m_stamp = m_stamp;
+			return false;
+		}
+
+	private:
+		/// Entry of the table. It is occupied only when its stamp equals the current one.
+		struct Slot {
+			size_t m_v0 = 0;
+			size_t m_v1 = 0;
+			size_t m_element = 0;
+			size_t m_face = 0;
+			uint32_t m_stamp = 0;
+		};
+
+		static size_t hash(const Key & key) {
+			uint64_t h = uint64_t(key.m_v0) * 0x9E3779B97F4A7C15ull ^ uint64_t(key.m_v1) * 0xC2B2AE3D27D4EB4Full;
+			return size_t(h ^ (h >> 29));
+		}
+
+		std::vector<Slot> m_slots = std::vector<Slot>();
+		uint32_t m_stamp = 0;
+	};
+
+}
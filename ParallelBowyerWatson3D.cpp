@@ -0,0 +1,347 @@
+#include "stdafx.h"
+#include "ParallelBowyerWatson3D.h"
+#include "Predicates.h"
+
+using Eigen::Vector3d;
+using std::vector;
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	/// Number of vertices inserted serially before the threads start, so that they work apart.
+	static const size_t SERIAL_VERTEX_COUNT = 1024;
+	/// The smallest number of vertices of a round per thread.
+	static const size_t MIN_ROUND_VERTICES_PER_THREAD = 256;
+	/// \brief The largest number of vertices of a round per thread when the progress is reported,
+	/// which is done between the rounds. (Without it, the last round takes half of the vertices.)
+	static const size_t MAX_PROGRESS_ROUND_VERTICES_PER_THREAD = 16384;
+	/// \brief Number of free slots reserved per vertex. (An insertion adds about 6.5 tetrahedrons
+	/// on average, the rest reuses the slots of the removed ones.)
+	static const size_t SLOTS_PER_VERTEX = 8;
+	/// Free slots reserved for each thread on top of the ones per vertex.
+	static const size_t EXTRA_SLOTS = 256;
+	/// Number of attempts to insert a vertex before it is left for the serial insertion.
+	static const size_t INSERT_ATTEMPTS = 4;
+	/// \brief Number of removed tetrahedrons followed through their old neighbors when looking for
+	/// a live one, before falling back to scanning all of them.
+	static const size_t LIVE_SEARCH_STEPS = 64;
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	// LOCKING
+	// =======
+
+	bool ParallelBowyerWatson3D::tryLock(Worker & worker, size_t index)
+	{
+		std::atomic<unsigned> & lock = m_locks[index];
+		if (lock.load(std::memory_order_relaxed) == worker.m_id)
+			return true;
+
+		unsigned expected = 0;
+		if (!lock.compare_exchange_strong(expected, worker.m_id, std::memory_order_acquire))
+			return false;
+
+		worker.m_locked.push_back(index);
+		return true;
+	}
+
+	void ParallelBowyerWatson3D::unlockAll(Worker & worker)
+	{
+		for (size_t index : worker.m_locked)
+			m_locks[index].store(0, std::memory_order_release);
+		worker.m_locked.clear();
+	}
+
+
+	// CONCURRENT INSERTION
+	// ====================
+
+	bool ParallelBowyerWatson3D::locateConcurrently(Worker & worker, const Vector3d & point, size_t & located)
+	{
+		// The walk holds the lock of the current tetrahedron only. The next one is locked before
+		// the current one is released, so the link between them can not change in the meantime.
+		auto moveTo = [this, &worker](size_t current, size_t next) {
+			if (!tryLock(worker, next))
+				return false;
+
+			m_locks[current].store(0, std::memory_order_release);
+			worker.m_locked.erase(std::find(worker.m_locked.begin(), worker.m_locked.end(), current));
+			return true;
+		};
+
+		size_t current = worker.m_lastTetrahedron;
+		if (!tryLock(worker, current))
+			return false;
+
+		// The last created tetrahedron may have been removed by another thread meanwhile (it has
+		// the bad flag then). A live one is searched for through the old links of the removed 
+		// ones, or among all the slots.
+		size_t slotCount = m_currentTetrahedration.size();
+		for (size_t step = 0; m_currentTetrahedration[current].isBad(); ++step) {
+			size_t next = m_currentTetrahedration[current].m_neighbors[step % 4];
+			if (next == NO_NEIGHBOR || step >= LIVE_SEARCH_STEPS)
+				next = (current + 1) % slotCount;
+
+			if (!moveTo(current, next))
+				return false;
+			current = next;
+		}
+
+		size_t previous = NO_NEIGHBOR;
+		bool found = false;
+		while (!found) {
+			Tetrahedron & tetra = m_currentTetrahedration[current];
+			size_t rotation = worker.m_walkRotation++;
+
+			found = true;
+			for (size_t i = 0; i < 4; ++i) {
+				size_t face = (rotation + i) % 4;
+				size_t neighbor = tetra.m_neighbors[face];
+
+				if (neighbor == NO_NEIGHBOR || neighbor == previous)
+					continue;
+
+				std::array<Vector3d, 4> vecs;
+				for (size_t j = 0; j < 4; ++j)
+					vecs[j] = (j == face) ? point : m_vertices[tetra.m_v[j]];
+
+				if (orient3d(vecs[0], vecs[1], vecs[2], vecs[3]) < 0.0) {
+					if (!moveTo(current, neighbor))
+						return false;
+
+					previous = current;
+					current = neighbor;
+					found = false;
+					break;
+				}
+			}
+		}
+
+		located = current;
+		return true;
+	}
+
+	ParallelBowyerWatson3D::InsertResult ParallelBowyerWatson3D::insertConcurrently(Worker & worker, size_t vertexIndex)
+	{
+		const Vector3d point = m_vertices[vertexIndex];
+
+		// FINDING THE BAD TETRAHEDRONS
+		// ============================
+
+		// The same search as in BowyerWatson3D::insertVertex(), except that every tetrahedron is
+		// locked before it is read. The bad flags are only set on the locked tetrahedrons, so
+		// the other threads never see them.
+
+		vector<size_t> & badTetrahedra = worker.m_badTetrahedra;
+		badTetrahedra.clear();
+
+		auto abort = [this, &worker, &badTetrahedra](InsertResult result) {
+			for (size_t badIndex : badTetrahedra)
+				m_currentTetrahedration[badIndex].setBad(false);
+			unlockAll(worker);
+			return result;
+		};
+
+		size_t startIndex;
+		if (!locateConcurrently(worker, point, startIndex))
+			return abort(InsertResult::CONFLICT);
+
+		// The neighbors outside of the cavity are locked too, as their links get changed.
+		auto lockNeighbor = [this, &worker](size_t neighborIndex) { return tryLock(worker, neighborIndex); };
+		if (!findCavity(*this, m_currentTetrahedration, startIndex, point, worker.m_counters, badTetrahedra, lockNeighbor))
+			return abort(InsertResult::CONFLICT);
+
+		// CONSTRUCTING THE NEW TETRAHEDRONS
+		// =================================
+
+		vector<Tetrahedron> & newTetrahedra = worker.m_newTetrahedra;
+		fillCavity(vertexIndex, badTetrahedra, newTetrahedra);
+
+		if (newTetrahedra.size() > badTetrahedra.size() + worker.m_freeSlots.size())
+			return abort(InsertResult::OUT_OF_SLOTS);
+
+		// The bad tetrahedrons keep their flag, which marks them as removed. Their slots are
+		// reused first, as they are locked already.
+		for (size_t badIndex : badTetrahedra)
+			worker.m_freeSlots.push_back(badIndex);
+
+		vector<size_t> & newIndices = worker.m_newIndices;
+		newIndices.clear();
+		for (const Tetrahedron & newTetra : newTetrahedra) {
+			size_t index = worker.m_freeSlots.back();
+			worker.m_freeSlots.pop_back();
+
+			// A free slot can only be locked for a moment by a walk that started in it.
+			while (!tryLock(worker, index))
+				std::this_thread::yield();
+
+			m_currentTetrahedration[index] = newTetra;
+			newIndices.push_back(index);
+		}
+
+		connectNewTetrahedra(vertexIndex, newIndices, worker.m_innerFaces);
+
+		worker.m_lastTetrahedron = newIndices.back();
+		worker.m_counters.countInsertion(badTetrahedra.size(), newTetrahedra.size());
+		unlockAll(worker);
+		return InsertResult::INSERTED;
+	}
+
+	void ParallelBowyerWatson3D::runWorker(Worker & worker, size_t begin, size_t end)
+	{
+		for (size_t iVertex = begin; iVertex < end; ++iVertex) {
+			InsertResult result = InsertResult::CONFLICT;
+			for (size_t attempt = 0; attempt < INSERT_ATTEMPTS && result == InsertResult::CONFLICT; ++attempt) {
+				if (attempt > 0)
+					std::this_thread::yield();
+				result = insertConcurrently(worker, iVertex);
+			}
+
+			if (result != InsertResult::INSERTED)
+				worker.m_deferred.push_back(iVertex);
+		}
+	}
+
+
+	// ROUNDS
+	// ======
+
+	void ParallelBowyerWatson3D::prepareRound(size_t vertexCount)
+	{
+		// The free slots hold removed tetrahedrons, i.e. ones with the bad flag.
+		Tetrahedron freeSlot(*this, 0, 0, 0, 0);
+		freeSlot.setBad(true);
+
+		size_t slotsPerWorker = SLOTS_PER_VERTEX * (vertexCount / m_workers.size() + 1) + EXTRA_SLOTS;
+		for (Worker & worker : m_workers) {
+			while (worker.m_freeSlots.size() < slotsPerWorker)
+				worker.m_freeSlots.push_back(m_currentTetrahedration.allocate(freeSlot));
+		}
+
+		size_t slotCount = m_currentTetrahedration.size();
+		m_circumSpheres.resize(slotCount);
+
+		// The locks are all released between the rounds, so they are just created anew.
+		if (m_lockCount < slotCount) {
+			m_lockCount = std::max(slotCount, 2 * m_lockCount);
+			m_locks.reset(new std::atomic<unsigned>[m_lockCount]);
+			for (size_t i = 0; i < m_lockCount; ++i)
+				m_locks[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	size_t ParallelBowyerWatson3D::findLiveTetrahedron(size_t hint)
+	{
+		auto isLive = [this](size_t index) {
+			return m_currentTetrahedration.isLive(index) && !m_currentTetrahedration[index].isBad();
+		};
+
+		if (isLive(hint))
+			return hint;
+
+		for (const Worker & worker : m_workers) {
+			if (isLive(worker.m_lastTetrahedron))
+				return worker.m_lastTetrahedron;
+		}
+
+		size_t slotCount = m_currentTetrahedration.size();
+		for (size_t index = 0; index < slotCount; ++index) {
+			if (isLive(index))
+				return index;
+		}
+		return hint;
+	}
+
+	void ParallelBowyerWatson3D::triangulate(const vector<Vector3d> & inputVertices)
+	{
+		// PREPARATION PHASE
+		// =================
+
+		std::unique_ptr<ThreadPool> ownPool;
+		ThreadPool * pool = m_pool;
+		if (pool == nullptr) {
+			ownPool = std::make_unique<ThreadPool>();
+			pool = ownPool.get();
+		}
+
+		size_t firstVertexIndex, endVertexIndex;
+		std::tie(firstVertexIndex, endVertexIndex) = prepareInsertion(inputVertices);
+		PhaseClock clock;
+
+		// The first vertices are inserted serially, until there is enough tetrahedrons for the
+		// threads not to collide all the time.
+		size_t serialEnd = std::min(endVertexIndex, firstVertexIndex + SERIAL_VERTEX_COUNT);
+		for (size_t iVertex = firstVertexIndex; iVertex < serialEnd; ++iVertex)
+			insertVertex(iVertex);
+
+		double vertexCount = double(std::max(endVertexIndex - firstVertexIndex, size_t(1)));
+		reportProgress(double(serialEnd - firstVertexIndex) / vertexCount);
+
+		size_t threadCount = pool->threadCount();
+		m_workers.resize(threadCount);
+		for (size_t i = 0; i < threadCount; ++i) {
+			m_workers[i].m_id = unsigned(i + 1);
+			m_workers[i].m_lastTetrahedron = m_lastSimplex;
+			m_workers[i].m_counters = InsertionCounters();
+		}
+
+
+		// INSERTING THE VERTICES
+		// ======================
+
+		size_t roundBegin = serialEnd;
+		while (roundBegin < endVertexIndex) {
+			size_t insertedCount = roundBegin - firstVertexIndex;
+			size_t roundSize = std::max(insertedCount, threadCount * MIN_ROUND_VERTICES_PER_THREAD);
+			if (m_progress != nullptr)
+				roundSize = std::min(roundSize, threadCount * MAX_PROGRESS_ROUND_VERTICES_PER_THREAD);
+			size_t roundEnd = std::min(endVertexIndex, roundBegin + roundSize);
+
+			prepareRound(roundEnd - roundBegin);
+
+			// Each thread gets a contiguous part of the round, so that the threads work in
+			// different places.
+			ThreadPool::TaskGroup group;
+			for (size_t i = 0; i < threadCount; ++i) {
+				size_t begin = roundBegin + (roundEnd - roundBegin) * i / threadCount;
+				size_t end = roundBegin + (roundEnd - roundBegin) * (i + 1) / threadCount;
+
+				Worker & worker = m_workers[i];
+				pool->submit(group, [this, &worker, begin, end]() { runWorker(worker, begin, end); });
+			}
+			pool->wait(group);
+
+			// The vertices that could not be inserted concurrently are inserted serially.
+			m_lastSimplex = findLiveTetrahedron(m_workers[0].m_lastTetrahedron);
+			for (Worker & worker : m_workers) {
+				for (size_t iVertex : worker.m_deferred)
+					insertVertex(iVertex);
+				worker.m_deferred.clear();
+			}
+
+			for (Worker & worker : m_workers)
+				worker.m_lastTetrahedron = findLiveTetrahedron(worker.m_lastTetrahedron);
+
+			// The tasks of the round are finished, so the cancellation leaves none running.
+			reportProgress(double(roundEnd - firstVertexIndex) / vertexCount);
+			roundBegin = roundEnd;
+		}
+
+		// Give the unused slots back, so they are not converted.
+		for (Worker & worker : m_workers) {
+			m_counters.add(worker.m_counters);
+			for (size_t index : worker.m_freeSlots)
+				m_currentTetrahedration.release(index);
+			worker.m_freeSlots.clear();
+		}
+
+		m_phaseTimes.m_insertion = clock.lap();
+	}
+
+}
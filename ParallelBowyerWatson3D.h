@@ -0,0 +1,94 @@
+#pragma once
+#include "Delaunay3D.h"
+#include "ThreadPool.h"
+
+namespace delaunay {
+
+	/// \brief Multi-threaded version of BowyerWatson3D.
+	///
+	/// The vertices are inserted in rounds, each round twice as large as the previous one. The
+	/// vertices of a round are split into contiguous parts of the insertion order (which keeps
+	/// them far from each other) and the threads insert the parts concurrently. A thread locks
+	/// every tetrahedron it reads or modifies by an atomic flag. When a flag is held by another
+	/// thread, the insertion is undone and retried later. The tetrahedrons are only changed after
+	/// all the flags of the cavity and its neighbors are acquired, so the other threads never see
+	/// a cavity that is half done.
+	///
+	/// The slots for new tetrahedrons are given to the threads in advance, between the rounds.
+	/// Thus the storage never grows while the threads run. A vertex whose insertion keeps failing
+	/// or that runs out of slots is inserted serially after the round.
+	class ParallelBowyerWatson3D : public BowyerWatson3D {
+	private:
+		/// Result of an attempt to insert a vertex concurrently.
+		enum class InsertResult {
+			INSERTED,		///< The vertex is inserted.
+			CONFLICT,		///< Another thread holds some of the needed tetrahedrons.
+			OUT_OF_SLOTS	///< The thread does not have enough free slots for the new tetrahedrons.
+		};
+
+		/// The state of one thread inserting the vertices.
+		struct Worker {
+			unsigned m_id;					///< Value of the lock flags held by this thread.
+			size_t m_lastTetrahedron;		///< Index of the last created tetrahedron.
+			size_t m_walkRotation = 0;		///< See BowyerWatson3D::m_walkRotation.
+			InsertionCounters m_counters = InsertionCounters();	///< Counters of the insertions by this thread.
+
+			std::vector<size_t> m_freeSlots = std::vector<size_t>();	///< Slots reserved for this thread.
+			std::vector<size_t> m_locked = std::vector<size_t>();		///< Indices of the locked tetrahedrons.
+			std::vector<size_t> m_deferred = std::vector<size_t>();	///< Vertices left for the serial insertion.
+
+			// Scratch buffers of insertVertex(), see BowyerWatson3D.
+			std::vector<size_t> m_badTetrahedra = std::vector<size_t>();
+			std::vector<Tetrahedron> m_newTetrahedra = std::vector<Tetrahedron>();
+			std::vector<size_t> m_newIndices = std::vector<size_t>();
+			FaceMatcher<Edge> m_innerFaces = FaceMatcher<Edge>();
+		};
+
+		/// The pool that runs the threads, or null to create one for each invocation.
+		ThreadPool * m_pool;
+		/// \brief Lock flags of the tetrahedrons, indexed the same way as the tetrahedrons. Zero
+		/// means unlocked, otherwise it is the id of the thread holding it.
+		std::unique_ptr<std::atomic<unsigned>[]> m_locks = nullptr;
+		/// Number of the lock flags.
+		size_t m_lockCount = 0;
+		/// States of the threads.
+		std::vector<Worker> m_workers = std::vector<Worker>();
+
+		/// \brief Gives each thread enough free slots for inserting the given number of vertices
+		/// and makes room for them in the lock flags and the cached spheres.
+		void prepareRound(size_t vertexCount);
+
+		/// Inserts the vertices in range [begin, end) by the given thread.
+		void runWorker(Worker & worker, size_t begin, size_t end);
+
+		/// \brief Acquires the lock of the tetrahedron for the thread and remembers it. Returns false
+		/// when it is held by another thread.
+		bool tryLock(Worker & worker, size_t index);
+
+		/// Releases all the locks held by the thread.
+		void unlockAll(Worker & worker);
+
+		/// \brief Finds and locks the tetrahedron that contains the point (see
+		/// BowyerWatson3D::locateTetrahedron()). Returns false on a conflict.
+		bool locateConcurrently(Worker & worker, const Eigen::Vector3d & point, size_t & located);
+
+		/// Tries to insert the vertex with given index by the given thread.
+		InsertResult insertConcurrently(Worker & worker, size_t vertexIndex);
+
+		/// Returns the index of some tetrahedron that was not removed, preferably the given one.
+		size_t findLiveTetrahedron(size_t hint);
+
+		/// Constructs the delaunay tetrahedration of the input vertices by all the threads.
+		virtual void triangulate(const vertexCollection & inputVertices) override;
+
+	public:
+		/// \brief Creates the algorithm that runs on the given thread pool. Without a pool, one
+		/// with a thread per processor is created for each invocation.
+		explicit ParallelBowyerWatson3D(ThreadPool * pool = nullptr, InsertionOrder insertionOrder = InsertionOrder::BRIO, TetrahedronOutput output = TetrahedronOutput::SEPARATE)
+			: BowyerWatson3D(insertionOrder, output), m_pool(pool)
+		{ }
+
+		virtual ~ParallelBowyerWatson3D() {}
+	};
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace delaunay {
+
+	/// Wall-clock times of the phases of the last triangulation, in seconds.
+	struct PhaseTimes {
+		/// Construction of the bounding elements.
+		double m_bounding;
+		/// Sorting of the vertices into insertion order.
+		double m_sort;
+		/// Insertion of the vertices.
+		double m_insertion;
+		/// Conversion of the elements into the returned output.
+		double m_conversion;
+	};
+
+	/// Measures the time elapsed since the construction or since the last lap.
+	class PhaseClock {
+		std::chrono::steady_clock::time_point m_lapStart;
+
+	public:
+		PhaseClock() : m_lapStart(std::chrono::steady_clock::now()) {}
+
+		/// Returns the seconds elapsed in the current lap and starts the next one.
+		double lap() {
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(now - m_lapStart).count();
+			m_lapStart = now;
+			return seconds;
+		}
+	};
+
+}
@@ -0,0 +1,458 @@
+#include "stdafx.h"
+#include "Predicates.h"
+
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	/// Half of the machine epsilon, i.e. the largest relative rounding error of an operation.
+	static const double EPSILON = std::numeric_limits<double>::epsilon() / 2.0;
+	/// Splits a double into two halves with 26 significant bits, see split().
+	static const double SPLITTER = 134217729.0;		// 2^27 + 1
+
+	// Bounds of the rounding error of the floating-point evaluation of the determinants relative
+	// to the permanent of the matrix (the determinant with all the terms taken in absolute value).
+	static const double ORIENT2D_ERROR_BOUND = (3.0 + 16.0 * EPSILON) * EPSILON;
+	static const double ORIENT3D_ERROR_BOUND = (7.0 + 56.0 * EPSILON) * EPSILON;
+	static const double INCIRCLE_ERROR_BOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+	static const double INSPHERE_ERROR_BOUND = (16.0 + 224.0 * EPSILON) * EPSILON;
+
+	/// \brief Floating-point expansion, i.e. a sum of non-overlapping doubles ordered by increasing
+	/// magnitude. It can hold at most N components. The sign of the sum is the sign of the last
+	/// (largest) component.
+	template<size_t N>
+	struct Expansion {
+		double m_components[N];
+		size_t m_length;
+	};
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	// ERROR-FREE TRANSFORMATIONS
+	// ==========================
+
+	/// Computes x + y = a + b exactly, where x is the rounded sum. Requires |a| >= |b|.
+	inline static void fastTwoSum(double a, double b, double & x, double & y) {
+		x = a + b;
+		double bVirtual = x - a;
+		y = b - bVirtual;
+	}
+
+	/// Computes x + y = a + b exactly, where x is the rounded sum.
+	inline static void twoSum(double a, double b, double & x, double & y) {
+		x = a + b;
+		double bVirtual = x - a;
+		double aVirtual = x - bVirtual;
+		double bRoundoff = b - bVirtual;
+		double aRoundoff = a - aVirtual;
+		y = aRoundoff + bRoundoff;
+	}
+
+	/// Splits a into two non-overlapping halves, so that their products are exact.
+	inline static void split(double a, double & high, double & low) {
+		double c = SPLITTER * a;
+		double aBig = c - a;
+		high = c - aBig;
+		low = a - high;
+	}
+
+	/// Computes x + y = a * b exactly, where x is the rounded product.
+	inline static void twoProduct(double a, double b, double & x, double & y) {
+		x = a * b;
+
+		double aHigh, aLow, bHigh, bLow;
+		split(a, aHigh, aLow);
+		split(b, bHigh, bLow);
+
+		double error1 = x - (aHigh * bHigh);
+		double error2 = error1 - (aLow * bHigh);
+		double error3 = error2 - (aHigh * bLow);
+		y = (aLow * bLow) - error3;
+	}
+
+
+	// EXPANSION ARITHMETIC
+	// ====================
+
+	/// \brief Sums two expansions into h, which must have room for elen + flen components. Zero
+	/// components are eliminated. Returns the length of h. (fast_expansion_sum_zeroelim)
+	static size_t expansionSum(size_t elen, const double* e, size_t flen, const double* f, double* h)
+	{
+		size_t eIndex = 0;
+		size_t fIndex = 0;
+		size_t hIndex = 0;
+		double eNow = e[0];
+		double fNow = f[0];
+		double q, qNew, hh;
+
+		// Always takes the component of smaller magnitude first.
+		auto takeE = [&]() { return (fNow > eNow) == (fNow > -eNow); };
+		auto nextE = [&]() { ++eIndex; eNow = (eIndex < elen) ? e[eIndex] : 0.0; };
+		auto nextF = [&]() { ++fIndex; fNow = (fIndex < flen) ? f[fIndex] : 0.0; };
+
+		if (takeE()) {
+			q = eNow;
+			nextE();
+		}
+		else {
+			q = fNow;
+			nextF();
+		}
+
+		if (eIndex < elen && fIndex < flen) {
+			if (takeE()) {
+				fastTwoSum(eNow, q, qNew, hh);
+				nextE();
+			}
+			else {
+				fastTwoSum(fNow, q, qNew, hh);
+				nextF();
+			}
+			q = qNew;
+			if (hh != 0.0) h[hIndex++] = hh;
+
+			while (eIndex < elen && fIndex < flen) {
+				if (takeE()) {
+					twoSum(q, eNow, qNew, hh);
+					nextE();
+				}
+				else {
+					twoSum(q, fNow, qNew, hh);
+					nextF();
+				}
+				q = qNew;
+				if (hh != 0.0) h[hIndex++] = hh;
+			}
+		}
+
+		while (eIndex < elen) {
+			twoSum(q, eNow, qNew, hh);
+			nextE();
+			q = qNew;
+			if (hh != 0.0) h[hIndex++] = hh;
+		}
+
+		while (fIndex < flen) {
+			twoSum(q, fNow, qNew, hh);
+			nextF();
+			q = qNew;
+			if (hh != 0.0) h[hIndex++] = hh;
+		}
+
+		if (q != 0.0 || hIndex == 0)
+			h[hIndex++] = q;
+
+		return hIndex;
+	}
+
+	/// \brief Multiplies an expansion by a double into h, which must have room for 2 * elen
+	/// components. Zero components are eliminated. Returns the length of h.
+	/// (scale_expansion_zeroelim)
+	static size_t expansionScale(size_t elen, const double* e, double b, double* h)
+	{
+		size_t hIndex = 0;
+		double q, hh;
+
+		twoProduct(e[0], b, q, hh);
+		if (hh != 0.0) h[hIndex++] = hh;
+
+		for (size_t eIndex = 1; eIndex < elen; ++eIndex) {
+			double product1, product0, sum;
+			twoProduct(e[eIndex], b, product1, product0);
+
+			twoSum(q, product0, sum, hh);
+			if (hh != 0.0) h[hIndex++] = hh;
+
+			fastTwoSum(product1, sum, q, hh);
+			if (hh != 0.0) h[hIndex++] = hh;
+		}
+
+		if (q != 0.0 || hIndex == 0)
+			h[hIndex++] = q;
+
+		return hIndex;
+	}
+
+	template<size_t N, size_t M>
+	static Expansion<N + M> operator+(const Expansion<N> & e, const Expansion<M> & f) {
+		Expansion<N + M> result;
+		result.m_length = expansionSum(e.m_length, e.m_components, f.m_length, f.m_components, result.m_components);
+		return result;
+	}
+
+	template<size_t N>
+	static Expansion<N> operator-(const Expansion<N> & e) {
+		Expansion<N> result = e;
+		for (size_t i = 0; i < result.m_length; ++i)
+			result.m_components[i] = -result.m_components[i];
+		return result;
+	}
+
+	template<size_t N, size_t M>
+	static Expansion<N + M> operator-(const Expansion<N> & e, const Expansion<M> & f) {
+		return e + (-f);
+	}
+
+	template<size_t N>
+	static Expansion<2 * N> operator*(const Expansion<N> & e, double b) {
+		Expansion<2 * N> result;
+		result.m_length = expansionScale(e.m_length, e.m_components, b, result.m_components);
+		return result;
+	}
+
+	template<size_t N, size_t M>
+	static Expansion<2 * N * M> operator*(const Expansion<N> & e, const Expansion<M> & f) {
+		// The product is accumulated by scaling e by one component of f at a time.
+		Expansion<2 * N * M> result;
+		Expansion<2 * N * M> sum;
+		result.m_length = expansionScale(e.m_length, e.m_components, f.m_components[0], result.m_components);
+
+		for (size_t i = 1; i < f.m_length; ++i) {
+			Expansion<2 * N> scaled = e * f.m_components[i];
+			sum.m_length = expansionSum(result.m_length, result.m_components, scaled.m_length, scaled.m_components, sum.m_components);
+			std::copy(sum.m_components, sum.m_components + sum.m_length, result.m_components);
+			result.m_length = sum.m_length;
+		}
+
+		return result;
+	}
+
+	/// Returns the exact product a * b.
+	inline static Expansion<2> product(double a, double b) {
+		Expansion<2> result;
+		twoProduct(a, b, result.m_components[1], result.m_components[0]);
+		result.m_length = 2;
+		return result;
+	}
+
+
+	// EXACT DETERMINANTS
+	// ==================
+
+	// The exact versions evaluate the determinants on the original coordinates (the differences
+	// of coordinates would not be exact). The matrices are "lifted" by a column of ones:
+	//
+	//		orient2d:	| x y 1 |			incircle:	| x y x^2+y^2 1 |
+	//		orient3d:	| x y z 1 |			insphere:	| x y z x^2+y^2+z^2 1 |
+	//
+	// and the determinants are expanded by the cofactors of the last-but-one column.
+
+	/// Exact value of px * qy - qx * py.
+	inline static Expansion<4> minorXY(const Vector3d & p, const Vector3d & q) {
+		return product(p.x(), q.y()) - product(q.x(), p.y());
+	}
+
+	/// Exact value of the determinant | x y 1 | of three points.
+	inline static Expansion<12> minorXY1(const Vector3d & p, const Vector3d & q, const Vector3d & r) {
+		return minorXY(p, q) + minorXY(q, r) + minorXY(r, p);
+	}
+
+	/// Exact value of the determinant | x y z | of three points.
+	inline static Expansion<24> minorXYZ(const Vector3d & p, const Vector3d & q, const Vector3d & r) {
+		return minorXY(q, r) * p.z() - minorXY(p, r) * q.z() + minorXY(p, q) * r.z();
+	}
+
+	/// Exact value of the determinant | x y z 1 | of four points.
+	inline static Expansion<96> minorXYZ1(const Vector3d & p, const Vector3d & q, const Vector3d & r, const Vector3d & s) {
+		return (minorXYZ(p, q, r) - minorXYZ(p, q, s)) + (minorXYZ(p, r, s) - minorXYZ(q, r, s));
+	}
+
+	/// Exact value of x^2 + y^2 (+ z^2).
+	inline static Expansion<4> lift2(const Vector3d & p) {
+		return product(p.x(), p.x()) + product(p.y(), p.y());
+	}
+
+	inline static Expansion<6> lift3(const Vector3d & p) {
+		return lift2(p) + product(p.z(), p.z());
+	}
+
+	template<size_t N>
+	inline static double sign(const Expansion<N> & e) {
+		return e.m_components[e.m_length - 1];
+	}
+
+	static double orient2dExact(const Vector3d & a, const Vector3d & b, const Vector3d & c) {
+		return sign(minorXY1(a, b, c));
+	}
+
+	static double orient3dExact(const Vector3d & a, const Vector3d & b, const Vector3d & c, const Vector3d & d) {
+		// | x y z 1 | of (a, b, c, d) is positive for the negative orientation.
+		return -sign(minorXYZ1(a, b, c, d));
+	}
+
+	static double incircleExact(const Vector3d & a, const Vector3d & b, const Vector3d & c, const Vector3d & d) {
+		auto ab = lift2(a) * minorXY1(b, c, d) - lift2(b) * minorXY1(a, c, d);
+		auto cd = lift2(c) * minorXY1(a, b, d) - lift2(d) * minorXY1(a, b, c);
+		return sign(ab + cd);
+	}
+
+	static double insphereExact(const Vector3d & a, const Vector3d & b, const Vector3d & c, const Vector3d & d, const Vector3d & e) {
+		auto ab = lift3(a) * minorXYZ1(b, c, d, e) - lift3(b) * minorXYZ1(a, c, d, e);
+		auto cd = lift3(c) * minorXYZ1(a, b, d, e) - lift3(d) * minorXYZ1(a, b, c, e);
+		auto abcd = ab + cd;
+		auto ee = lift3(e) * minorXYZ1(a, b, c, d);
+		return sign(abcd + ee);
+	}
+
+
+	// FILTERED PREDICATES
+	// ===================
+
+	double orient2d(const Vector2d & a, const Vector2d & b, const Vector2d & c)
+	{
+		double detLeft = (a.x() - c.x()) * (b.y() - c.y());
+		double detRight = (a.y() - c.y()) * (b.x() - c.x());
+		double det = detLeft - detRight;
+
+		double errorBound = ORIENT2D_ERROR_BOUND * (std::abs(detLeft) + std::abs(detRight));
+		if (det > errorBound || -det > errorBound)
+			return det;
+
+		return orient2dExact(Vector3d(a.x(), a.y(), 0.0), Vector3d(b.x(), b.y(), 0.0), Vector3d(c.x(), c.y(), 0.0));
+	}
+
+	double incircle(const Vector2d & a, const Vector2d & b, const Vector2d & c, const Vector2d & d)
+	{
+		double adx = a.x() - d.x();
+		double bdx = b.x() - d.x();
+		double cdx = c.x() - d.x();
+		double ady = a.y() - d.y();
+		double bdy = b.y() - d.y();
+		double cdy = c.y() - d.y();
+
+		double bdxcdy = bdx * cdy;
+		double cdxbdy = cdx * bdy;
+		double aLift = adx * adx + ady * ady;
+
+		double cdxady = cdx * ady;
+		double adxcdy = adx * cdy;
+		double bLift = bdx * bdx + bdy * bdy;
+
+		double adxbdy = adx * bdy;
+		double bdxady = bdx * ady;
+		double cLift = cdx * cdx + cdy * cdy;
+
+		double det = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+
+		double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * aLift
+			+ (std::abs(cdxady) + std::abs(adxcdy)) * bLift
+			+ (std::abs(adxbdy) + std::abs(bdxady)) * cLift;
+
+		double errorBound = INCIRCLE_ERROR_BOUND * permanent;
+		if (det > errorBound || -det > errorBound)
+			return det;
+
+		return incircleExact(
+			Vector3d(a.x(), a.y(), 0.0),
+			Vector3d(b.x(), b.y(), 0.0),
+			Vector3d(c.x(), c.y(), 0.0),
+			Vector3d(d.x(), d.y(), 0.0));
+	}
+
+	double orient3d(const Vector3d & a, const Vector3d & b, const Vector3d & c, const Vector3d & d)
+	{
+		// The determinant is evaluated relative to the point a.
+		Vector3d bd = b - a;
+		Vector3d cd = c - a;
+		Vector3d dd = d - a;
+
+		double bxcy = bd.x() * cd.y();
+		double cxby = cd.x() * bd.y();
+		double cxdy = cd.x() * dd.y();
+		double dxcy = dd.x() * cd.y();
+		double dxby = dd.x() * bd.y();
+		double bxdy = bd.x() * dd.y();
+
+		double det = dd.z() * (bxcy - cxby) + bd.z() * (cxdy - dxcy) + cd.z() * (dxby - bxdy);
+
+		double permanent = (std::abs(bxcy) + std::abs(cxby)) * std::abs(dd.z())
+			+ (std::abs(cxdy) + std::abs(dxcy)) * std::abs(bd.z())
+			+ (std::abs(dxby) + std::abs(bxdy)) * std::abs(cd.z());
+
+		double errorBound = ORIENT3D_ERROR_BOUND * permanent;
+		if (det > errorBound || -det > errorBound)
+			return det;
+
+		return orient3dExact(a, b, c, d);
+	}
+
+	double insphere(const Vector3d & a, const Vector3d & b, const Vector3d & c, const Vector3d & d, const Vector3d & e)
+	{
+		double aex = a.x() - e.x();
+		double bex = b.x() - e.x();
+		double cex = c.x() - e.x();
+		double dex = d.x() - e.x();
+		double aey = a.y() - e.y();
+		double bey = b.y() - e.y();
+		double cey = c.y() - e.y();
+		double dey = d.y() - e.y();
+		double aez = a.z() - e.z();
+		double bez = b.z() - e.z();
+		double cez = c.z() - e.z();
+		double dez = d.z() - e.z();
+
+		double aexbey = aex * bey;
+		double bexaey = bex * aey;
+		double bexcey = bex * cey;
+		double cexbey = cex * bey;
+		double cexdey = cex * dey;
+		double dexcey = dex * cey;
+		double dexaey = dex * aey;
+		double aexdey = aex * dey;
+		double aexcey = aex * cey;
+		double cexaey = cex * aey;
+		double bexdey = bex * dey;
+		double dexbey = dex * bey;
+
+		double ab = aexbey - bexaey;
+		double bc = bexcey - cexbey;
+		double cd = cexdey - dexcey;
+		double da = dexaey - aexdey;
+		double ac = aexcey - cexaey;
+		double bd = bexdey - dexbey;
+
+		double abc = aez * bc - bez * ac + cez * ab;
+		double bcd = bez * cd - cez * bd + dez * bc;
+		double cda = cez * da + dez * ac + aez * cd;
+		double dab = dez * ab + aez * bd + bez * da;
+
+		double aLift = aex * aex + aey * aey + aez * aez;
+		double bLift = bex * bex + bey * bey + bez * bez;
+		double cLift = cex * cex + cey * cey + cez * cez;
+		double dLift = dex * dex + dey * dey + dez * dez;
+
+		// This is positive for a point inside the sphere of a negatively oriented tetrahedron.
+		double det = (dLift * abc - cLift * dab) + (bLift * cda - aLift * bcd);
+
+		double aezPlus = std::abs(aez);
+		double bezPlus = std::abs(bez);
+		double cezPlus = std::abs(cez);
+		double dezPlus = std::abs(dez);
+		double ab2 = std::abs(aexbey) + std::abs(bexaey);
+		double bc2 = std::abs(bexcey) + std::abs(cexbey);
+		double cd2 = std::abs(cexdey) + std::abs(dexcey);
+		double da2 = std::abs(dexaey) + std::abs(aexdey);
+		double ac2 = std::abs(aexcey) + std::abs(cexaey);
+		double bd2 = std::abs(bexdey) + std::abs(dexbey);
+
+		double permanent = (cd2 * bezPlus + bd2 * cezPlus + bc2 * dezPlus) * aLift
+			+ (da2 * cezPlus + ac2 * dezPlus + cd2 * aezPlus) * bLift
+			+ (ab2 * dezPlus + bd2 * aezPlus + da2 * bezPlus) * cLift
+			+ (bc2 * aezPlus + ac2 * bezPlus + ab2 * cezPlus) * dLift;
+
+		double errorBound = INSPHERE_ERROR_BOUND * permanent;
+		if (det > errorBound || -det > errorBound)
+			return -det;
+
+		return insphereExact(a, b, c, d, e);
+	}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace delaunay {
+
+	// GEOMETRIC PREDICATES
+	// ====================
+	//
+	// Each predicate first evaluates its determinant in ordinary floating-point arithmetic and
+	// compares it with a bound on the rounding error. Only when the sign can not be decided this
+	// way, the determinant is evaluated exactly using floating-point expansions (J. R. Shewchuk,
+	// Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates, 1997).
+	//
+	// Only the sign of the returned value is reliable, the magnitude is an approximation. The
+	// exact arithmetic needs IEEE 754 double precision with round-to-nearest, so this file must not
+	// be compiled with /fp:fast (or -ffast-math).
+
+	/// \brief Returns a positive value if the points a, b, c are in counter-clockwise order, a
+	/// negative value if they are in clockwise order and zero if they are collinear.
+	double orient2d(const Eigen::Vector2d & a, const Eigen::Vector2d & b, const Eigen::Vector2d & c);
+
+	/// \brief Returns a positive value if the point d lies inside the circle passing through the
+	/// counter-clockwise ordered points a, b, c, a negative value if it lies outside and zero if
+	/// the four points are co-circular.
+	double incircle(const Eigen::Vector2d & a, const Eigen::Vector2d & b, const Eigen::Vector2d & c, const Eigen::Vector2d & d);
+
+	/// \brief Returns a positive value if the point d lies on the side of the plane (a, b, c) from
+	/// which the points a, b, c appear in counter-clockwise order, a negative value if it lies on
+	/// the other side and zero if the four points are coplanar. (The tetrahedron (a, b, c, d) is
+	/// said to be positively oriented in the first case.)
+	double orient3d(const Eigen::Vector3d & a, const Eigen::Vector3d & b, const Eigen::Vector3d & c, const Eigen::Vector3d & d);
+
+	/// \brief Returns a positive value if the point e lies inside the sphere passing through the
+	/// points a, b, c, d of a positively oriented tetrahedron, a negative value if it lies outside
+	/// and zero if the five points are co-spherical.
+	double insphere(const Eigen::Vector3d & a, const Eigen::Vector3d & b, const Eigen::Vector3d & c, const Eigen::Vector3d & d, const Eigen::Vector3d & e);
+
+}
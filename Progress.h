@@ -0,0 +1,25 @@
+#pragma once
+
+namespace delaunay {
+
+	/// \brief Receiver of the progress of a long triangulation, which can also cancel it. The
+	/// engines call it from the thread that invoked them, once in a block of inserted vertices, so
+	/// it costs nothing measurable; an implementation that updates a user interface should still
+	/// throttle the updates by time.
+	class IProgress {
+	public:
+		/// \brief Reports the fraction (from 0 to 1) of the vertices that are inserted. Returns
+		/// true when the triangulation should be cancelled.
+		virtual bool update(double fraction) = 0;
+
+		virtual ~IProgress() {}
+	};
+
+	/// \brief Thrown out of an invocation that was cancelled by its progress. The engine is left
+	/// with a partial triangulation, which is only good to be destroyed.
+	class Cancelled : public std::exception {
+	public:
+		virtual const char* what() const noexcept override { return "The triangulation was cancelled."; }
+	};
+
+}
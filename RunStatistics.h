@@ -0,0 +1,71 @@
+#pragma once
+#include "PhaseTimes.h"
+
+namespace delaunay {
+
+	/// \brief Whether the engines count their work. Defining DELAUNAY_NO_STATISTICS turns each 
+	/// counting statement into a branch on a constant, which the compiler removes, and the counters
+	/// then stay zero.
+#ifdef DELAUNAY_NO_STATISTICS
+	static const bool COUNT_STATISTICS = false;
+#else
+	static const bool COUNT_STATISTICS = true;
+#endif
+
+	/// Counters of the work done by the insertions of the last triangulation.
+	struct InsertionCounters {
+		/// Number of the inserted vertices (the ones inserted by the refinement included).
+		size_t m_insertedVertices;
+		/// Number of the elements tested for the conflict with an inserted vertex.
+		size_t m_conflictTests;
+		/// Total number of the elements removed by the insertions, i.e. the sum of the cavity sizes.
+		size_t m_destroyedElements;
+		/// Number of the elements created by the insertions.
+		size_t m_createdElements;
+		/// Number of the elements in the largest cavity.
+		size_t m_maxCavitySize;
+
+		/// Adds the counts of the other counters.
+		void add(const InsertionCounters & other) {
+			m_insertedVertices += other.m_insertedVertices;
+			m_conflictTests += other.m_conflictTests;
+			m_destroyedElements += other.m_destroyedElements;
+			m_createdElements += other.m_createdElements;
+			m_maxCavitySize = std::max(m_maxCavitySize, other.m_maxCavitySize);
+		}
+
+		/// Counts the insertion of a vertex, whose cavity was replaced by the new elements.
+		void countInsertion(size_t cavitySize, size_t newCount) {
+			if (COUNT_STATISTICS) {
+				++m_insertedVertices;
+				m_destroyedElements += cavitySize;
+				m_createdElements += newCount;
+				m_maxCavitySize = std::max(m_maxCavitySize, cavitySize);
+			}
+		}
+
+		/// Counts the conflict tests of the given number of elements.
+		void countConflictTests(size_t count) {
+			if (COUNT_STATISTICS)
+				m_conflictTests += count;
+		}
+	};
+
+	/// Statistics of the last triangulation made by an engine.
+	struct RunStatistics {
+		/// Wall-clock times of the phases.
+		PhaseTimes m_phases;
+		/// Counters of the insertions.
+		InsertionCounters m_counters;
+		/// \brief Maximal number of the allocated elements at any moment (the bounding ones 
+		/// included). The parallel engine counts the slots reserved by its threads too.
+		size_t m_peakElements;
+
+		/// Average number of the elements in a cavity.
+		double averageCavitySize() const {
+			size_t insertedVertices = m_counters.m_insertedVertices;
+			return (insertedVertices > 0) ? double(m_counters.m_destroyedElements) / double(insertedVertices) : 0.0;
+		}
+	};
+
+}
@@ -0,0 +1,202 @@
+#include "stdafx.h"
+#include "SpatialSort.h"
+#include "Common.h"
+
+using Eigen::Vector3d;
+using std::vector;
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	/// Rounds smaller than this are not split any further by the BRIO.
+	static const size_t BRIO_MIN_ROUND_SIZE = 256;
+
+	/// Seed of the random shuffle done by the BRIO.
+	static const unsigned BRIO_SEED = 0x5eed;
+
+	using vertexIterator = vector<Vector3d>::iterator;
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	// HILBERT CURVE
+	// =============
+
+	/// \brief Computes the distance along the Hilbert curve of the point with given integer 
+	/// coordinates, each having <bits> bits. 
+	static uint64_t hilbertIndex(std::array<uint32_t, 3> x, size_t dimensions, size_t bits)
+	{
+		// This is the algorithm by John Skilling (Programming the Hilbert curve, 2004). It 
+		// transforms the coordinates into the "transposed" Hilbert index, whose bits are then 
+		// interleaved to get the index itself.
+
+		uint32_t m = uint32_t(1) << (bits - 1);
+
+		// Inverse undo.
+		for (uint32_t q = m; q > 1; q >>= 1) {
+			uint32_t p = q - 1;
+			for (size_t i = 0; i < dimensions; ++i) {
+				if (x[i] & q) {
+					x[0] ^= p;
+				}
+				else {
+					uint32_t t = (x[0] ^ x[i]) & p;
+					x[0] ^= t;
+					x[i] ^= t;
+				}
+			}
+		}
+
+		// Gray encode.
+		for (size_t i = 1; i < dimensions; ++i)
+			x[i] ^= x[i - 1];
+
+		uint32_t t = 0;
+		for (uint32_t q = m; q > 1; q >>= 1) {
+			if (x[dimensions - 1] & q)
+				t ^= q - 1;
+		}
+
+		for (size_t i = 0; i < dimensions; ++i)
+			x[i] ^= t;
+
+		// Interleave the bits, starting with the most significant ones.
+		uint64_t index = 0;
+		for (size_t bit = bits; bit-- > 0; ) {
+			for (size_t i = 0; i < dimensions; ++i)
+				index = (index << 1) | ((x[i] >> bit) & 1);
+		}
+
+		return index;
+	}
+
+	/// \brief Sorts the items in range [begin, end) along the Hilbert curve. The position of an
+	/// item is given by the function getPoint.
+	template <typename Iterator, typename GetPoint>
+	static void hilbertSort(Iterator begin, Iterator end, size_t dimensions, GetPoint getPoint)
+	{
+		using item = typename std::iterator_traits<Iterator>::value_type;
+
+		if (end - begin < 2)
+			return;
+
+		// The bits of the index must fit into 64 bits.
+		const size_t bits = (dimensions == 2) ? 31 : 21;
+		const double cellCount = double((uint32_t(1) << bits) - 1);
+
+		Vector3d minCorner = getPoint(*begin);
+		Vector3d maxCorner = getPoint(*begin);
+		for (auto it = begin; it != end; ++it) {
+			minCorner = minCorner.cwiseMin(getPoint(*it));
+			maxCorner = maxCorner.cwiseMax(getPoint(*it));
+		}
+
+		Vector3d extent = maxCorner - minCorner;
+		Vector3d scale;
+		for (size_t i = 0; i < 3; ++i)
+			scale(i) = (extent(i) > 0.0) ? (cellCount / extent(i)) : 0.0;
+
+		vector<std::pair<uint64_t, item>> keyed;
+		keyed.reserve(size_t(end - begin));
+		for (auto it = begin; it != end; ++it) {
+			const Vector3d & point = getPoint(*it);
+
+			std::array<uint32_t, 3> cell;
+			for (size_t i = 0; i < 3; ++i)
+				cell[i] = uint32_t((point(i) - minCorner(i)) * scale(i));
+
+			keyed.push_back(std::make_pair(hilbertIndex(cell, dimensions, bits), *it));
+		}
+
+		std::stable_sort(
+			keyed.begin(),
+			keyed.end(),
+			[](const std::pair<uint64_t, item> & lhs, const std::pair<uint64_t, item> & rhs) {
+				return lhs.first < rhs.first;
+			}
+		);
+
+		auto it = begin;
+		for (auto & keyedItem : keyed)
+			*it++ = keyedItem.second;
+	}
+
+	void sortByHilbertCurve(vertexIterator begin, vertexIterator end, size_t dimensions)
+	{
+		hilbertSort(begin, end, dimensions, [](const Vector3d & vertex) -> const Vector3d & { return vertex; });
+	}
+
+
+	// BIASED RANDOMIZED INSERTION ORDER
+	// =================================
+
+	/// \brief Reorders the items in range [begin, end) into biased randomized insertion order. The
+	/// position of an item is given by the function getPoint.
+	template <typename Iterator, typename GetPoint>
+	static void brioSort(Iterator begin, Iterator end, size_t dimensions, GetPoint getPoint)
+	{
+		// The vertices are shuffled and then split into rounds. The last round takes one half of 
+		// the vertices, the round before it one half of the rest and so on. Each round is then 
+		// sorted along the Hilbert curve, so the consecutive insertions are close to each other, 
+		// while the randomness of the rounds keeps the expected size of the cavities small.
+
+		std::mt19937 random(BRIO_SEED);
+		std::shuffle(begin, end, random);
+
+		Iterator roundEnd = end;
+		while (roundEnd != begin) {
+			size_t remaining = size_t(roundEnd - begin);
+			size_t roundSize = (remaining <= BRIO_MIN_ROUND_SIZE) ? remaining : (remaining - remaining / 2);
+
+			Iterator roundBegin = roundEnd - roundSize;
+			hilbertSort(roundBegin, roundEnd, dimensions, getPoint);
+			roundEnd = roundBegin;
+		}
+	}
+
+	void sortByBRIO(vertexIterator begin, vertexIterator end, size_t dimensions)
+	{
+		brioSort(begin, end, dimensions, [](const Vector3d & vertex) -> const Vector3d & { return vertex; });
+	}
+
+	void sortForInsertion(vertexIterator begin, vertexIterator end, InsertionOrder order, size_t dimensions)
+	{
+		switch (order) {
+		case InsertionOrder::BRIO:
+			sortByBRIO(begin, end, dimensions);
+			break;
+
+		case InsertionOrder::X_COORDINATE:
+			std::sort(begin, end, compareVectorByXCoord);
+			break;
+		}
+	}
+
+	void sortIndicesForInsertion(
+		const vector<Vector3d> & vertices,
+		vector<size_t>::iterator begin,
+		vector<size_t>::iterator end,
+		InsertionOrder order,
+		size_t dimensions)
+	{
+		auto getPoint = [&vertices](size_t index) -> const Vector3d & { return vertices[index]; };
+
+		switch (order) {
+		case InsertionOrder::BRIO:
+			brioSort(begin, end, dimensions, getPoint);
+			break;
+
+		case InsertionOrder::X_COORDINATE:
+			std::stable_sort(begin, end, [&vertices](size_t lhs, size_t rhs) {
+				return compareVectorByXCoord(vertices[lhs], vertices[rhs]);
+			});
+			break;
+		}
+	}
+
+}
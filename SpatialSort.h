@@ -0,0 +1,44 @@
+#pragma once
+
+namespace delaunay {
+
+	/// The order in which the input vertices are inserted into the triangulation.
+	enum class InsertionOrder {
+		/// \brief Biased randomized insertion order. The vertices are split into rounds of random 
+		/// samples growing in size and each round is sorted along the Hilbert curve.
+		BRIO,
+		/// The vertices are sorted by their x-coordinate.
+		X_COORDINATE
+	};
+
+	/// \brief Sorts the vertices along the Hilbert curve that fills their bounding box. Only the 
+	/// first <dimensions> coordinates (2 or 3) are taken into account.
+	void sortByHilbertCurve(
+		std::vector<Eigen::Vector3d>::iterator begin,
+		std::vector<Eigen::Vector3d>::iterator end,
+		size_t dimensions);
+
+	/// \brief Reorders the vertices into biased randomized insertion order. The random shuffle is 
+	/// seeded with a fixed value, so the resulting order is reproducible.
+	void sortByBRIO(
+		std::vector<Eigen::Vector3d>::iterator begin,
+		std::vector<Eigen::Vector3d>::iterator end,
+		size_t dimensions);
+
+	/// Reorders the vertices into the given insertion order.
+	void sortForInsertion(
+		std::vector<Eigen::Vector3d>::iterator begin,
+		std::vector<Eigen::Vector3d>::iterator end,
+		InsertionOrder order,
+		size_t dimensions);
+
+	/// \brief Reorders the indices of the given vertices into the given insertion order, 
+	/// leaving the vertices themselves untouched.
+	void sortIndicesForInsertion(
+		const std::vector<Eigen::Vector3d> & vertices,
+		std::vector<size_t>::iterator begin,
+		std::vector<size_t>::iterator end,
+		InsertionOrder order,
+		size_t dimensions);
+
+}
@@ -0,0 +1,280 @@
+#include "stdafx.h"
+#include "StreamingDelaunay2D.h"
+#include "SpatialSort.h"
+
+namespace delaunay {
+
+	using Eigen::Vector3d;
+	using std::vector;
+
+	const size_t StreamingDelaunay2D::NO_CELL;
+
+	StreamingDelaunay2D::StreamingDelaunay2D(const Vector3d & minCorner, const Vector3d & maxCorner, size_t columns, size_t rows, ITriangleSink & sink)
+		: m_sink(sink), m_minCorner(minCorner), m_maxCorner(maxCorner), m_columns(std::max(columns, size_t(1))), m_rows(std::max(rows, size_t(1)))
+	{
+		m_cellWidth = (m_maxCorner.x() - m_minCorner.x()) / double(m_columns);
+		m_cellHeight = (m_maxCorner.y() - m_minCorner.y()) / double(m_rows);
+
+		size_t cellCount = m_columns * m_rows;
+		m_isFinalized.assign(cellCount, false);
+		m_cellTriangles.resize(cellCount);
+		m_cellHints.assign(cellCount, BowyerWatson2D::NO_NEIGHBOR);
+
+		// The bounding triangles are enlarged the same way as those of the whole triangulation,
+		// so the triangles near the convex hull come out the same.
+		double maxD = std::max(m_maxCorner.x() - m_minCorner.x(), m_maxCorner.y() - m_minCorner.y());
+		Vector3d margin(maxD, maxD, 0.0);
+		m_engine.makeBoundingTriangles(Vector3d(m_minCorner - margin), Vector3d(m_maxCorner + margin));
+		m_engine.m_releasedVertices = &m_releasedVertices;
+
+		m_firstVertexIndex = m_engine.m_vertices.size();
+		m_vertexUses.assign(m_firstVertexIndex, 0);
+
+		size_t slotCount = m_engine.m_currentTriangulation.size();
+		m_waitingCell.assign(slotCount, NO_CELL);
+		for (size_t index = 0; index < slotCount; ++index)
+			scheduleTriangle(index);
+	}
+
+	size_t StreamingDelaunay2D::clampedColumn(double x) const
+	{
+		double column = std::floor((x - m_minCorner.x()) / m_cellWidth);
+		if (!(column > 0.0))
+			return 0;
+		return std::min(size_t(std::min(column, double(m_columns))), m_columns - 1);
+	}
+
+	size_t StreamingDelaunay2D::clampedRow(double y) const
+	{
+		double row = std::floor((y - m_minCorner.y()) / m_cellHeight);
+		if (!(row > 0.0))
+			return 0;
+		return std::min(size_t(std::min(row, double(m_rows))), m_rows - 1);
+	}
+
+	size_t StreamingDelaunay2D::cellOf(const Vector3d & point) const
+	{
+		bool isInside = (m_minCorner.x() <= point.x()) && (point.x() <= m_maxCorner.x())
+			&& (m_minCorner.y() <= point.y()) && (point.y() <= m_maxCorner.y());
+
+		if (isInside == false)
+			return NO_CELL;
+
+		return clampedRow(point.y()) * m_columns + clampedColumn(point.x());
+	}
+
+	bool StreamingDelaunay2D::insertPoints(const vector<Vector3d> & points)
+	{
+		for (const Vector3d & point : points) {
+			size_t cell = cellOf(point);
+			if (cell == NO_CELL || m_isFinalized[cell])
+				return false;
+		}
+
+		vector<size_t> order(points.size());
+		std::iota(order.begin(), order.end(), size_t(0));
+		sortIndicesForInsertion(points, order.begin(), order.end(), m_engine.m_insertionOrder, 2);
+
+		BowyerWatson2D::trianglePool & triangles = m_engine.m_currentTriangulation;
+		for (size_t index : order) {
+			size_t cell = cellOf(points[index]);
+			size_t vertexIndex = allocateVertex(points[index], m_nextInputIndex + index);
+
+			m_engine.m_lastSimplex = findStartTriangle(cell);
+			m_releasedVertices.clear();
+			m_engine.insertVertex(vertexIndex);
+			m_cellHints[cell] = m_engine.m_lastSimplex;
+			m_lastCell = cell;
+
+			if (m_waitingCell.size() < triangles.size())
+				m_waitingCell.resize(triangles.size(), NO_CELL);
+
+			// The bad triangles leave their cells, the new ones (some of them in the same slots)
+			// are scheduled again. The uses are counted before they are removed, so no vertex of 
+			// the new triangles is freed meanwhile.
+			for (size_t badIndex : m_engine.m_badTriangles)
+				m_waitingCell[badIndex] = NO_CELL;
+
+			for (size_t newIndex : m_engine.m_newIndices) {
+				for (size_t vertex : triangles[newIndex].m_v)
+					++m_vertexUses[vertex];
+			}
+
+			for (size_t vertex : m_releasedVertices)
+				releaseVertexUse(vertex);
+
+			// A duplicate point is not connected to any triangle.
+			if (m_vertexUses[vertexIndex] == 0)
+				m_freeVertexSlots.push_back(vertexIndex);
+
+			for (size_t newIndex : m_engine.m_newIndices)
+				scheduleTriangle(newIndex);
+		}
+
+		m_nextInputIndex += points.size();
+		return true;
+	}
+
+	void StreamingDelaunay2D::finalizeCell(size_t cell)
+	{
+		if (m_isFinalized[cell])
+			return;
+
+		m_isFinalized[cell] = true;
+		m_cellHints[cell] = BowyerWatson2D::NO_NEIGHBOR;
+		if (m_lastCell == cell)
+			m_lastCell = NO_CELL;
+
+		vector<size_t> waiting;
+		waiting.swap(m_cellTriangles[cell]);
+		for (size_t index : waiting) {
+			if (m_engine.m_currentTriangulation.isLive(index) && m_waitingCell[index] == cell) {
+				m_waitingCell[index] = NO_CELL;
+				scheduleTriangle(index);
+			}
+		}
+	}
+
+	void StreamingDelaunay2D::finish()
+	{
+		size_t cellCount = m_isFinalized.size();
+		for (size_t cell = 0; cell < cellCount; ++cell)
+			finalizeCell(cell);
+	}
+
+	size_t StreamingDelaunay2D::allocateVertex(const Vector3d & point, size_t inputIndex)
+	{
+		VertexStore<VertexScalar> & vertices = m_engine.m_vertices;
+		vector<size_t> & inputIndices = m_engine.m_inputIndices;
+
+		size_t vertexIndex;
+		if (m_freeVertexSlots.empty()) {
+			vertexIndex = vertices.size();
+			vertices.push_back(point);
+			inputIndices.push_back(inputIndex);
+			m_vertexUses.push_back(0);
+		}
+		else {
+			vertexIndex = m_freeVertexSlots.back();
+			m_freeVertexSlots.pop_back();
+			vertices.set(vertexIndex, point);
+			inputIndices[vertexIndex - m_firstVertexIndex] = inputIndex;
+		}
+
+		return vertexIndex;
+	}
+
+	void StreamingDelaunay2D::releaseVertexUse(size_t vertexIndex)
+	{
+		--m_vertexUses[vertexIndex];
+		if (m_vertexUses[vertexIndex] == 0 && vertexIndex >= m_firstVertexIndex)
+			m_freeVertexSlots.push_back(vertexIndex);
+	}
+
+	void StreamingDelaunay2D::scheduleTriangle(size_t index)
+	{
+		// The circle can only be changed by a point inside of it. Its bounding box (enlarged by 
+		// the error of the cached center) is tested against the grid, a degenerate circle 
+		// overlaps all the cells.
+
+		const CircumsphereStore & circles = m_engine.m_circumSpheres;
+		double radius = std::sqrt(circles.m_radiusSquared[index]);
+		double reach = radius * (1.0 + 1e-12) + circles.m_centerError[index];
+		double centerX = circles.m_centerX[index];
+		double centerY = circles.m_centerY[index];
+
+		size_t firstColumn = 0, lastColumn = m_columns - 1;
+		size_t firstRow = 0, lastRow = m_rows - 1;
+		if (std::isfinite(reach) && std::isfinite(centerX) && std::isfinite(centerY)) {
+			bool isOutside = (centerX + reach < m_minCorner.x()) || (centerX - reach > m_maxCorner.x())
+				|| (centerY + reach < m_minCorner.y()) || (centerY - reach > m_maxCorner.y());
+
+			if (isOutside) {
+				finishTriangle(index);
+				return;
+			}
+
+			firstColumn = clampedColumn(centerX - reach);
+			lastColumn = clampedColumn(centerX + reach);
+			firstRow = clampedRow(centerY - reach);
+			lastRow = clampedRow(centerY + reach);
+		}
+
+		for (size_t row = firstRow; row <= lastRow; ++row) {
+			for (size_t column = firstColumn; column <= lastColumn; ++column) {
+				size_t cell = row * m_columns + column;
+				if (m_isFinalized[cell])
+					continue;
+
+				// The stale entries are dropped whenever the list doubles in size.
+				vector<size_t> & waiting = m_cellTriangles[cell];
+				if (waiting.size() >= 64 && (waiting.size() & (waiting.size() - 1)) == 0) {
+					auto isStale = [this, cell](size_t entry) {
+						return m_engine.m_currentTriangulation.isLive(entry) == false || m_waitingCell[entry] != cell;
+					};
+					waiting.erase(std::remove_if(waiting.begin(), waiting.end(), isStale), waiting.end());
+				}
+
+				waiting.push_back(index);
+				m_waitingCell[index] = cell;
+				return;
+			}
+		}
+
+		finishTriangle(index);
+	}
+
+	void StreamingDelaunay2D::finishTriangle(size_t index)
+	{
+		BowyerWatson2D::trianglePool & triangles = m_engine.m_currentTriangulation;
+		BowyerWatson2D::Triangle & triangle = triangles[index];
+
+		if (triangle.isBounding(m_engine) == false) {
+			m_sink.triangle(
+				m_engine.inputIndex(triangle.m_v[0]), 
+				m_engine.inputIndex(triangle.m_v[1]), 
+				m_engine.inputIndex(triangle.m_v[2]));
+		}
+
+		// The neighbors are left with a hole, which the walks never cross.
+		for (size_t neighborIndex : triangle.m_neighbors) {
+			if (neighborIndex == BowyerWatson2D::NO_NEIGHBOR)
+				continue;
+
+			for (CompactIndex & backLink : triangles[neighborIndex].m_neighbors) {
+				if (backLink == index)
+					backLink = BowyerWatson2D::NO_NEIGHBOR;
+			}
+		}
+
+		triangles.release(index);
+		m_waitingCell[index] = NO_CELL;
+
+		for (size_t vertex : triangle.m_v)
+			releaseVertexUse(vertex);
+	}
+
+	size_t StreamingDelaunay2D::findStartTriangle(size_t cell)
+	{
+		const BowyerWatson2D::trianglePool & triangles = m_engine.m_currentTriangulation;
+
+		// The consecutive points of a chunk are mostly close to each other, as they are sorted
+		// along the Hilbert curve in each round.
+		bool isLastLive = triangles.isLive(m_engine.m_lastSimplex);
+		if (isLastLive && cell == m_lastCell)
+			return m_engine.m_lastSimplex;
+
+		size_t hint = m_cellHints[cell];
+		if (hint != BowyerWatson2D::NO_NEIGHBOR && triangles.isLive(hint))
+			return hint;
+
+		if (isLastLive)
+			return m_engine.m_lastSimplex;
+
+		size_t index = 0;
+		while (triangles.isLive(index) == false)
+			++index;
+		return index;
+	}
+
+}
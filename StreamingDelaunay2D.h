@@ -0,0 +1,108 @@
+#pragma once
+#include "Delaunay2D.h"
+
+namespace delaunay {
+
+	/// \brief Streaming construction of 2D delaunay triangulation (M. Isenburg, Y. Liu, 
+	/// J. Shewchuk, J. Snoeyink: Streaming Computation of Delaunay Triangulations, 2006).
+	///
+	/// The bounding box of all the points is known in advance and it is split into a grid of 
+	/// cells. The points arrive in chunks and the caller finalizes a cell once no more points will
+	/// arrive in it. A triangle whose circumscribed circle lies only in the finalized cells (or 
+	/// outside of the box) can not be changed by any later point, so it is passed to the sink and
+	/// freed right away. The slots of the vertices that no remaining triangle refers to are 
+	/// reused. Thus the memory is bounded by the active front of the triangulation, as long as the
+	/// points arrive in a spatially coherent order.
+	class StreamingDelaunay2D {
+	public:
+		/// Value of a cell index that signalizes there is no cell.
+		static const size_t NO_CELL = size_t(-1);
+
+		/// \brief Creates the triangulation of the points in the box with given corners, split 
+		/// into the given number of columns and rows. The finished triangles are passed to the 
+		/// sink (its begin() is not called, as their count is not known in advance).
+		StreamingDelaunay2D(const Eigen::Vector3d & minCorner, const Eigen::Vector3d & maxCorner, size_t columns, size_t rows, ITriangleSink & sink);
+
+		/// \brief Returns the index of the cell that contains the point, or NO_CELL when it lies 
+		/// outside of the box. The cells are numbered by rows.
+		size_t cellOf(const Eigen::Vector3d & point) const;
+
+		/// \brief Inserts the chunk of points, numbering them by the input indices after the 
+		/// previous chunks. Returns false, without inserting anything, when some of them lie 
+		/// outside of the box or in a finalized cell.
+		bool insertPoints(const std::vector<Eigen::Vector3d> & points);
+
+		/// \brief Marks the cell as finalized, i.e. no more points will arrive in it. The 
+		/// triangles that are finished by it are passed to the sink.
+		void finalizeCell(size_t cell);
+
+		/// Finalizes all the remaining cells, so all the triangles are passed to the sink.
+		void finish();
+
+		/// Number of the triangles held in memory.
+		size_t activeTriangleCount() const { return m_engine.m_currentTriangulation.liveCount(); }
+
+		/// Maximal number of the triangles held in memory at any moment.
+		size_t peakTriangleCount() const { return m_engine.m_currentTriangulation.peakCount(); }
+
+		/// Number of the vertices held in memory.
+		size_t activeVertexCount() const { return m_engine.m_vertices.size() - m_firstVertexIndex - m_freeVertexSlots.size(); }
+
+	private:
+		/// The engine that holds the active triangles.
+		BowyerWatson2D m_engine;
+		/// The receiver of the finished triangles.
+		ITriangleSink & m_sink;
+
+		Eigen::Vector3d m_minCorner;
+		Eigen::Vector3d m_maxCorner;
+		size_t m_columns;
+		size_t m_rows;
+		double m_cellWidth;
+		double m_cellHeight;
+
+		/// Flags of the finalized cells.
+		std::vector<bool> m_isFinalized = std::vector<bool>();
+		/// \brief Triangles waiting for each cell to be finalized. The entry is valid only while
+		/// m_waitingCell of the triangle refers to the cell, the stale entries are skipped.
+		std::vector<std::vector<size_t>> m_cellTriangles = std::vector<std::vector<size_t>>();
+		/// The cell each triangle (by its slot) waits for, or NO_CELL.
+		std::vector<size_t> m_waitingCell = std::vector<size_t>();
+		/// Triangle created by the last insertion into each cell. The walks start from it.
+		std::vector<size_t> m_cellHints = std::vector<size_t>();
+		/// Cell of the last inserted point.
+		size_t m_lastCell = NO_CELL;
+
+		/// Index of the first vertex that is not a bounding one.
+		size_t m_firstVertexIndex;
+		/// Number of the active triangles that refer to each vertex.
+		std::vector<size_t> m_vertexUses = std::vector<size_t>();
+		/// Slots of the vertices that no triangle refers to anymore.
+		std::vector<size_t> m_freeVertexSlots = std::vector<size_t>();
+		/// Vertices of the triangles released by the last insertion, filled by the engine.
+		std::vector<size_t> m_releasedVertices = std::vector<size_t>();
+		/// Input index of the next inserted point.
+		size_t m_nextInputIndex = 0;
+
+		/// Returns the index of the column (row) in which the coordinate lies, clamped to the grid.
+		size_t clampedColumn(double x) const;
+		size_t clampedRow(double y) const;
+
+		/// Stores the point in a free vertex slot and returns its index.
+		size_t allocateVertex(const Eigen::Vector3d & point, size_t inputIndex);
+
+		/// Removes one use of the vertex, its slot is freed when there is no use left.
+		void releaseVertexUse(size_t vertexIndex);
+
+		/// \brief Makes the triangle wait for some of the unfinalized cells that its circle 
+		/// overlaps. When there is none, the triangle is finished.
+		void scheduleTriangle(size_t index);
+
+		/// Passes the triangle to the sink (unless it is a bounding one) and frees it.
+		void finishTriangle(size_t index);
+
+		/// Returns the index of some live triangle, preferably the hint of the cell.
+		size_t findStartTriangle(size_t cell);
+	};
+
+}
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	/// The pool that the current thread works for, if any.
+	static thread_local const ThreadPool * currentPool = nullptr;
+	/// Index of the queue of the current thread in its pool.
+	static thread_local size_t currentQueue = 0;
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	ThreadPool::ThreadPool(size_t threadCount)
+		: m_queuedCount(0)
+	{
+		if (threadCount == 0)
+			threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+		for (size_t i = 0; i < threadCount; ++i)
+			m_queues.push_back(std::make_unique<Queue>());
+
+		for (size_t i = 1; i < threadCount; ++i)
+			m_workers.push_back(std::thread([this, i]() { workerLoop(i); }));
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stopping = true;
+		}
+		m_wakeUp.notify_all();
+
+		for (std::thread & worker : m_workers)
+			worker.join();
+	}
+
+	size_t ThreadPool::ownQueue() const
+	{
+		return (currentPool == this) ? currentQueue : 0;
+	}
+
+	void ThreadPool::submit(TaskGroup & group, Task task)
+	{
+		++group.m_pending;
+
+		Queue & queue = *m_queues[ownQueue()];
+		{
+			std::lock_guard<std::mutex> lock(queue.m_mutex);
+			queue.m_tasks.push_back(QueuedTask{ std::move(task), &group });
+		}
+
+		// The counter is changed under the lock, so a worker can not miss it between checking
+		// it and falling asleep.
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			++m_queuedCount;
+		}
+		m_wakeUp.notify_one();
+	}
+
+	void ThreadPool::wait(TaskGroup & group)
+	{
+		size_t queueIndex = ownQueue();
+		while (group.m_pending > 0) {
+			if (!runTask(queueIndex))
+				std::this_thread::yield();
+		}
+
+		std::lock_guard<std::mutex> lock(group.m_errorMutex);
+		if (group.m_error) {
+			std::exception_ptr error = group.m_error;
+			group.m_error = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+	bool ThreadPool::runTask(size_t queueIndex)
+	{
+		QueuedTask queued = QueuedTask();
+		bool found = false;
+
+		size_t queueCount = m_queues.size();
+		for (size_t i = 0; i < queueCount && !found; ++i) {
+			Queue & queue = *m_queues[(queueIndex + i) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.m_mutex);
+			if (queue.m_tasks.empty())
+				continue;
+
+			// The own queue is used as a stack, the other ones as queues.
+			if (i == 0) {
+				queued = std::move(queue.m_tasks.back());
+				queue.m_tasks.pop_back();
+			}
+			else {
+				queued = std::move(queue.m_tasks.front());
+				queue.m_tasks.pop_front();
+			}
+			found = true;
+		}
+
+		if (!found)
+			return false;
+
+		--m_queuedCount;
+		try {
+			queued.m_task();
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(queued.m_group->m_errorMutex);
+			if (!queued.m_group->m_error)
+				queued.m_group->m_error = std::current_exception();
+		}
+		--queued.m_group->m_pending;
+		return true;
+	}
+
+	void ThreadPool::workerLoop(size_t queueIndex)
+	{
+		currentPool = this;
+		currentQueue = queueIndex;
+
+		while (true) {
+			if (runTask(queueIndex))
+				continue;
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wakeUp.wait(lock, [this]() { return m_stopping || m_queuedCount > 0; });
+			if (m_stopping && m_queuedCount == 0)
+				return;
+		}
+	}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace delaunay {
+
+	/// \brief Pool of worker threads that run fork-join style tasks.
+	///
+	/// Each thread has its own task queue. A thread takes the tasks from the back of its own
+	/// queue (the most recently submitted, which keeps the recursion depth-first) and when it runs
+	/// out of work it steals from the front of the other queues. A thread waiting for a group of
+	/// tasks runs the queued tasks in the meantime, so recursive tasks can wait for their
+	/// subtasks without blocking the pool.
+	class ThreadPool {
+	public:
+		using Task = std::function<void()>;
+
+		/// \brief Group of submitted tasks that can be waited for. The first exception thrown by
+		/// a task of the group is rethrown by ThreadPool::wait().
+		class TaskGroup {
+		public:
+			TaskGroup() : m_pending(0) { }
+
+		private:
+			friend class ThreadPool;
+
+			std::atomic<size_t> m_pending;		///< Number of unfinished tasks.
+			std::mutex m_errorMutex;
+			std::exception_ptr m_error = nullptr;
+		};
+
+		/// \brief Creates the pool. The thread count includes the threads that submit the tasks
+		/// and wait for them, so a pool of one thread runs everything on the caller. Zero means
+		/// the number of hardware threads.
+		explicit ThreadPool(size_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+		/// Number of threads that run the tasks, including the waiting thread.
+		size_t threadCount() const { return m_queues.size(); }
+
+		/// Queues the task to be run by any of the threads.
+		void submit(TaskGroup & group, Task task);
+
+		/// \brief Runs the queued tasks until all the tasks of the group are finished. Rethrows
+		/// the first exception thrown by them.
+		void wait(TaskGroup & group);
+
+	private:
+		struct QueuedTask {
+			Task m_task;
+			TaskGroup * m_group;
+		};
+
+		struct Queue {
+			std::mutex m_mutex;
+			std::deque<QueuedTask> m_tasks;
+		};
+
+		/// Index of the queue that belongs to the calling thread.
+		size_t ownQueue() const;
+
+		/// \brief Takes a task from the given queue or steals one from the other queues and runs
+		/// it. Returns false when there was no task to run.
+		bool runTask(size_t queueIndex);
+
+		void workerLoop(size_t queueIndex);
+
+		/// Queue 0 is shared by all the threads outside of the pool, the others belong to the workers.
+		std::vector<std::unique_ptr<Queue>> m_queues = std::vector<std::unique_ptr<Queue>>();
+		std::vector<std::thread> m_workers = std::vector<std::thread>();
+
+		std::atomic<size_t> m_queuedCount;		///< Number of tasks in all the queues.
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wakeUp;
+		bool m_stopping = false;
+	};
+
+}
@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "VertexMerging.h"
+
+using Eigen::Vector3d;
+using std::vector;
+
+namespace delaunay {
+
+	// =============================================================================
+	// DECLARATIONS
+	// =============================================================================
+
+	/// Index that ends the list of the kept vertices of a cell.
+	static const size_t NO_VERTEX = size_t(-1);
+
+	/// The cells further than this from the origin (in the cell sizes) are clamped to it.
+	static const double MAX_CELL_COORDINATE = 1e18;
+
+	/// Integer coordinates of a cell of the grid.
+	using Cell = std::array<int64_t, 3>;
+
+	/// Hash of the cell coordinates, which mixes all three of them into each bit.
+	struct CellHash {
+		size_t operator()(const Cell & cell) const {
+			uint64_t hash = uint64_t(cell[0]) * 0x9e3779b97f4a7c15ull;
+			hash = (hash ^ (hash >> 29) ^ uint64_t(cell[1])) * 0xbf58476d1ce4e5b9ull;
+			hash = (hash ^ (hash >> 27) ^ uint64_t(cell[2])) * 0x94d049bb133111ebull;
+			return size_t(hash ^ (hash >> 31));
+		}
+	};
+
+	/// \brief Hash table from the cells to the first kept vertex in each of them, with open 
+	/// addressing by linear probing. There are at most as many cells as vertices, so the table
+	/// is allocated at once and stays at most half full.
+	class CellTable {
+		/// Slot of the table, it is empty while the first vertex is NO_VERTEX.
+		struct Slot {
+			Cell m_cell;
+			size_t m_first;
+		};
+
+		std::vector<Slot> m_slots;
+		size_t m_mask;
+
+	public:
+		explicit CellTable(size_t vertexCount) {
+			size_t capacity = 16;
+			while (capacity < 2 * vertexCount)
+				capacity *= 2;
+
+			m_slots.assign(capacity, Slot{ Cell{ { 0, 0, 0 } }, NO_VERTEX });
+			m_mask = capacity - 1;
+		}
+
+		/// Returns the first kept vertex of the cell, or NO_VERTEX when there is none.
+		size_t find(const Cell & cell) const {
+			for (size_t i = CellHash()(cell) & m_mask; ; i = (i + 1) & m_mask) {
+				const Slot & slot = m_slots[i];
+				if (slot.m_first == NO_VERTEX || slot.m_cell == cell)
+					return slot.m_first;
+			}
+		}
+
+		/// Returns the first kept vertex of the cell, which can be changed. 
+		size_t & first(const Cell & cell) {
+			for (size_t i = CellHash()(cell) & m_mask; ; i = (i + 1) & m_mask) {
+				Slot & slot = m_slots[i];
+				if (slot.m_first == NO_VERTEX)
+					slot.m_cell = cell;
+				if (slot.m_cell == cell)
+					return slot.m_first;
+			}
+		}
+	};
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	/// \brief Returns the cell of the grid that contains the vertex. With a zero cell size, the 
+	/// cells are the coordinates themselves, so only the equal vertices share a cell.
+	static Cell cellOf(const Vector3d & vertex, double cellSize, size_t dimensions)
+	{
+		Cell cell = { 0, 0, 0 };
+		for (size_t i = 0; i < dimensions; ++i) {
+			if (cellSize > 0.0) {
+				double coordinate = std::floor(vertex[i] / cellSize);
+				coordinate = std::max(-MAX_CELL_COORDINATE, std::min(coordinate, MAX_CELL_COORDINATE));
+				cell[i] = int64_t(coordinate);
+			}
+			else {
+				// Adding zero turns the negative zero into the positive one.
+				double coordinate = vertex[i] + 0.0;
+				std::memcpy(&cell[i], &coordinate, sizeof(coordinate));
+			}
+		}
+
+		return cell;
+	}
+
+	vector<size_t> mergeNearbyVertices(const vector<Vector3d> & vertices, double distance, size_t dimensions)
+	{
+		double cellSize = std::max(distance, 0.0);
+		double squaredDistance = cellSize * cellSize;
+		int64_t reach = (cellSize > 0.0) ? 1 : 0;
+
+		// The first kept vertex of each cell, the others are linked from it.
+		CellTable firstInCell(vertices.size());
+		vector<size_t> nextInCell(vertices.size(), NO_VERTEX);
+
+		vector<size_t> result(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const Vector3d & vertex = vertices[i];
+			Cell cell = cellOf(vertex, cellSize, dimensions);
+
+			// The kept vertices lie further than the distance from each other, so each cell holds
+			// only a few of them.
+			size_t target = NO_VERTEX;
+			Cell neighbor = cell;
+			int64_t reachZ = (dimensions == 3) ? reach : 0;
+			for (int64_t dx = -reach; dx <= reach; ++dx) {
+				for (int64_t dy = -reach; dy <= reach; ++dy) {
+					for (int64_t dz = -reachZ; dz <= reachZ; ++dz) {
+						neighbor[0] = cell[0] + dx;
+						neighbor[1] = cell[1] + dy;
+						neighbor[2] = cell[2] + dz;
+
+						for (size_t kept = firstInCell.find(neighbor); kept != NO_VERTEX; kept = nextInCell[kept]) {
+							Vector3d difference = vertices[kept] - vertex;
+							if (dimensions == 2)
+								difference.z() = 0.0;
+
+							if (kept < target && difference.squaredNorm() <= squaredDistance)
+								target = kept;
+						}
+					}
+				}
+			}
+
+			if (target != NO_VERTEX) {
+				result[i] = target;
+				continue;
+			}
+
+			result[i] = i;
+			size_t & first = firstInCell.first(cell);
+			nextInCell[i] = first;
+			first = i;
+		}
+
+		return result;
+	}
+
+}
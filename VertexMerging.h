@@ -0,0 +1,18 @@
+#pragma once
+
+namespace delaunay {
+
+	/// \brief Merges the vertices that lie within the given distance of each other. Returns the 
+	/// index of the vertex that each vertex is merged into, which is the first vertex of its group
+	/// in the input order (an unmerged vertex is merged into itself). Only the first <dimensions>
+	/// coordinates (2 or 3) are taken into account, a zero distance merges the coincident vertices.
+	///
+	/// The kept vertices are hashed into a uniform grid of cells as large as the distance, so each
+	/// vertex is compared only with the kept vertices of the neighboring cells, which takes linear
+	/// time on average.
+	std::vector<size_t> mergeNearbyVertices(
+		const std::vector<Eigen::Vector3d> & vertices,
+		double distance,
+		size_t dimensions);
+
+}
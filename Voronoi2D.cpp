@@ -0,0 +1,421 @@
+#include "stdafx.h"
+#include "Voronoi2D.h"
+#include "Predicates.h"
+#include "Common.h"
+
+namespace delaunay {
+
+	using Eigen::Vector2d;
+	using Eigen::Vector3d;
+	using std::vector;
+
+	const size_t Voronoi2D::NO_CORNER;
+
+	/// \brief Positions along the boundary of the box that differ by less than this are taken as
+	/// the same one, so a rounding error does not make the cell go around the whole box.
+	static const double BOUNDARY_POSITION_TOLERANCE = 1e-9;
+
+	size_t Voronoi2D::findGroup(size_t triangle)
+	{
+		// Path halving keeps the trees flat.
+		while (m_groups[triangle] != triangle) {
+			m_groups[triangle] = m_groups[m_groups[triangle]];
+			triangle = m_groups[triangle];
+		}
+
+		return triangle;
+	}
+
+	void Voronoi2D::groupCoCircularTriangles()
+	{
+		using Triangle = BowyerWatson2D::Triangle;
+
+		m_groups.resize(m_engine->m_currentTriangulation.size());
+		std::iota(m_groups.begin(), m_groups.end(), size_t(0));
+
+		// The neighbors whose apex lies exactly on the circle have the same center. Each pair is
+		// tested once, from the triangle with the lower index. The group is represented by its
+		// lowest triangle.
+		const VertexStore<VertexScalar> & vertices = m_engine->m_vertices;
+		m_engine->m_currentTriangulation.forEachLive(
+			[this, &vertices](size_t index, Triangle & triangle) {
+				for (size_t edge = 0; edge < 3; ++edge) {
+					size_t neighborIndex = triangle.m_neighbors[edge];
+					if (neighborIndex == BowyerWatson2D::NO_NEIGHBOR || neighborIndex < index)
+						continue;
+
+					const Triangle & neighbor = m_engine->m_currentTriangulation[neighborIndex];
+					size_t apex = 0;
+					while (neighbor.m_neighbors[apex] != index)
+						++apex;
+
+					bool isOnCircle = incircle(
+						toVector2d(vertices[triangle.m_v[0]]),
+						toVector2d(vertices[triangle.m_v[1]]),
+						toVector2d(vertices[triangle.m_v[2]]),
+						toVector2d(vertices[neighbor.m_v[apex]])) == 0.0;
+
+					if (isOnCircle) {
+						size_t group = findGroup(index);
+						size_t neighborGroup = findGroup(neighborIndex);
+						m_groups[std::max(group, neighborGroup)] = std::min(group, neighborGroup);
+					}
+				}
+			}
+		);
+	}
+
+	Vector2d Voronoi2D::groupCenter(size_t group) const
+	{
+		const CircumsphereStore & circles = m_engine->m_circumSpheres;
+		return Vector2d(circles.m_centerX[group], circles.m_centerY[group]);
+	}
+
+	size_t Voronoi2D::centerCorner(size_t group)
+	{
+		if (m_centerCorners[group] == NO_CORNER)
+			m_centerCorners[group] = addCorner(groupCenter(group));
+
+		return m_centerCorners[group];
+	}
+
+	size_t Voronoi2D::boxCorner(size_t index)
+	{
+		if (m_boxCorners[index] == NO_CORNER) {
+			bool isRight = (index == 1 || index == 2);
+			bool isTop = (index >= 2);
+			m_boxCorners[index] = addCorner(Vector2d(
+				isRight ? m_maxCorner.x() : m_minCorner.x(),
+				isTop ? m_maxCorner.y() : m_minCorner.y()));
+		}
+
+		return m_boxCorners[index];
+	}
+
+	size_t Voronoi2D::addCorner(const Vector2d & point)
+	{
+		m_cells->m_corners.push_back(Vector3d(point.x(), point.y(), m_minCorner.z()));
+		return m_cells->m_corners.size() - 1;
+	}
+
+	bool Voronoi2D::isInBox(const Vector2d & point) const
+	{
+		return (m_minCorner.x() <= point.x()) && (point.x() <= m_maxCorner.x())
+			&& (m_minCorner.y() <= point.y()) && (point.y() <= m_maxCorner.y());
+	}
+
+	bool Voronoi2D::clipSegment(const Vector2d & a, const Vector2d & b, double & enter, double & leave, size_t & enterSide, size_t & leaveSide) const
+	{
+		// The k-th side keeps the points with direction * t <= distance. The sides go
+		// counter-clockwise from the bottom one.
+		const Vector2d d = b - a;
+		const std::array<double, 4> directions = { { -d.y(), d.x(), d.y(), -d.x() } };
+		const std::array<double, 4> distances = { {
+			a.y() - m_minCorner.y(),
+			m_maxCorner.x() - a.x(),
+			m_maxCorner.y() - a.y(),
+			a.x() - m_minCorner.x() } };
+
+		enter = 0.0;
+		leave = 1.0;
+		for (size_t side = 0; side < 4; ++side) {
+			if (directions[side] == 0.0) {
+				if (distances[side] < 0.0)
+					return false;
+				continue;
+			}
+
+			double parameter = distances[side] / directions[side];
+			if (directions[side] < 0.0) {
+				if (parameter > enter) {
+					enter = parameter;
+					enterSide = side;
+				}
+			}
+			else if (parameter < leave) {
+				leave = parameter;
+				leaveSide = side;
+			}
+		}
+
+		return enter <= leave;
+	}
+
+	Vector2d Voronoi2D::pointOnSide(const Vector2d & a, const Vector2d & b, double parameter, size_t side) const
+	{
+		Vector2d point = a + parameter * (b - a);
+		point.x() = std::min(std::max(point.x(), m_minCorner.x()), m_maxCorner.x());
+		point.y() = std::min(std::max(point.y(), m_minCorner.y()), m_maxCorner.y());
+
+		switch (side) {
+		case 0: point.y() = m_minCorner.y(); break;
+		case 1: point.x() = m_maxCorner.x(); break;
+		case 2: point.y() = m_maxCorner.y(); break;
+		default: point.x() = m_minCorner.x(); break;
+		}
+
+		return point;
+	}
+
+	double Voronoi2D::boundaryPosition(const Vector2d & point, size_t side) const
+	{
+		double width = m_maxCorner.x() - m_minCorner.x();
+		double height = m_maxCorner.y() - m_minCorner.y();
+
+		switch (side) {
+		case 0: return (point.x() - m_minCorner.x()) / width;
+		case 1: return 1.0 + (point.y() - m_minCorner.y()) / height;
+		case 2: return 2.0 + (m_maxCorner.x() - point.x()) / width;
+		default: return 3.0 + (m_maxCorner.y() - point.y()) / height;
+		}
+	}
+
+	void Voronoi2D::appendBoxCorners(double from, double to)
+	{
+		if (to < from - BOUNDARY_POSITION_TOLERANCE)
+			to += 4.0;
+
+		for (double corner = std::floor(from) + 1.0; corner < to; corner += 1.0)
+			m_cells->m_cellCorners.push_back(boxCorner(size_t(corner) % 4));
+	}
+
+	void Voronoi2D::appendCell(size_t vertex)
+	{
+		const ElementPool<BowyerWatson2D::Triangle> & triangulation = m_engine->m_currentTriangulation;
+		vector<size_t> & cellCorners = m_cells->m_cellCorners;
+
+		// THE GROUPS AROUND THE SITE
+		// ==========================
+
+		// The triangle (vertex, a, b) is followed counter-clockwise by the one across the edge
+		// (b, vertex), i.e. opposite to a. The consecutive triangles of the same group form one
+		// corner of the cell.
+
+		m_ring.clear();
+		size_t first = m_engine->m_vertexTriangles[vertex];
+		size_t current = first;
+		do {
+			const BowyerWatson2D::Triangle & triangle = triangulation[current];
+			size_t position = 0;
+			while (triangle.m_v[position] != vertex)
+				++position;
+
+			size_t edge = (position + 1) % 3;
+			size_t group = findGroup(current);
+			if (m_ring.empty() || m_ring.back()[0] != group)
+				m_ring.push_back({ { group, current, edge } });
+			else
+				m_ring.back() = { { group, current, edge } };
+
+			current = triangle.m_neighbors[edge];
+		} while (current != first && current != BowyerWatson2D::NO_NEIGHBOR);
+
+		if (m_ring.size() > 1 && m_ring.back()[0] == m_ring.front()[0])
+			m_ring.pop_back();
+
+		size_t count = m_ring.size();
+		if (count < 3)
+			return;
+
+
+		// CLIPPING OF THE CELL
+		// ====================
+
+		// The corners inside of the box are kept and the edges of the cell are cut where they
+		// cross it. Where the cell leaves the box and enters it again, the corners of the box
+		// between these two points are inserted.
+
+		size_t cellStart = cellCorners.size();
+		bool hasLeft = false;
+		double leavePosition = 0.0;
+		bool hasEntered = false;
+		double firstEnterPosition = 0.0;
+
+		for (size_t k = 0; k < count; ++k) {
+			const std::array<size_t, 3> & entry = m_ring[k];
+			const Vector2d a = groupCenter(entry[0]);
+			const Vector2d b = groupCenter(m_ring[(k + 1) % count][0]);
+
+			if (isInBox(a))
+				cellCorners.push_back(centerCorner(entry[0]));
+
+			// The edge is clipped in the direction from the triangle with the lower index, so
+			// the cell on its other side gets the same crossing corners.
+			size_t triangle = entry[1];
+			size_t edge = entry[2];
+			size_t neighbor = triangulation[triangle].m_neighbors[edge];
+			bool isReversed = neighbor < triangle;
+			if (isReversed) {
+				edge = 0;
+				while (triangulation[neighbor].m_neighbors[edge] != triangle)
+					++edge;
+				std::swap(triangle, neighbor);
+			}
+
+			const Vector2d & from = isReversed ? b : a;
+			const Vector2d & to = isReversed ? a : b;
+			double enter, leave;
+			size_t enterSide = 0, leaveSide = 0;
+			if (clipSegment(from, to, enter, leave, enterSide, leaveSide) == false)
+				continue;
+
+			// Crossing 0 is where the clipped edge enters the box, 1 is where it leaves.
+			std::array<bool, 2> hasCrossing = { { enter > 0.0, leave < 1.0 } };
+			std::array<Vector2d, 2> points;
+			std::array<size_t, 2> sides = { { enterSide, leaveSide } };
+			std::array<size_t, 2> corners;
+			for (size_t i = 0; i < 2; ++i) {
+				if (hasCrossing[i] == false)
+					continue;
+
+				points[i] = pointOnSide(from, to, (i == 0) ? enter : leave, sides[i]);
+				size_t & corner = m_crossingCorners[6 * triangle + 2 * edge + i];
+				if (corner == NO_CORNER)
+					corner = addCorner(points[i]);
+				corners[i] = corner;
+			}
+
+			size_t inCrossing = isReversed ? 1 : 0;
+			size_t outCrossing = 1 - inCrossing;
+			if (hasCrossing[inCrossing]) {
+				double position = boundaryPosition(points[inCrossing], sides[inCrossing]);
+				if (hasLeft) {
+					appendBoxCorners(leavePosition, position);
+					hasLeft = false;
+				}
+				else if (hasEntered == false) {
+					hasEntered = true;
+					firstEnterPosition = position;
+				}
+
+				cellCorners.push_back(corners[inCrossing]);
+			}
+
+			if (hasCrossing[outCrossing]) {
+				cellCorners.push_back(corners[outCrossing]);
+				hasLeft = true;
+				leavePosition = boundaryPosition(points[outCrossing], sides[outCrossing]);
+			}
+		}
+
+		if (hasLeft && hasEntered)
+			appendBoxCorners(leavePosition, firstEnterPosition);
+
+		// No edge of the cell reaches into the box, so the box lies either inside of the cell
+		// or outside of it.
+		if (cellCorners.size() == cellStart) {
+			const Vector2d probe = 0.5 * toVector2d(m_minCorner + m_maxCorner);
+			bool isInside = true;
+			for (size_t k = 0; k < count; ++k) {
+				if (orient2d(groupCenter(m_ring[k][0]), groupCenter(m_ring[(k + 1) % count][0]), probe) < 0.0)
+					isInside = false;
+			}
+
+			if (isInside) {
+				for (size_t corner = 0; corner < 4; ++corner)
+					cellCorners.push_back(boxCorner(corner));
+			}
+		}
+	}
+
+	VoronoiCells Voronoi2D::invoke(const vector<Vector3d> & sites)
+	{
+		PhaseClock clock;
+
+		VoronoiCells cells;
+		m_cells = &cells;
+		cells.m_cellStarts.reserve(sites.size() + 1);
+		cells.m_cellStarts.push_back(0);
+
+		bool isBoxEmpty = !(m_minCorner.x() < m_maxCorner.x() && m_minCorner.y() < m_maxCorner.y());
+		if (sites.empty() || isBoxEmpty) {
+			cells.m_cellStarts.resize(sites.size() + 1, 0);
+			m_cells = nullptr;
+			return cells;
+		}
+
+		// TRIANGULATION OF THE SITES
+		// ==========================
+
+		// Each point of the box is closer to some site than the diameter of the box and the
+		// sites, so the bounding vertices placed farther than it do not change the cells there.
+		Vector3d minCorner = m_minCorner;
+		Vector3d maxCorner = m_maxCorner;
+		for (const Vector3d & site : sites) {
+			minCorner = minCorner.cwiseMin(site);
+			maxCorner = maxCorner.cwiseMax(site);
+		}
+
+		double margin = 2.0 * toVector2d(maxCorner - minCorner).norm();
+		Vector3d marginVector(margin, margin, 0.0);
+
+		m_engine = std::make_unique<BowyerWatson2D>();
+		size_t expectedTriangleCount = 2 * (sites.size() + 4);
+		m_engine->m_currentTriangulation.reserve(expectedTriangleCount);
+		m_engine->m_circumSpheres.reserve(expectedTriangleCount);
+		m_engine->makeBoundingTriangles(Vector3d(minCorner - marginVector), Vector3d(maxCorner + marginVector));
+
+		size_t firstVertexIndex = m_engine->m_vertices.size();
+		m_phaseTimes.m_bounding = clock.lap();
+
+		m_engine->insertMore(sites, 0);
+		m_phaseTimes.m_insertion = clock.lap();
+
+
+		// CONSTRUCTION OF THE CELLS
+		// =========================
+
+		vector<size_t> vertexOfSite(sites.size());
+		for (size_t i = 0; i < m_engine->m_inputIndices.size(); ++i)
+			vertexOfSite[m_engine->m_inputIndices[i]] = firstVertexIndex + i;
+
+		m_engine->m_vertexTriangles.assign(m_engine->m_vertices.size(), BowyerWatson2D::NO_NEIGHBOR);
+		m_engine->m_currentTriangulation.forEachLive(
+			[this](size_t index, BowyerWatson2D::Triangle & triangle) {
+				for (size_t vertex : triangle.m_v)
+					m_engine->m_vertexTriangles[vertex] = index;
+			}
+		);
+
+		groupCoCircularTriangles();
+
+		size_t slotCount = m_engine->m_currentTriangulation.size();
+		m_centerCorners.assign(slotCount, NO_CORNER);
+		m_crossingCorners.assign(6 * slotCount, NO_CORNER);
+		m_boxCorners.fill(NO_CORNER);
+		cells.m_corners.reserve(2 * sites.size());
+		cells.m_cellCorners.reserve(6 * sites.size());
+
+		// The cells are built in the insertion order of the vertices, which follows the space, so
+		// the walks around the neighboring sites share the triangles in the cache. Then they are
+		// copied into the order of the sites.
+		size_t vertexCount = m_engine->m_vertices.size() - firstVertexIndex;
+		vector<size_t> vertexCellStarts(vertexCount + 1, 0);
+		for (size_t i = 0; i < vertexCount; ++i) {
+			if (m_engine->m_vertexTriangles[firstVertexIndex + i] != BowyerWatson2D::NO_NEIGHBOR)
+				appendCell(firstVertexIndex + i);
+			vertexCellStarts[i + 1] = cells.m_cellCorners.size();
+		}
+
+		// A duplicate site gets the cell of the site at its position.
+		vector<size_t> vertexCorners;
+		vertexCorners.swap(cells.m_cellCorners);
+		cells.m_cellCorners.reserve(vertexCorners.size());
+		for (size_t site = 0; site < sites.size(); ++site) {
+			size_t vertex = m_engine->findConnectedVertex(vertexOfSite[site]);
+			if (vertex != BowyerWatson2D::NO_NEIGHBOR) {
+				size_t i = vertex - firstVertexIndex;
+				cells.m_cellCorners.insert(cells.m_cellCorners.end(), vertexCorners.begin() + vertexCellStarts[i], vertexCorners.begin() + vertexCellStarts[i + 1]);
+			}
+
+			cells.m_cellStarts.push_back(cells.m_cellCorners.size());
+		}
+
+		m_engine = nullptr;
+		m_cells = nullptr;
+		m_phaseTimes.m_conversion = clock.lap();
+
+		return cells;
+	}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "Delaunay2D.h"
+
+namespace delaunay {
+
+	/// \brief Cells of the 2D voronoi diagram of a set of sites, clipped to a box. The cells are
+	/// convex polygons that share their corners with the neighboring cells.
+	struct VoronoiCells {
+		/// Corners of the cells. They lie in the plane of the minimal corner of the box.
+		std::vector<Eigen::Vector3d> m_corners = std::vector<Eigen::Vector3d>();
+		/// Indices of the corners of all the cells, each cell in counter-clockwise order.
+		std::vector<size_t> m_cellCorners = std::vector<size_t>();
+		/// \brief Start of the cell of each site in m_cellCorners, followed by their total count.
+		/// The corners of the i-th cell are in the range [m_cellStarts[i], m_cellStarts[i + 1]).
+		std::vector<size_t> m_cellStarts = std::vector<size_t>();
+
+		/// Returns the number of the cells, which equals the number of the sites.
+		size_t cellCount() const { return m_cellStarts.empty() ? 0 : m_cellStarts.size() - 1; }
+	};
+
+	/// \brief Computes the voronoi diagram of 2D sites (given by their x and y coordinates) as
+	/// the dual of their delaunay triangulation.
+	///
+	/// The corners of a cell are the cached centers of the circumscribed circles of the triangles
+	/// around its site, so each cell is built by a single walk around the site. The bounding
+	/// vertices of the triangulation lie so far from the box that the cells of the sites on the
+	/// convex hull are closed by them only outside of it. The cells are then clipped to the box.
+	/// A cell shared by duplicate sites is returned for each of them, a cell that does not reach
+	/// into the box is empty.
+	class Voronoi2D {
+		/// Value of a corner index that signalizes there is no corner yet.
+		static const size_t NO_CORNER = size_t(-1);
+
+		/// Minimal corner of the box that the cells are clipped to.
+		Eigen::Vector3d m_minCorner;
+		/// Maximal corner of the box that the cells are clipped to.
+		Eigen::Vector3d m_maxCorner;
+		/// The times of the phases of the last invocation.
+		PhaseTimes m_phaseTimes = PhaseTimes();
+
+		// State of the current invocation.
+
+		/// Triangulation of the sites.
+		std::unique_ptr<BowyerWatson2D> m_engine = nullptr;
+		/// The returned cells.
+		VoronoiCells * m_cells = nullptr;
+		/// \brief Group of each triangle, the triangles of a group have the same circle (their
+		/// vertices are co-circular), so they form a single corner. See findGroup().
+		std::vector<size_t> m_groups = std::vector<size_t>();
+		/// Corner at the center of each group, or NO_CORNER when it is not created yet.
+		std::vector<size_t> m_centerCorners = std::vector<size_t>();
+		/// \brief Corners where the edge of the diagram dual to each edge of the triangulation
+		/// crosses the box (two for each edge, the one closer to the triangle first).
+		std::vector<size_t> m_crossingCorners = std::vector<size_t>();
+		/// Corners at the corners of the box, counter-clockwise from the minimal one.
+		std::array<size_t, 4> m_boxCorners;
+		/// \brief Groups around the current site in counter-clockwise order, each with the
+		/// triangle and its edge that leads to the next one.
+		std::vector<std::array<size_t, 3>> m_ring = std::vector<std::array<size_t, 3>>();
+
+		/// Returns the representative triangle of the group of the triangle.
+		size_t findGroup(size_t triangle);
+
+		/// Joins the triangles whose circles are the same into groups.
+		void groupCoCircularTriangles();
+
+		/// Returns the center of the circle of the group as a 2D point.
+		Eigen::Vector2d groupCenter(size_t group) const;
+
+		/// Returns the corner at the center of the group, it is created by the first call.
+		size_t centerCorner(size_t group);
+
+		/// Returns the corner at the given corner of the box, it is created by the first call.
+		size_t boxCorner(size_t index);
+
+		/// Appends the corner with given position and returns its index.
+		size_t addCorner(const Eigen::Vector2d & point);
+
+		/// Tells if the point lies inside of the box (or on its boundary).
+		bool isInBox(const Eigen::Vector2d & point) const;
+
+		/// \brief Clips the segment (a, b) to the box (J. Liang, B. Barsky: A New Concept and
+		/// Method for Line Clipping, 1984). Returns false when it misses the box. Otherwise the
+		/// parameters of the part inside of the box and the sides of the box where it enters and
+		/// leaves are set, the side of a parameter 0 or 1 is not set.
+		bool clipSegment(const Eigen::Vector2d & a, const Eigen::Vector2d & b, double & enter, double & leave, size_t & enterSide, size_t & leaveSide) const;
+
+		/// \brief Returns the point on the side of the box at given parameter of the segment,
+		/// placed exactly on the side.
+		Eigen::Vector2d pointOnSide(const Eigen::Vector2d & a, const Eigen::Vector2d & b, double parameter, size_t side) const;
+
+		/// \brief Returns the position of the point on the given side along the boundary of the
+		/// box, counter-clockwise from 0 at the minimal corner to 4 back at it. The k-th corner of
+		/// the box lies at k.
+		double boundaryPosition(const Eigen::Vector2d & point, size_t side) const;
+
+		/// \brief Appends the corners of the box that lie between the given positions along its
+		/// boundary, going counter-clockwise.
+		void appendBoxCorners(double from, double to);
+
+		/// Appends the corners of the cell of the vertex with given index.
+		void appendCell(size_t vertex);
+
+	public:
+		/// \brief Creates the algorithm that clips the cells to the box with given corners (only
+		/// their x and y coordinates are used).
+		Voronoi2D(const Eigen::Vector3d & minCorner, const Eigen::Vector3d & maxCorner)
+			: m_minCorner(minCorner), m_maxCorner(maxCorner)
+		{ }
+
+		/// Computes the cells of the sites, in the order of the sites.
+		VoronoiCells invoke(const std::vector<Eigen::Vector3d> & sites);
+
+		/// Returns the times of the phases of the last invocation.
+		const PhaseTimes & phaseTimes() const { return m_phaseTimes; }
+	};
+
+}
@@ -12,6 +12,33 @@
 #define IDS_FNP_DELAUNAY                8
 #define IDS_FNP_VERTICES                9
 #define IDS_FN_DELAUNAY3D               10
+#define IDS_FNP_TETRA_OUTPUT            11
+#define IDS_FNP_TRIANGLE_OUTPUT         12
+#define IDS_FN_CREATE_TRIANGULATION2D   13
+#define IDS_FN_CREATE_TRIANGULATION3D   14
+#define IDS_FN_ADD_POINTS               15
+#define IDS_FN_TO_MESH                  16
+#define IDS_FN_RELEASE_TRIANGULATION    17
+#define IDS_FNP_HANDLE                  18
+#define IDS_FNP_POINTS                  19
+#define IDS_FNP_SINGLE_SIDED            20
+#define IDS_FN_REMOVE_POINTS            21
+#define IDS_FNP_INDICES                 22
+#define IDS_FN_DELAUNAY2D_BATCH         23
+#define IDS_FN_DELAUNAY3D_BATCH         24
+#define IDS_FNP_MESHES                  25
+#define IDS_FNP_CONSTRAINTS             26
+#define IDS_FNP_MIN_ANGLE               27
+#define IDS_FNP_MAX_AREA                28
+#define IDS_FN_VORONOI2D                29
+#define IDS_FNP_BOUNDS                  30
+#define IDS_FNP_VORONOI_OUTPUT          31
+#define IDS_FNP_MERGE_DISTANCE          32
+#define IDS_FN_MERGE_VERTICES           33
+#define IDS_FNP_PLANAR                  34
+#define IDS_FN_GET_LAST_STATS           35
+#define IDS_PROGRESS_2D                 36
+#define IDS_PROGRESS_3D                 37
 #define IDD_PANEL                       101
 #define IDC_CLOSEBUTTON                 1000
 #define IDC_DOSTUFF                     1000
@@ -0,0 +1,528 @@
+/// Benchmark of the triangulation engines, built without the 3ds Max SDK (see the Makefile).
+/// \author Jan Bryda
+#include "stdafx.h"
+#include "Delaunay2D.h"
+#include "Delaunay3D.h"
+#include "DivideAndConquer2D.h"
+#include "ParallelBowyerWatson3D.h"
+#include "ThreadPool.h"
+#include "PointGenerators.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>	// getrusage
+
+using Eigen::Vector3d;
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+#ifndef BENCHMARK_REVISION
+#define BENCHMARK_REVISION "unknown"
+#endif
+
+
+// ALLOCATION COUNTING
+// ===================
+
+// The global operator new is replaced, so that the allocations made by a run can be counted.
+
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocatedBytes(0);
+
+void* operator new(size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	void* memory = std::malloc((size > 0) ? size : 1);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+	std::free(memory);
+}
+
+
+namespace benchmark {
+
+	// =============================================================================
+	// MEASUREMENT
+	// =============================================================================
+
+	/// \brief Resets the peak resident set size of the process to the current one, so that the
+	/// next run is measured alone. (Supported by Linux since version 4.0.)
+	void resetPeakRss() {
+		std::ofstream clearRefs("/proc/self/clear_refs");
+		clearRefs << "5";
+	}
+
+	/// Returns the peak resident set size of the process in kilobytes.
+	uint64_t peakRssKb() {
+		std::ifstream status("/proc/self/status");
+		string line;
+		while (std::getline(status, line)) {
+			if (line.compare(0, 6, "VmHWM:") == 0)
+				return std::strtoull(line.c_str() + 6, nullptr, 10);
+		}
+
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return uint64_t(usage.ru_maxrss);
+	}
+
+	/// The engines that can be benchmarked.
+	enum class Engine {
+		BOWYER_WATSON_2D,
+		BOWYER_WATSON_3D,
+		DIVIDE_AND_CONQUER_2D,
+		PARALLEL_BOWYER_WATSON_3D
+	};
+
+	const Engine ALL_ENGINES[4] = {
+		Engine::BOWYER_WATSON_2D,
+		Engine::BOWYER_WATSON_3D,
+		Engine::DIVIDE_AND_CONQUER_2D,
+		Engine::PARALLEL_BOWYER_WATSON_3D
+	};
+
+	const char* engineName(Engine engine) {
+		switch (engine) {
+		case Engine::BOWYER_WATSON_2D:
+			return "bw2d";
+		case Engine::BOWYER_WATSON_3D:
+			return "bw3d";
+		case Engine::DIVIDE_AND_CONQUER_2D:
+			return "dc2d";
+		case Engine::PARALLEL_BOWYER_WATSON_3D:
+			return "pbw3d";
+		}
+
+		return "";
+	}
+
+	/// Tells if the engine runs on the thread pool.
+	bool isParallel(Engine engine) {
+		return (engine == Engine::DIVIDE_AND_CONQUER_2D) || (engine == Engine::PARALLEL_BOWYER_WATSON_3D);
+	}
+
+	size_t engineDimensions(Engine engine) {
+		bool is3D = (engine == Engine::BOWYER_WATSON_3D) || (engine == Engine::PARALLEL_BOWYER_WATSON_3D);
+		return is3D ? 3 : 2;
+	}
+
+	/// Measured values of one run of an engine.
+	struct Run {
+		/// Wall time of the whole invocation, in seconds.
+		double m_total;
+		/// \brief Times of the phases and the counters of the insertions. The divide and conquer 
+		/// algorithm has no insertions, so its counters stay zero.
+		delaunay::RunStatistics m_statistics;
+		/// Number of the faces of the returned mesh.
+		size_t m_faceCount;
+		/// Number and total size of the allocations made by the run.
+		uint64_t m_allocationCount;
+		uint64_t m_allocatedBytes;
+		/// Peak resident set size during the run (the input points included), in kilobytes.
+		uint64_t m_peakRssKb;
+	};
+
+	/// Runs the engine on the points once.
+	Run runEngine(Engine engine, const vector<Vector3d> & points, delaunay::ThreadPool & pool) {
+		Run run;
+		run.m_statistics = delaunay::RunStatistics();
+
+		resetPeakRss();
+		uint64_t allocationsBefore = allocationCount.load();
+		uint64_t bytesBefore = allocatedBytes.load();
+		delaunay::PhaseClock clock;
+
+		unique_ptr<Mesh> mesh;
+		switch (engine) {
+		case Engine::BOWYER_WATSON_2D: {
+			delaunay::BowyerWatson2D algorithm;
+			mesh.reset(algorithm.invoke(points));
+			run.m_statistics = algorithm.statistics();
+			break;
+		}
+		case Engine::BOWYER_WATSON_3D: {
+			delaunay::BowyerWatson3D algorithm;
+			mesh.reset(algorithm.invoke(points));
+			run.m_statistics = algorithm.statistics();
+			break;
+		}
+		case Engine::DIVIDE_AND_CONQUER_2D: {
+			delaunay::DivideAndConquer2D algorithm(&pool);
+			mesh.reset(algorithm.invoke(points));
+			run.m_statistics = algorithm.statistics();
+			break;
+		}
+		case Engine::PARALLEL_BOWYER_WATSON_3D: {
+			delaunay::ParallelBowyerWatson3D algorithm(&pool);
+			mesh.reset(algorithm.invoke(points));
+			run.m_statistics = algorithm.statistics();
+			break;
+		}
+		}
+
+		run.m_total = clock.lap();
+		run.m_allocationCount = allocationCount.load() - allocationsBefore;
+		run.m_allocatedBytes = allocatedBytes.load() - bytesBefore;
+		run.m_peakRssKb = peakRssKb();
+		run.m_faceCount = size_t(mesh->numFaces);
+
+		return run;
+	}
+
+
+	// =============================================================================
+	// REPORTING
+	// =============================================================================
+
+	/// The result of one benchmark case, i.e. the fastest of its runs.
+	struct Result {
+		Engine m_engine;
+		Distribution m_distribution;
+		size_t m_pointCount;
+		/// Number of the threads that ran the engine (one for the serial engines).
+		size_t m_threadCount;
+		/// \brief Time of the single-threaded run of the same case divided by the time of this 
+		/// one, or a negative value when there was no such run.
+		double m_speedup;
+		Run m_run;
+	};
+
+	/// Settings given on the command line.
+	struct Settings {
+		vector<Engine> m_engines;
+		vector<Distribution> m_distributions;
+		vector<size_t> m_sizes;
+		/// Thread counts of the pool for the parallel engines, zero means all the processors.
+		vector<size_t> m_threadCounts;
+		size_t m_repeatCount;
+		uint64_t m_seed;
+		bool m_json;
+		string m_outputPath;
+	};
+
+	/// Formats the phase time, the missing ones are left empty in CSV and null in JSON.
+	string formatTime(double seconds, bool json) {
+		if (seconds < 0.0)
+			return json ? "null" : "";
+
+		std::ostringstream stream;
+		stream.precision(6);
+		stream << std::fixed << seconds;
+		return stream.str();
+	}
+
+	/// Formats the speedup, the missing ones are left empty in CSV and null in JSON.
+	string formatSpeedup(double speedup, bool json) {
+		if (speedup < 0.0)
+			return json ? "null" : "";
+
+		std::ostringstream stream;
+		stream.precision(3);
+		stream << std::fixed << speedup;
+		return stream.str();
+	}
+
+	void writeCsv(std::ostream & out, const Settings & settings, const vector<Result> & results) {
+		out << "revision,engine,distribution,points,threads,speedup,seed,repeats,bounding_s,sort_s,insertion_s,conversion_s,total_s,"
+			<< "points_per_s,faces,conflict_tests,average_cavity,max_cavity,peak_elements,peak_rss_kb,allocations,allocated_bytes\n";
+
+		for (const Result & result : results) {
+			const Run & run = result.m_run;
+			const delaunay::PhaseTimes & phases = run.m_statistics.m_phases;
+			const delaunay::InsertionCounters & counters = run.m_statistics.m_counters;
+			out << BENCHMARK_REVISION << ','
+				<< engineName(result.m_engine) << ','
+				<< distributionName(result.m_distribution) << ','
+				<< result.m_pointCount << ','
+				<< result.m_threadCount << ','
+				<< formatSpeedup(result.m_speedup, false) << ','
+				<< settings.m_seed << ','
+				<< settings.m_repeatCount << ','
+				<< formatTime(phases.m_bounding, false) << ','
+				<< formatTime(phases.m_sort, false) << ','
+				<< formatTime(phases.m_insertion, false) << ','
+				<< formatTime(phases.m_conversion, false) << ','
+				<< formatTime(run.m_total, false) << ','
+				<< uint64_t(double(result.m_pointCount) / run.m_total) << ','
+				<< run.m_faceCount << ','
+				<< counters.m_conflictTests << ','
+				<< run.m_statistics.averageCavitySize() << ','
+				<< counters.m_maxCavitySize << ','
+				<< run.m_statistics.m_peakElements << ','
+				<< run.m_peakRssKb << ','
+				<< run.m_allocationCount << ','
+				<< run.m_allocatedBytes << '\n';
+		}
+	}
+
+	void writeJson(std::ostream & out, const Settings & settings, const vector<Result> & results) {
+		out << "{\n"
+			<< "  \"revision\": \"" << BENCHMARK_REVISION << "\",\n"
+			<< "  \"seed\": " << settings.m_seed << ",\n"
+			<< "  \"repeats\": " << settings.m_repeatCount << ",\n"
+			<< "  \"results\": [";
+
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result & result = results[i];
+			const Run & run = result.m_run;
+			const delaunay::PhaseTimes & phases = run.m_statistics.m_phases;
+			const delaunay::InsertionCounters & counters = run.m_statistics.m_counters;
+			out << ((i == 0) ? "\n" : ",\n")
+				<< "    {\"engine\": \"" << engineName(result.m_engine) << "\""
+				<< ", \"distribution\": \"" << distributionName(result.m_distribution) << "\""
+				<< ", \"points\": " << result.m_pointCount
+				<< ", \"threads\": " << result.m_threadCount
+				<< ", \"speedup\": " << formatSpeedup(result.m_speedup, true)
+				<< ", \"bounding_s\": " << formatTime(phases.m_bounding, true)
+				<< ", \"sort_s\": " << formatTime(phases.m_sort, true)
+				<< ", \"insertion_s\": " << formatTime(phases.m_insertion, true)
+				<< ", \"conversion_s\": " << formatTime(phases.m_conversion, true)
+				<< ", \"total_s\": " << formatTime(run.m_total, true)
+				<< ", \"points_per_s\": " << uint64_t(double(result.m_pointCount) / run.m_total)
+				<< ", \"faces\": " << run.m_faceCount
+				<< ", \"conflict_tests\": " << counters.m_conflictTests
+				<< ", \"average_cavity\": " << run.m_statistics.averageCavitySize()
+				<< ", \"max_cavity\": " << counters.m_maxCavitySize
+				<< ", \"peak_elements\": " << run.m_statistics.m_peakElements
+				<< ", \"peak_rss_kb\": " << run.m_peakRssKb
+				<< ", \"allocations\": " << run.m_allocationCount
+				<< ", \"allocated_bytes\": " << run.m_allocatedBytes << "}";
+		}
+
+		out << "\n  ]\n}\n";
+	}
+
+
+	// =============================================================================
+	// COMMAND LINE
+	// =============================================================================
+
+	const char* USAGE =
+		"Usage: benchmark [options]\n"
+		"  --engines LIST        bw2d, bw3d, dc2d, pbw3d (default: bw2d,bw3d)\n"
+		"  --distributions LIST  uniform, gaussian, grid, sphere, terrain (default: all)\n"
+		"  --sizes LIST          numbers of points, e.g. 1e3,1e4 (default: 1e3,1e4,1e5,1e6,1e7)\n"
+		"  --max-size N          skips the larger sizes\n"
+		"  --threads LIST        threads of dc2d and pbw3d, e.g. 1,2,4 (default: 0, all the processors)\n"
+		"  --repeat N            runs of each case, the fastest is reported (default: 3)\n"
+		"  --seed N              seed of the generated points (default: 1)\n"
+		"  --json                writes JSON instead of CSV\n"
+		"  --output FILE         writes the report into the file instead of stdout\n";
+
+	vector<string> splitList(const string & list) {
+		vector<string> items;
+		std::istringstream stream(list);
+		string item;
+		while (std::getline(stream, item, ','))
+			items.push_back(item);
+		return items;
+	}
+
+	/// Parses the count given also in the scientific notation, such as 1e6.
+	bool parseCount(const string & text, size_t & count) {
+		char* end = nullptr;
+		double value = std::strtod(text.c_str(), &end);
+		if (end == text.c_str() || *end != '\0' || value < 1.0)
+			return false;
+
+		count = size_t(value + 0.5);
+		return true;
+	}
+
+	bool parseEngine(const string & name, Engine & engine) {
+		for (Engine candidate : ALL_ENGINES) {
+			if (name == engineName(candidate)) {
+				engine = candidate;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// Parses the command line into the settings. Returns false on invalid arguments.
+	bool parseArguments(int argc, char** argv, Settings & settings) {
+		settings.m_engines = { Engine::BOWYER_WATSON_2D, Engine::BOWYER_WATSON_3D };
+		settings.m_distributions.assign(std::begin(ALL_DISTRIBUTIONS), std::end(ALL_DISTRIBUTIONS));
+		settings.m_sizes = { 1000, 10000, 100000, 1000000, 10000000 };
+		settings.m_threadCounts = { 0 };
+		settings.m_repeatCount = 3;
+		settings.m_seed = 1;
+		settings.m_json = false;
+
+		size_t maxSize = std::numeric_limits<size_t>::max();
+		for (int i = 1; i < argc; ++i) {
+			string option = argv[i];
+			if (option == "--json") {
+				settings.m_json = true;
+				continue;
+			}
+
+			if (i + 1 == argc)
+				return false;
+			string value = argv[++i];
+
+			if (option == "--engines") {
+				settings.m_engines.clear();
+				for (const string & name : splitList(value)) {
+					Engine engine;
+					if (parseEngine(name, engine) == false)
+						return false;
+					settings.m_engines.push_back(engine);
+				}
+			}
+			else if (option == "--distributions") {
+				settings.m_distributions.clear();
+				for (const string & name : splitList(value)) {
+					Distribution distribution;
+					if (parseDistribution(name, distribution) == false)
+						return false;
+					settings.m_distributions.push_back(distribution);
+				}
+			}
+			else if (option == "--sizes") {
+				settings.m_sizes.clear();
+				for (const string & text : splitList(value)) {
+					size_t size;
+					if (parseCount(text, size) == false)
+						return false;
+					settings.m_sizes.push_back(size);
+				}
+			}
+			else if (option == "--max-size") {
+				if (parseCount(value, maxSize) == false)
+					return false;
+			}
+			else if (option == "--threads") {
+				settings.m_threadCounts.clear();
+				for (const string & text : splitList(value)) {
+					size_t count;
+					if (parseCount(text, count) == false)
+						return false;
+					settings.m_threadCounts.push_back(count);
+				}
+			}
+			else if (option == "--repeat") {
+				if (parseCount(value, settings.m_repeatCount) == false)
+					return false;
+			}
+			else if (option == "--seed") {
+				settings.m_seed = std::strtoull(value.c_str(), nullptr, 10);
+			}
+			else if (option == "--output") {
+				settings.m_outputPath = value;
+			}
+			else {
+				return false;
+			}
+		}
+
+		settings.m_sizes.erase(
+			std::remove_if(settings.m_sizes.begin(), settings.m_sizes.end(), [maxSize](size_t size) { return size > maxSize; }),
+			settings.m_sizes.end());
+
+		return true;
+	}
+
+}
+
+
+int main(int argc, char** argv) {
+	using namespace benchmark;
+
+	Settings settings;
+	if (parseArguments(argc, argv, settings) == false) {
+		std::cerr << USAGE;
+		return 1;
+	}
+
+	vector<unique_ptr<delaunay::ThreadPool>> pools;
+	for (size_t threadCount : settings.m_threadCounts)
+		pools.push_back(std::make_unique<delaunay::ThreadPool>(threadCount));
+
+	vector<Result> results;
+	for (size_t size : settings.m_sizes) {
+		for (Distribution distribution : settings.m_distributions) {
+			for (Engine engine : settings.m_engines) {
+				// The points are generated again for each engine, so that the peak RSS of the 
+				// runs holds only the points of the given dimension.
+				vector<Vector3d> points = generatePoints(distribution, size, engineDimensions(engine), settings.m_seed);
+
+				// The serial engines run once, the parallel ones with each of the pools.
+				size_t caseBegin = results.size();
+				size_t poolCount = isParallel(engine) ? pools.size() : 1;
+				for (size_t iPool = 0; iPool < poolCount; ++iPool) {
+					delaunay::ThreadPool & pool = *pools[iPool];
+
+					Result result;
+					result.m_engine = engine;
+					result.m_distribution = distribution;
+					result.m_pointCount = size;
+					result.m_threadCount = isParallel(engine) ? pool.threadCount() : 1;
+					result.m_speedup = -1.0;
+					for (size_t i = 0; i < settings.m_repeatCount; ++i) {
+						Run run = runEngine(engine, points, pool);
+						if (i == 0 || run.m_total < result.m_run.m_total)
+							result.m_run = run;
+					}
+
+					std::cerr << engineName(engine) << ' ' << distributionName(distribution) << ' ' << size 
+						<< " (" << result.m_threadCount << " threads): " << result.m_run.m_total << " s\n";
+					results.push_back(result);
+				}
+
+				// The scaling is reported against the single-threaded run.
+				for (size_t iSerial = caseBegin; iSerial < results.size(); ++iSerial) {
+					if (results[iSerial].m_threadCount != 1)
+						continue;
+
+					for (size_t i = caseBegin; i < results.size(); ++i)
+						results[i].m_speedup = results[iSerial].m_run.m_total / results[i].m_run.m_total;
+					break;
+				}
+			}
+		}
+	}
+
+	std::ofstream file;
+	if (settings.m_outputPath.empty() == false) {
+		file.open(settings.m_outputPath);
+		if (!file) {
+			std::cerr << "Can not write " << settings.m_outputPath << "\n";
+			return 1;
+		}
+	}
+
+	std::ostream & out = file.is_open() ? file : std::cout;
+	if (settings.m_json)
+		writeJson(out, settings, results);
+	else
+		writeCsv(out, settings, results);
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+/// Regression checks of the engines, built without the 3ds Max SDK (see the Makefile).
+/// \author Jan Bryda
+#include "stdafx.h"
+#include "DynamicTriangulation.h"
+#include "Delaunay2D.h"
+
+#include <iostream>
+#include <random>
+
+using Eigen::Vector3d;
+using std::vector;
+
+namespace standalone {
+
+	// =============================================================================
+	// HELPERS
+	// =============================================================================
+
+	/// Number of the failed checks.
+	size_t failureCount = 0;
+
+	/// Reports the check and counts it when it failed.
+	void check(bool isPassed, const char* name) {
+		std::cerr << (isPassed ? "passed: " : "FAILED: ") << name << "\n";
+		if (!isPassed)
+			++failureCount;
+	}
+
+	/// Returns the number of the faces of the mesh that use the vertex with given index.
+	size_t vertexUses(const delaunay::DynamicTriangulation & triangulation, size_t index) {
+		std::unique_ptr<Mesh> mesh(triangulation.toMesh());
+
+		size_t uses = 0;
+		for (int iFace = 0; iFace < mesh->getNumFaces(); ++iFace) {
+			const DWORD* v = mesh->faces[iFace].v;
+			if (v[0] == index || v[1] == index || v[2] == index)
+				++uses;
+		}
+
+		return uses;
+	}
+
+
+	// =============================================================================
+	// CHECKS
+	// =============================================================================
+
+	/// \brief Removes the duplicates of a vertex one by one. Only the connected one of them may
+	/// change the mesh, and the last remaining one has to be connected.
+	template<typename Triangulation>
+	void checkDuplicateRemoval(const char* name, double depth) {
+		vector<Vector3d> vertices = {
+			Vector3d(0.0, 0.0, 0.0),
+			Vector3d(10.0, 0.0, depth),
+			Vector3d(10.0, 10.0, 2.0 * depth),
+			Vector3d(0.0, 10.0, 3.0 * depth),
+			Vector3d(5.0, 4.0, 5.0 * depth)
+		};
+
+		// The later duplicate replaces the earlier one in the triangulation.
+		Triangulation triangulation;
+		triangulation.addVertices(vertices);
+		triangulation.addVertices({ vertices[4] });
+		size_t uses = vertexUses(triangulation, 5);
+
+		triangulation.removeVertices({ 4 });
+		check(uses > 0 && vertexUses(triangulation, 5) == uses, name);
+
+		// Three vertices at the same position, the connected one is removed first.
+		Triangulation triple;
+		triple.addVertices(vertices);
+		triple.addVertices({ vertices[4], vertices[4] });
+		size_t connected = (vertexUses(triple, 5) > 0) ? 5 : 6;
+		triple.removeVertices({ connected });
+		triple.removeVertices({ 11 - connected });
+		check(vertexUses(triple, 4) > 0, name);
+	}
+
+	/// \brief Refines a zigzag polyline of segments that meet at 12.8 degrees among random vertices. 
+	/// The refinement must stop by the small angles, and no triangle may become flat in the float
+	/// coordinates of the mesh.
+	void checkSmallAngleRefinement() {
+		vector<Vector3d> vertices = { Vector3d(0.0, 0.0, 0.0), Vector3d(1.0, 0.0, 0.0), Vector3d(1.0, 1.0, 0.0), Vector3d(0.0, 1.0, 0.0) };
+		vector<size_t> segments = { 0, 1, 1, 2, 2, 3, 3, 0 };
+
+		double step = 0.2 * std::tan(6.4 * std::acos(-1.0) / 180.0);
+		for (size_t i = 0; i < 10; ++i) {
+			vertices.push_back(Vector3d(0.3 + double(i) * step, (i % 2 == 0) ? 0.4 : 0.6, 0.0));
+			if (i > 0) {
+				segments.push_back(vertices.size() - 2);
+				segments.push_back(vertices.size() - 1);
+			}
+		}
+
+		std::mt19937_64 generator(7);
+		std::uniform_real_distribution<double> distribution(0.0, 1.0);
+		for (size_t i = 0; i < 200; ++i)
+			vertices.push_back(Vector3d(distribution(generator), distribution(generator), 0.0));
+
+		delaunay::BowyerWatson2D triangulation(delaunay::InsertionOrder::BRIO, delaunay::FaceSides::SINGLE_SIDED);
+		triangulation.setConstraints(segments);
+		triangulation.setRefinement(30.0, 0.0);
+		std::unique_ptr<Mesh> mesh(triangulation.invoke(vertices));
+
+		size_t flatCount = 0;
+		for (int iFace = 0; iFace < mesh->getNumFaces(); ++iFace) {
+			const Point3 & a = mesh->verts[mesh->faces[iFace].v[0]];
+			const Point3 & b = mesh->verts[mesh->faces[iFace].v[1]];
+			const Point3 & c = mesh->verts[mesh->faces[iFace].v[2]];
+			if (double(b.x - a.x) * double(c.y - a.y) - double(b.y - a.y) * double(c.x - a.x) <= 0.0)
+				++flatCount;
+		}
+
+		check(mesh->getNumVerts() < 20 * int(vertices.size()) && flatCount == 0, "refinement of small input angles");
+	}
+
+}
+
+int main() {
+	using namespace standalone;
+
+	checkDuplicateRemoval<delaunay::DynamicTriangulation2D>("removal of 2D duplicates", 0.0);
+	checkDuplicateRemoval<delaunay::DynamicTriangulation3D>("removal of 3D duplicates", 1.0);
+	checkSmallAngleRefinement();
+
+	return (failureCount == 0) ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <fcntl.h>		// open
+#include <sys/mman.h>	// mmap
+#include <sys/stat.h>	// fstat
+#include <unistd.h>		// close
+
+namespace standalone {
+
+	MappedFile::MappedFile(const std::string & path)
+	{
+		int descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			throw std::runtime_error("Can not open " + path);
+
+		struct stat status;
+		if (fstat(descriptor, &status) != 0) {
+			close(descriptor);
+			throw std::runtime_error("Can not read " + path);
+		}
+
+		m_size = size_t(status.st_size);
+		if (m_size > 0) {
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (data == MAP_FAILED) {
+				close(descriptor);
+				throw std::runtime_error("Can not map " + path);
+			}
+
+			// The file is read from the start to the end.
+			madvise(data, m_size, MADV_SEQUENTIAL);
+			m_data = static_cast<const char*>(data);
+		}
+
+		// The mapping stays valid after the descriptor is closed.
+		close(descriptor);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_data != nullptr)
+			munmap(const_cast<char*>(m_data), m_size);
+	}
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace standalone {
+
+	/// \brief Read-only memory mapping of a whole file. The contents are paged in by the system 
+	/// on demand, so no copy of the file is made.
+	class MappedFile {
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+
+	public:
+		/// Maps the file. Throws std::runtime_error when it can not be opened.
+		explicit MappedFile(const std::string & path);
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+	};
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+/// Minimal replacements of the 3ds Max SDK types that the triangulation engines use, so that
+/// they can be built without the SDK (see DELAUNAY_STANDALONE in stdafx.h).
+/// \author Jan Bryda
+
+typedef unsigned long DWORD;
+typedef int BOOL;
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+/// Point with float coordinates, as the 3ds Max Point3.
+class Point3 {
+public:
+	float x, y, z;
+
+	Point3() {}
+	Point3(float x, float y, float z) : x(x), y(y), z(z) {}
+	Point3(double x, double y, double z) : x(float(x)), y(float(y)), z(float(z)) {}
+};
+
+/// Triangular face given by the indices of its vertices, as the 3ds Max Face.
+class Face {
+public:
+	DWORD v[3];
+};
+
+/// \brief Triangle mesh with the members of the 3ds Max Mesh that the engines use. The 
+/// vertices and the faces are held in plain arrays, as in the original.
+class Mesh {
+	std::vector<Point3> m_verts;
+	std::vector<Face> m_faces;
+
+public:
+	int numVerts = 0;
+	int numFaces = 0;
+	Point3* verts = nullptr;
+	Face* faces = nullptr;
+
+	BOOL setNumVerts(int count, BOOL keep = FALSE, BOOL /*synchSel*/ = TRUE) {
+		if (keep == FALSE)
+			m_verts.clear();
+		m_verts.resize(size_t(count));
+		verts = m_verts.data();
+		numVerts = count;
+		return TRUE;
+	}
+
+	BOOL setNumFaces(int count, BOOL keep = FALSE, BOOL /*synchSel*/ = TRUE) {
+		if (keep == FALSE)
+			m_faces.clear();
+		m_faces.resize(size_t(count));
+		faces = m_faces.data();
+		numFaces = count;
+		return TRUE;
+	}
+
+	int getNumVerts() const { return numVerts; }
+	int getNumFaces() const { return numFaces; }
+
+	void setVert(int i, const Point3 & point) { verts[i] = point; }
+	Point3 & getVert(int i) { return verts[i]; }
+
+	void InvalidateGeomCache() {}
+	void InvalidateTopologyCache() {}
+};
@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "PointGenerators.h"
+
+using Eigen::Vector3d;
+using std::vector;
+
+namespace benchmark {
+
+	// =============================================================================
+	// RANDOM NUMBERS
+	// =============================================================================
+
+	namespace {
+
+		const double PI = 3.14159265358979323846;
+
+		/// Number of the clusters of the GAUSSIAN distribution.
+		const size_t CLUSTER_COUNT = 16;
+		/// Standard deviation of the points from the center of their cluster.
+		const double CLUSTER_DEVIATION = 0.03;
+		/// Number of the octaves that sum up to the heightfield of the TERRAIN distribution.
+		const size_t TERRAIN_OCTAVES = 6;
+
+		/// \brief Source of random numbers whose sequence is the same on every platform. (The
+		/// sequence of std::mt19937_64 is given by the standard, unlike the distributions.)
+		class Random {
+			std::mt19937_64 m_engine;
+
+		public:
+			explicit Random(uint64_t seed) : m_engine(seed) {}
+
+			/// Returns a number from the interval [0, 1).
+			double uniform() {
+				return double(m_engine() >> 11) * (1.0 / 9007199254740992.0);
+			}
+
+			/// Returns a number of the standard normal distribution (by the Box-Muller transform).
+			double normal() {
+				double u0 = 1.0 - uniform();
+				double u1 = uniform();
+				return std::sqrt(-2.0 * std::log(u0)) * std::cos(2.0 * PI * u1);
+			}
+		};
+
+		vector<Vector3d> generateUniform(size_t count, size_t dimensions, Random & random) {
+			vector<Vector3d> points;
+			points.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				double x = random.uniform();
+				double y = random.uniform();
+				double z = (dimensions == 3) ? random.uniform() : 0.0;
+				points.push_back(Vector3d(x, y, z));
+			}
+
+			return points;
+		}
+
+		vector<Vector3d> generateGaussian(size_t count, size_t dimensions, Random & random) {
+			vector<Vector3d> centers;
+			for (size_t i = 0; i < CLUSTER_COUNT; ++i) {
+				double x = 0.1 + 0.8 * random.uniform();
+				double y = 0.1 + 0.8 * random.uniform();
+				double z = (dimensions == 3) ? 0.1 + 0.8 * random.uniform() : 0.0;
+				centers.push_back(Vector3d(x, y, z));
+			}
+
+			vector<Vector3d> points;
+			points.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				const Vector3d & center = centers[i % CLUSTER_COUNT];
+				double x = center.x() + CLUSTER_DEVIATION * random.normal();
+				double y = center.y() + CLUSTER_DEVIATION * random.normal();
+				double z = (dimensions == 3) ? center.z() + CLUSTER_DEVIATION * random.normal() : 0.0;
+				points.push_back(Vector3d(x, y, z));
+			}
+
+			return points;
+		}
+
+		vector<Vector3d> generateGrid(size_t count, size_t dimensions) {
+			// The grid is the smallest one that has enough points, it is filled row by row.
+			size_t side = 1;
+			while (((dimensions == 3) ? side * side * side : side * side) < count)
+				++side;
+
+			double spacing = 1.0 / double(side);
+			vector<Vector3d> points;
+			points.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				double x = double(i % side) * spacing;
+				double y = double((i / side) % side) * spacing;
+				double z = (dimensions == 3) ? double(i / (side * side)) * spacing : 0.0;
+				points.push_back(Vector3d(x, y, z));
+			}
+
+			return points;
+		}
+
+		vector<Vector3d> generateSphere(size_t count, size_t dimensions, Random & random) {
+			Vector3d center(0.5, 0.5, (dimensions == 3) ? 0.5 : 0.0);
+
+			vector<Vector3d> points;
+			points.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				Vector3d direction;
+				if (dimensions == 3) {
+					// A normally distributed vector has uniformly distributed direction.
+					do {
+						direction = Vector3d(random.normal(), random.normal(), random.normal());
+					} while (direction.squaredNorm() < 1e-12);
+					direction.normalize();
+				}
+				else {
+					double angle = 2.0 * PI * random.uniform();
+					direction = Vector3d(std::cos(angle), std::sin(angle), 0.0);
+				}
+
+				points.push_back(center + 0.5 * direction);
+			}
+
+			return points;
+		}
+
+		vector<Vector3d> generateTerrain(size_t count, Random & random) {
+			// The heightfield is a sum of waves whose frequency doubles and amplitude halves with 
+			// each octave.
+			double phases[TERRAIN_OCTAVES][2];
+			for (size_t octave = 0; octave < TERRAIN_OCTAVES; ++octave) {
+				phases[octave][0] = 2.0 * PI * random.uniform();
+				phases[octave][1] = 2.0 * PI * random.uniform();
+			}
+
+			vector<Vector3d> points;
+			points.reserve(count);
+			for (size_t i = 0; i < count; ++i) {
+				double x = random.uniform();
+				double y = random.uniform();
+
+				double height = 0.0;
+				double frequency = 2.0 * PI;
+				double amplitude = 0.1;
+				for (size_t octave = 0; octave < TERRAIN_OCTAVES; ++octave) {
+					height += amplitude * std::sin(frequency * x + phases[octave][0]) * std::cos(frequency * y + phases[octave][1]);
+					frequency *= 2.0;
+					amplitude *= 0.5;
+				}
+
+				points.push_back(Vector3d(x, y, 0.5 + height));
+			}
+
+			return points;
+		}
+
+	}
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	const Distribution ALL_DISTRIBUTIONS[5] = {
+		Distribution::UNIFORM,
+		Distribution::GAUSSIAN,
+		Distribution::GRID,
+		Distribution::SPHERE,
+		Distribution::TERRAIN
+	};
+
+	const char* distributionName(Distribution distribution)
+	{
+		switch (distribution) {
+		case Distribution::UNIFORM:
+			return "uniform";
+		case Distribution::GAUSSIAN:
+			return "gaussian";
+		case Distribution::GRID:
+			return "grid";
+		case Distribution::SPHERE:
+			return "sphere";
+		case Distribution::TERRAIN:
+			return "terrain";
+		}
+
+		return "";
+	}
+
+	bool parseDistribution(const std::string & name, Distribution & distribution)
+	{
+		for (Distribution candidate : ALL_DISTRIBUTIONS) {
+			if (name == distributionName(candidate)) {
+				distribution = candidate;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	vector<Vector3d> generatePoints(Distribution distribution, size_t count, size_t dimensions, uint64_t seed)
+	{
+		Random random(seed);
+
+		switch (distribution) {
+		case Distribution::GAUSSIAN:
+			return generateGaussian(count, dimensions, random);
+		case Distribution::GRID:
+			return generateGrid(count, dimensions);
+		case Distribution::SPHERE:
+			return generateSphere(count, dimensions, random);
+		case Distribution::TERRAIN:
+			return generateTerrain(count, random);
+		default:
+			return generateUniform(count, dimensions, random);
+		}
+	}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace benchmark {
+
+	/// The distributions of the generated input points. All of them fill the unit square (cube).
+	enum class Distribution {
+		/// Points distributed uniformly in the unit square (cube).
+		UNIFORM,
+		/// Points in Gaussian clusters with uniformly placed centers.
+		GAUSSIAN,
+		/// \brief Points of a regular grid, so that many of them are cocircular (cospherical),
+		/// which is the degenerate case for the predicates.
+		GRID,
+		/// Points on the circle (sphere) inscribed into the unit square (cube).
+		SPHERE,
+		/// \brief Points distributed uniformly in the xy-plane, lifted onto a smooth heightfield,
+		/// as the vertices of a scanned terrain.
+		TERRAIN
+	};
+
+	/// All of the distributions, in the order of their declaration.
+	extern const Distribution ALL_DISTRIBUTIONS[5];
+
+	/// Returns the name of the distribution, as used on the command line and in the reports.
+	const char* distributionName(Distribution distribution);
+
+	/// Finds the distribution with given name. Returns false when there is none.
+	bool parseDistribution(const std::string & name, Distribution & distribution);
+
+	/// \brief Generates the points of given distribution. In case of 2 dimensions the points lie
+	/// in the xy-plane (apart from the terrain, which keeps its heights). The same seed gives the
+	/// same points on every platform, as the random numbers are not taken from the standard 
+	/// library distributions, whose output is implementation-defined.
+	std::vector<Eigen::Vector3d> generatePoints(Distribution distribution, size_t count, size_t dimensions, uint64_t seed);
+
+}
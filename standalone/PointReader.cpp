@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "PointReader.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using Eigen::Vector3d;
+using std::string;
+using std::vector;
+
+namespace standalone {
+
+	namespace {
+
+		/// Property of the PLY vertex element.
+		struct PlyProperty {
+			string m_name;
+			string m_type;
+			size_t m_offset;
+		};
+
+		/// Returns the size of the PLY scalar type, or 0 for an unknown type.
+		size_t plyTypeSize(const string & type) {
+			if (type == "char" || type == "uchar" || type == "int8" || type == "uint8")
+				return 1;
+			if (type == "short" || type == "ushort" || type == "int16" || type == "uint16")
+				return 2;
+			if (type == "int" || type == "uint" || type == "int32" || type == "uint32" || type == "float" || type == "float32")
+				return 4;
+			if (type == "double" || type == "float64")
+				return 8;
+			return 0;
+		}
+
+		bool isFloatType(const string & type) {
+			return type == "float" || type == "float32";
+		}
+
+		bool isDoubleType(const string & type) {
+			return type == "double" || type == "float64";
+		}
+
+		/// Reads the coordinate of given type. (The files are little-endian, as is the host.)
+		double readScalar(const char* data, ScalarType type) {
+			if (type == ScalarType::FLOAT) {
+				float value;
+				std::memcpy(&value, data, sizeof(value));
+				return double(value);
+			}
+			else {
+				double value;
+				std::memcpy(&value, data, sizeof(value));
+				return value;
+			}
+		}
+
+		bool endsWith(const string & text, const string & suffix) {
+			return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+
+	}
+
+	PointFile::PointFile(const string & path)
+		: m_file(std::make_unique<MappedFile>(path))
+	{
+		if (endsWith(path, ".xyz"))
+			readXyz(path);
+		else if (endsWith(path, ".ply"))
+			readPly(path);
+		else
+			throw std::runtime_error("Unknown format of " + path + " (expected .xyz or .ply)");
+	}
+
+	void PointFile::readXyz(const string & path)
+	{
+		if (m_file->size() % sizeof(Vector3d) != 0)
+			throw std::runtime_error(path + " is not a sequence of double triples");
+
+		m_records = m_file->data();
+		m_recordSize = sizeof(Vector3d);
+		m_pointCount = m_file->size() / sizeof(Vector3d);
+		for (size_t c = 0; c < 3; ++c) {
+			m_offsets[c] = c * sizeof(double);
+			m_types[c] = ScalarType::DOUBLE;
+		}
+
+		m_packedVertices = m_file->data();
+		m_packedType = ScalarType::DOUBLE;
+	}
+
+	void PointFile::readPly(const string & path)
+	{
+		// HEADER
+		// ======
+
+		const char* data = m_file->data();
+		size_t size = m_file->size();
+
+		const char* headerEnd = nullptr;
+		const char* marker = "end_header\n";
+		for (size_t i = 0; i + std::strlen(marker) <= size; ++i) {
+			if (std::memcmp(data + i, marker, std::strlen(marker)) == 0) {
+				headerEnd = data + i + std::strlen(marker);
+				break;
+			}
+		}
+
+		if (size < 4 || std::memcmp(data, "ply\n", 4) != 0 || headerEnd == nullptr)
+			throw std::runtime_error(path + " is not a PLY file");
+
+		std::istringstream header(string(data, headerEnd));
+		string line;
+		bool isBinary = false;
+		bool isVertexElement = false;
+		bool isFirstElement = true;
+		size_t vertexCount = 0;
+		size_t recordSize = 0;
+		vector<PlyProperty> properties;
+
+		while (std::getline(header, line)) {
+			std::istringstream words(line);
+			string keyword;
+			words >> keyword;
+
+			if (keyword == "format") {
+				string format;
+				words >> format;
+				isBinary = (format == "binary_little_endian");
+			}
+			else if (keyword == "element") {
+				string name;
+				words >> name;
+				isVertexElement = isFirstElement && (name == "vertex");
+				if (isVertexElement)
+					words >> vertexCount;
+				isFirstElement = false;
+			}
+			else if (keyword == "property" && isVertexElement) {
+				PlyProperty property;
+				words >> property.m_type >> property.m_name;
+
+				size_t typeSize = plyTypeSize(property.m_type);
+				if (typeSize == 0)
+					throw std::runtime_error(path + ": unsupported vertex property " + line);
+
+				property.m_offset = recordSize;
+				recordSize += typeSize;
+				properties.push_back(property);
+			}
+		}
+
+		if (isBinary == false)
+			throw std::runtime_error(path + ": only binary_little_endian PLY files are supported");
+
+		const PlyProperty* coordinates[3] = { nullptr, nullptr, nullptr };
+		const char* names[3] = { "x", "y", "z" };
+		for (const PlyProperty & property : properties) {
+			for (size_t i = 0; i < 3; ++i) {
+				if (property.m_name == names[i])
+					coordinates[i] = &property;
+			}
+		}
+
+		for (size_t i = 0; i < 3; ++i) {
+			bool isSupported = (coordinates[i] != nullptr) && (isFloatType(coordinates[i]->m_type) || isDoubleType(coordinates[i]->m_type));
+			if (isSupported == false)
+				throw std::runtime_error(path + ": the first element must be vertex with float or double x, y and z");
+		}
+
+		if (size_t(data + size - headerEnd) < vertexCount * recordSize)
+			throw std::runtime_error(path + " is truncated");
+
+
+		// VERTICES
+		// ========
+
+		m_records = headerEnd;
+		m_recordSize = recordSize;
+		m_pointCount = vertexCount;
+		for (size_t c = 0; c < 3; ++c) {
+			m_offsets[c] = coordinates[c]->m_offset;
+			m_types[c] = isFloatType(coordinates[c]->m_type) ? ScalarType::FLOAT : ScalarType::DOUBLE;
+		}
+
+		// The records that are just x, y, z of one type can be written out as they are.
+		bool isPacked = (properties.size() == 3) 
+			&& (coordinates[0] == &properties[0]) && (coordinates[1] == &properties[1]) && (coordinates[2] == &properties[2])
+			&& (properties[0].m_type == properties[1].m_type) && (properties[1].m_type == properties[2].m_type);
+
+		if (isPacked) {
+			m_packedVertices = headerEnd;
+			m_packedType = isFloatType(properties[0].m_type) ? ScalarType::FLOAT : ScalarType::DOUBLE;
+		}
+	}
+
+	Vector3d PointFile::point(size_t index) const
+	{
+		const char* record = m_records + index * m_recordSize;
+		return Vector3d(
+			readScalar(record + m_offsets[0], m_types[0]),
+			readScalar(record + m_offsets[1], m_types[1]),
+			readScalar(record + m_offsets[2], m_types[2]));
+	}
+
+	const vector<Vector3d> & PointFile::points() const
+	{
+		if (m_points.size() != m_pointCount) {
+			m_points.resize(m_pointCount);
+			for (size_t i = 0; i < m_pointCount; ++i)
+				m_points[i] = point(i);
+		}
+
+		return m_points;
+	}
+
+}
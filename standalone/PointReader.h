@@ -0,0 +1,53 @@
+#pragma once
+#include "MappedFile.h"
+
+namespace standalone {
+
+	/// Scalar types of the coordinates in the point files.
+	enum class ScalarType {
+		FLOAT,
+		DOUBLE
+	};
+
+	/// \brief Points read from a memory-mapped file. Supported are:
+	/// - .xyz - raw little-endian triples of doubles, without any header,
+	/// - .ply - binary little-endian PLY, whose first element is the vertex element with scalar
+	///   x, y and z properties (other scalar properties are skipped).
+	///
+	/// The points are read from the mapping on demand, the whole vector is built only when 
+	/// points() is called.
+	class PointFile {
+		std::unique_ptr<MappedFile> m_file;
+		mutable std::vector<Eigen::Vector3d> m_points;
+		const char* m_records = nullptr;
+		size_t m_recordSize = 0;
+		size_t m_pointCount = 0;
+		size_t m_offsets[3];
+		ScalarType m_types[3];
+		const char* m_packedVertices = nullptr;
+		ScalarType m_packedType = ScalarType::DOUBLE;
+
+		void readXyz(const std::string & path);
+		void readPly(const std::string & path);
+
+	public:
+		/// Reads the points of the file. Throws std::runtime_error when it is not supported.
+		explicit PointFile(const std::string & path);
+
+		/// Number of the points.
+		size_t size() const { return m_pointCount; }
+
+		/// Reads the point with given index from the file.
+		Eigen::Vector3d point(size_t index) const;
+
+		/// The points, in the order of the file.
+		const std::vector<Eigen::Vector3d> & points() const;
+
+		/// \brief Returns the vertex records of the mapped file when they hold just the x, y and z 
+		/// coordinates of the packedType(), so they can be written out without a conversion. 
+		/// Otherwise returns null.
+		const char* packedVertices() const { return m_packedVertices; }
+		ScalarType packedType() const { return m_packedType; }
+	};
+
+}
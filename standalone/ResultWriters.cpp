@@ -0,0 +1,290 @@
+#include "stdafx.h"
+#include "ResultWriters.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+using Eigen::Vector3d;
+using std::string;
+
+namespace standalone {
+
+	namespace {
+
+		/// Size of the buffer of the output files.
+		const size_t OUTPUT_BUFFER_SIZE = size_t(1) << 20;
+
+		/// Faces of a positively oriented tetrahedron facing outwards (see ITetrahedronSink).
+		const size_t OUTWARD_FACES[4][3] = {
+			{ 1, 2, 3 },
+			{ 0, 3, 2 },
+			{ 0, 1, 3 },
+			{ 0, 2, 1 }
+		};
+
+		/// Width of the element count that is written by ResultWriter::finish().
+		const int COUNT_WIDTH = 20;
+
+		/// Returns the count padded to COUNT_WIDTH characters.
+		string paddedCount(size_t count) {
+			char text[COUNT_WIDTH + 1];
+			std::snprintf(text, sizeof(text), "%*zu", COUNT_WIDTH, count);
+			return text;
+		}
+
+		bool endsWith(const string & text, const string & suffix) {
+			return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+
+
+		// PLY
+		// ===
+
+		class PlyWriter : public ResultWriter {
+			OutputFile m_file;
+			size_t m_faceCount = 0;
+			/// Position of the face count that is written by finish(), or UNKNOWN_COUNT.
+			size_t m_faceCountPosition = UNKNOWN_COUNT;
+
+			void writeFace(size_t v0, size_t v1, size_t v2) {
+				// The record is the vertex count (uchar) and the indices (int).
+				char record[1 + 3 * sizeof(int32_t)];
+				record[0] = 3;
+				int32_t indices[3] = { int32_t(v0), int32_t(v1), int32_t(v2) };
+				std::memcpy(record + 1, indices, sizeof(indices));
+				m_file.write(record, sizeof(record));
+				++m_faceCount;
+			}
+
+		public:
+			PlyWriter(const string & path, const PointFile & points, size_t dimensions)
+				: ResultWriter(points, dimensions), m_file(path)
+			{ }
+
+			virtual void begin(size_t elementCount) override {
+				size_t faceCount = (m_dimensions == 3) ? 4 * elementCount : elementCount;
+
+				// The vertex records of the input are written as they are, when it is possible.
+				bool isPacked = (m_points.packedVertices() != nullptr);
+				const char* type = (isPacked && m_points.packedType() == ScalarType::FLOAT) ? "float" : "double";
+
+				m_file.print("ply\nformat binary_little_endian 1.0\n");
+				m_file.print("element vertex %zu\n", m_points.size());
+				m_file.print("property %s x\nproperty %s y\nproperty %s z\n", type, type, type);
+				if (elementCount == UNKNOWN_COUNT) {
+					m_file.print("element face ");
+					m_faceCountPosition = m_file.position();
+					m_file.print("%s\n", paddedCount(0).c_str());
+				}
+				else {
+					m_file.print("element face %zu\n", faceCount);
+				}
+				m_file.print("property list uchar int vertex_indices\nend_header\n");
+
+				if (isPacked) {
+					size_t scalarSize = (m_points.packedType() == ScalarType::FLOAT) ? sizeof(float) : sizeof(double);
+					m_file.write(m_points.packedVertices(), 3 * scalarSize * m_points.size());
+				}
+				else {
+					for (size_t i = 0; i < m_points.size(); ++i) {
+						Vector3d point = m_points.point(i);
+						m_file.write(point.data(), sizeof(Vector3d));
+					}
+				}
+			}
+
+			virtual void triangle(size_t v0, size_t v1, size_t v2) override {
+				writeFace(v0, v1, v2);
+			}
+
+			virtual void tetrahedron(size_t v0, size_t v1, size_t v2, size_t v3) override {
+				size_t v[4] = { v0, v1, v2, v3 };
+				for (size_t face = 0; face < 4; ++face)
+					writeFace(v[OUTWARD_FACES[face][0]], v[OUTWARD_FACES[face][1]], v[OUTWARD_FACES[face][2]]);
+			}
+
+			virtual void finish() override {
+				if (m_faceCountPosition != UNKNOWN_COUNT)
+					m_file.overwrite(m_faceCountPosition, paddedCount(m_faceCount));
+
+				m_file.close();
+			}
+		};
+
+
+		// OBJ
+		// ===
+
+		class ObjWriter : public ResultWriter {
+			OutputFile m_file;
+
+			void writeFace(size_t v0, size_t v1, size_t v2) {
+				// OBJ indices start with 1.
+				m_file.print("f %zu %zu %zu\n", v0 + 1, v1 + 1, v2 + 1);
+			}
+
+		public:
+			ObjWriter(const string & path, const PointFile & points, size_t dimensions)
+				: ResultWriter(points, dimensions), m_file(path)
+			{ }
+
+			virtual void begin(size_t) override {
+				for (size_t i = 0; i < m_points.size(); ++i) {
+					Vector3d point = m_points.point(i);
+					m_file.print("v %.17g %.17g %.17g\n", point.x(), point.y(), point.z());
+				}
+			}
+
+			virtual void triangle(size_t v0, size_t v1, size_t v2) override {
+				writeFace(v0, v1, v2);
+			}
+
+			virtual void tetrahedron(size_t v0, size_t v1, size_t v2, size_t v3) override {
+				size_t v[4] = { v0, v1, v2, v3 };
+				for (size_t face = 0; face < 4; ++face)
+					writeFace(v[OUTWARD_FACES[face][0]], v[OUTWARD_FACES[face][1]], v[OUTWARD_FACES[face][2]]);
+			}
+
+			virtual void finish() override {
+				m_file.close();
+			}
+		};
+
+
+		// TETGEN
+		// ======
+
+		class TetGenWriter : public ResultWriter {
+			OutputFile m_nodeFile;
+			OutputFile m_elementFile;
+			size_t m_elementIndex = 0;
+			/// Position of the element count that is written by finish(), or UNKNOWN_COUNT.
+			size_t m_elementCountPosition = UNKNOWN_COUNT;
+
+		public:
+			TetGenWriter(const string & basePath, const PointFile & points, size_t dimensions)
+				: ResultWriter(points, dimensions), m_nodeFile(basePath + ".node"), m_elementFile(basePath + ".ele")
+			{ }
+
+			virtual void begin(size_t elementCount) override {
+				// The nodes are numbered from 0, as the input vertices.
+				m_nodeFile.print("%zu %zu 0 0\n", m_points.size(), m_dimensions);
+				for (size_t i = 0; i < m_points.size(); ++i) {
+					Vector3d point = m_points.point(i);
+					if (m_dimensions == 3)
+						m_nodeFile.print("%zu %.17g %.17g %.17g\n", i, point.x(), point.y(), point.z());
+					else
+						m_nodeFile.print("%zu %.17g %.17g\n", i, point.x(), point.y());
+				}
+
+				if (elementCount == UNKNOWN_COUNT) {
+					m_elementCountPosition = m_elementFile.position();
+					m_elementFile.print("%s %zu 0\n", paddedCount(0).c_str(), m_dimensions + 1);
+				}
+				else {
+					m_elementFile.print("%zu %zu 0\n", elementCount, m_dimensions + 1);
+				}
+			}
+
+			virtual void triangle(size_t v0, size_t v1, size_t v2) override {
+				m_elementFile.print("%zu %zu %zu %zu\n", m_elementIndex++, v0, v1, v2);
+			}
+
+			virtual void tetrahedron(size_t v0, size_t v1, size_t v2, size_t v3) override {
+				m_elementFile.print("%zu %zu %zu %zu %zu\n", m_elementIndex++, v0, v1, v2, v3);
+			}
+
+			virtual void finish() override {
+				if (m_elementCountPosition != UNKNOWN_COUNT)
+					m_elementFile.overwrite(m_elementCountPosition, paddedCount(m_elementIndex));
+
+				m_nodeFile.close();
+				m_elementFile.close();
+			}
+		};
+
+	}
+
+
+	// =============================================================================
+	// IMPLEMENTATION
+	// =============================================================================
+
+	const size_t ResultWriter::UNKNOWN_COUNT;
+
+	OutputFile::OutputFile(const string & path)
+		: m_file(std::fopen(path.c_str(), "wb")), m_path(path), m_buffer(OUTPUT_BUFFER_SIZE)
+	{
+		if (m_file == nullptr)
+			throw std::runtime_error("Can not write " + path);
+
+		std::setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+	}
+
+	OutputFile::~OutputFile()
+	{
+		if (m_file != nullptr)
+			std::fclose(m_file);
+	}
+
+	void OutputFile::write(const void* data, size_t size)
+	{
+		if (std::fwrite(data, 1, size, m_file) != size)
+			throw std::runtime_error("Can not write " + m_path);
+	}
+
+	void OutputFile::print(const char* format, ...)
+	{
+		va_list arguments;
+		va_start(arguments, format);
+		int result = std::vfprintf(m_file, format, arguments);
+		va_end(arguments);
+
+		if (result < 0)
+			throw std::runtime_error("Can not write " + m_path);
+	}
+
+	size_t OutputFile::position()
+	{
+		long result = std::ftell(m_file);
+		if (result < 0)
+			throw std::runtime_error("Can not write " + m_path);
+
+		return size_t(result);
+	}
+
+	void OutputFile::overwrite(size_t position, const string & text)
+	{
+		bool isFailed = (std::fflush(m_file) != 0)
+			|| (std::fseek(m_file, long(position), SEEK_SET) != 0)
+			|| (std::fwrite(text.data(), 1, text.size(), m_file) != text.size())
+			|| (std::fseek(m_file, 0, SEEK_END) != 0);
+
+		if (isFailed)
+			throw std::runtime_error("Can not write " + m_path);
+	}
+
+	void OutputFile::close()
+	{
+		bool isFailed = (std::fclose(m_file) != 0);
+		m_file = nullptr;
+
+		if (isFailed)
+			throw std::runtime_error("Can not write " + m_path);
+	}
+
+	std::unique_ptr<ResultWriter> ResultWriter::create(const string & path, const PointFile & points, size_t dimensions)
+	{
+		if (endsWith(path, ".ply"))
+			return std::make_unique<PlyWriter>(path, points, dimensions);
+		if (endsWith(path, ".obj"))
+			return std::make_unique<ObjWriter>(path, points, dimensions);
+		if (endsWith(path, ".node") || endsWith(path, ".ele"))
+			return std::make_unique<TetGenWriter>(path.substr(0, path.rfind('.')), points, dimensions);
+
+		throw std::runtime_error("Unknown format of " + path + " (expected .ply, .obj, .node or .ele)");
+	}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Delaunay2D.h"
+#include "Delaunay3D.h"
+#include "PointReader.h"
+
+namespace standalone {
+
+	/// \brief Output file written through a large buffer. Throws std::runtime_error when it can 
+	/// not be written.
+	class OutputFile {
+		FILE* m_file;
+		std::string m_path;
+		std::vector<char> m_buffer;
+
+	public:
+		explicit OutputFile(const std::string & path);
+		~OutputFile();
+
+		OutputFile(const OutputFile &) = delete;
+		OutputFile & operator=(const OutputFile &) = delete;
+
+		void write(const void* data, size_t size);
+		void print(const char* format, ...);
+
+		/// Number of the bytes written so far.
+		size_t position();
+
+		/// \brief Overwrites the bytes at given position (that were written before) by the text
+		/// and continues writing at the end.
+		void overwrite(size_t position, const std::string & text);
+
+		/// Flushes and closes the file.
+		void close();
+	};
+
+	/// \brief Writes the elements of the triangulation as they are passed from the engine. The 
+	/// header and the vertices are written at the beginning, once the element count is known, 
+	/// so nothing but the vertices is held in memory. Supported are:
+	/// - .ply - binary little-endian PLY, a 3D tetrahedron is written as its 4 outward faces,
+	/// - .obj - Wavefront OBJ, a 3D tetrahedron is written as its 4 outward faces,
+	/// - .node/.ele - TetGen (Triangle in 2D) files, both of them are written.
+	///
+	/// When begin() is passed UNKNOWN_COUNT, the element count is written at the end by finish().
+	class ResultWriter : public delaunay::ITriangleSink, public delaunay::ITetrahedronSink {
+	protected:
+		const PointFile & m_points;
+		/// 2 for triangles, 3 for tetrahedrons.
+		size_t m_dimensions;
+
+		ResultWriter(const PointFile & points, size_t dimensions)
+			: m_points(points), m_dimensions(dimensions)
+		{ }
+
+	public:
+		/// Element count of begin() that is not known in advance.
+		static const size_t UNKNOWN_COUNT = size_t(-1);
+
+		/// \brief Creates the writer of the format given by the extension of the path. Throws 
+		/// std::runtime_error when it is not supported.
+		static std::unique_ptr<ResultWriter> create(const std::string & path, const PointFile & points, size_t dimensions);
+
+		/// Finishes writing of the files.
+		virtual void finish() = 0;
+
+		virtual ~ResultWriter() {}
+	};
+
+}
@@ -0,0 +1,214 @@
+/// Command-line triangulator, built without the 3ds Max SDK (see the Makefile).
+/// \author Jan Bryda
+#include "stdafx.h"
+#include "Delaunay2D.h"
+#include "Delaunay3D.h"
+#include "ParallelBowyerWatson3D.h"
+#include "StreamingDelaunay2D.h"
+#include "ThreadPool.h"
+#include "PointReader.h"
+#include "ResultWriters.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using std::string;
+
+namespace standalone {
+
+	const char* USAGE =
+		"Usage: triangulate [options] INPUT OUTPUT\n"
+		"  INPUT                 .xyz (raw little-endian double triples) or binary .ply points\n"
+		"  OUTPUT                .ply, .obj or .node/.ele (TetGen, both files are written)\n"
+		"  --3d                  computes the 3D tetrahedration (default: 2D triangulation in xy)\n"
+		"  --threads N           threads of the 3D algorithm (default: one per processor)\n"
+		"  --stream              streams the 2D triangulation, the memory is bounded by the active\n"
+		"                        front when the points of the input are spatially coherent\n"
+		"  --cells N             N x N cells of the streaming (default: by the point count)\n"
+		"  --merge D             merges the points within distance D into the first of them, the\n"
+		"                        others are left out of the elements (not with --stream)\n";
+
+	/// Number of the points inserted into the streamed triangulation at once.
+	const size_t STREAM_CHUNK_SIZE = 65536;
+	/// Average number of the points in a cell of the streaming, unless given.
+	const size_t POINTS_PER_CELL = 1000;
+	/// Maximal number of the cells on a side of the streaming grid.
+	const size_t MAX_CELLS_PER_SIDE = 4096;
+
+	/// Settings given on the command line.
+	struct Settings {
+		size_t m_dimensions;
+		size_t m_threadCount;
+		bool m_isStreamed;
+		size_t m_cellsPerSide;
+		double m_mergeDistance;
+		string m_inputPath;
+		string m_outputPath;
+	};
+
+	/// Parses the command line into the settings. Returns false on invalid arguments.
+	bool parseArguments(int argc, char** argv, Settings & settings) {
+		settings.m_dimensions = 2;
+		settings.m_threadCount = 0;
+		settings.m_isStreamed = false;
+		settings.m_cellsPerSide = 0;
+		settings.m_mergeDistance = 0.0;
+
+		std::vector<string> paths;
+		for (int i = 1; i < argc; ++i) {
+			string argument = argv[i];
+			if (argument == "--3d") {
+				settings.m_dimensions = 3;
+			}
+			else if (argument == "--threads" && i + 1 < argc) {
+				settings.m_threadCount = size_t(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (argument == "--stream") {
+				settings.m_isStreamed = true;
+			}
+			else if (argument == "--cells" && i + 1 < argc) {
+				settings.m_cellsPerSide = size_t(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (argument == "--merge" && i + 1 < argc) {
+				settings.m_mergeDistance = std::strtod(argv[++i], nullptr);
+			}
+			else if (argument.compare(0, 2, "--") == 0) {
+				return false;
+			}
+			else {
+				paths.push_back(argument);
+			}
+		}
+
+		bool isMerged = (settings.m_mergeDistance > 0.0);
+		if (paths.size() != 2 || (settings.m_isStreamed && (settings.m_dimensions == 3 || isMerged)))
+			return false;
+
+		settings.m_inputPath = paths[0];
+		settings.m_outputPath = paths[1];
+		return true;
+	}
+
+	/// \brief Streams the 2D triangulation of the input file into the output file, in the manner 
+	/// of spfinalize and spdelaunay2d of Isenburg et al. The first pass over the file counts the 
+	/// points of each cell, the second one inserts them and finalizes each cell after its last 
+	/// point. Returns the times of the passes (as the sort and the insertion phase).
+	delaunay::PhaseTimes runStreamed(const Settings & settings) {
+		using Eigen::Vector3d;
+
+		PointFile points(settings.m_inputPath);
+		std::unique_ptr<ResultWriter> writer = ResultWriter::create(settings.m_outputPath, points, 2);
+		delaunay::ITriangleSink & sink = *writer;
+		delaunay::PhaseClock clock;
+		delaunay::PhaseTimes times = delaunay::PhaseTimes();
+
+		// COUNTING THE POINTS OF THE CELLS
+		// ================================
+
+		Vector3d minCorner = Vector3d::Zero();
+		Vector3d maxCorner = Vector3d::Zero();
+		for (size_t i = 0; i < points.size(); ++i) {
+			Vector3d point = points.point(i);
+			minCorner = (i == 0) ? point : Vector3d(minCorner.cwiseMin(point));
+			maxCorner = (i == 0) ? point : Vector3d(maxCorner.cwiseMax(point));
+		}
+
+		size_t cellsPerSide = settings.m_cellsPerSide;
+		if (cellsPerSide == 0)
+			cellsPerSide = size_t(std::sqrt(double(points.size() / POINTS_PER_CELL)));
+		cellsPerSide = std::min(std::max(cellsPerSide, size_t(1)), MAX_CELLS_PER_SIDE);
+
+		delaunay::StreamingDelaunay2D algorithm(minCorner, maxCorner, cellsPerSide, cellsPerSide, sink);
+
+		std::vector<size_t> remainingPoints(cellsPerSide * cellsPerSide, 0);
+		for (size_t i = 0; i < points.size(); ++i)
+			++remainingPoints[algorithm.cellOf(points.point(i))];
+
+		times.m_sort = clock.lap();
+
+		// INSERTING THE CHUNKS
+		// ====================
+
+		sink.begin(ResultWriter::UNKNOWN_COUNT);
+
+		std::vector<Vector3d> chunk;
+		std::vector<size_t> completedCells;
+		for (size_t first = 0; first < points.size(); first += STREAM_CHUNK_SIZE) {
+			size_t last = std::min(first + STREAM_CHUNK_SIZE, points.size());
+
+			chunk.clear();
+			completedCells.clear();
+			for (size_t i = first; i < last; ++i) {
+				chunk.push_back(points.point(i));
+
+				size_t cell = algorithm.cellOf(chunk.back());
+				if (--remainingPoints[cell] == 0)
+					completedCells.push_back(cell);
+			}
+
+			algorithm.insertPoints(chunk);
+			for (size_t cell : completedCells)
+				algorithm.finalizeCell(cell);
+		}
+
+		algorithm.finish();
+		writer->finish();
+		times.m_insertion = clock.lap();
+
+		std::cerr << "cells " << cellsPerSide << " x " << cellsPerSide << ", peak " 
+			<< algorithm.peakTriangleCount() << " active triangles\n";
+		return times;
+	}
+
+	/// Triangulates the input file into the output file and returns the times of the phases.
+	delaunay::PhaseTimes run(const Settings & settings) {
+		if (settings.m_isStreamed)
+			return runStreamed(settings);
+
+		PointFile points(settings.m_inputPath);
+		std::unique_ptr<ResultWriter> writer = ResultWriter::create(settings.m_outputPath, points, settings.m_dimensions);
+
+		delaunay::PhaseTimes times = delaunay::PhaseTimes();
+		if (settings.m_dimensions == 3) {
+			delaunay::ThreadPool pool(settings.m_threadCount);
+			delaunay::ParallelBowyerWatson3D algorithm(&pool);
+			algorithm.setMergeDistance(settings.m_mergeDistance);
+			algorithm.invokeStreamed(points.points(), *writer);
+			times = algorithm.phaseTimes();
+		}
+		else {
+			delaunay::BowyerWatson2D algorithm;
+			algorithm.setMergeDistance(settings.m_mergeDistance);
+			algorithm.invokeStreamed(points.points(), *writer);
+			times = algorithm.phaseTimes();
+		}
+
+		writer->finish();
+		return times;
+	}
+
+}
+
+
+int main(int argc, char** argv) {
+	using namespace standalone;
+
+	Settings settings;
+	if (parseArguments(argc, argv, settings) == false) {
+		std::cerr << USAGE;
+		return 1;
+	}
+
+	try {
+		delaunay::PhaseTimes times = run(settings);
+		std::cerr << "bounding " << times.m_bounding << " s, sort " << times.m_sort << " s, insertion " << times.m_insertion 
+			<< " s, output " << times.m_conversion << " s\n";
+	}
+	catch (const std::exception & exception) {
+		std::cerr << exception.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
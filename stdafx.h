@@ -5,6 +5,9 @@
 
 // 3ds Max SDK includes
 // ====================
+// The engines can be built without the SDK (see the standalone directory), then only the types 
+// they use are stubbed.
+#ifndef DELAUNAY_STANDALONE
 #include <maxtypes.h>
 #include <point3.h>		// Point3
 #include <tab.h>		// Tab<>
@@ -13,10 +16,17 @@
 #include <iparamm2.h>
 #include <ifnpub.h>		// Function publishing: FPStaticInterface
 #include <utilapi.h>
+#include <notify.h>		// RegisterNotification
+#include <splshape.h>	// SplineShape
+#include <maxscript/maxscript.h>				// value locals
+#include <maxscript/foundation/arrays.h>		// Array
+#include <maxscript/foundation/numbers.h>	// Integer64, Float
+#include <maxscript/foundation/name.h>		// Name
 
 // undef the "min" and "max" macro that is defined in the 3ds Max SDK
 #undef min
 #undef max
+#endif
 
 
 // C++ STD library includes
@@ -30,7 +40,24 @@
 #include <map>
 #include <set>
 #include <array>
+#include <random>
+#include <cstdint>			// uint32_t, uint64_t
+#include <deque>
+#include <functional>		// function
+#include <thread>			// thread
+#include <mutex>			// mutex, lock_guard, unique_lock
+#include <condition_variable>
+#include <atomic>
+#include <exception>		// exception_ptr
+#include <numeric>			// iota
+#include <chrono>			// steady_clock
+#include <queue>			// priority_queue
+#include <stdexcept>		// length_error
+#include <cstring>			// memcpy
 
 
 // Other includes
 // ==============
+#ifdef DELAUNAY_STANDALONE
+#include "standalone/MaxStub.h"	// Mesh, Point3
+#endif